@@ -0,0 +1,40 @@
+#!/bin/sh
+# Times the parse phase on a generated, expression-heavy namespace (taken from --stats, best of several runs).
+# usage: benchmarks/parse_expressions.sh <build_dir> [function_count] [runs]
+
+BUILD_DIR=${1:-build}
+FUNCTIONS=${2:-2000}
+RUNS=${3:-5}
+
+BUILD_DIR=$(cd "$BUILD_DIR" && pwd)
+EUCLASE="$BUILD_DIR/Euclase"
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+awk -v n="$FUNCTIONS" 'BEGIN {
+    print "namespace parse_expressions {"
+    for (i = 0; i < n; i++) {
+        printf "   int f%d(int a, int b, int c) {\n", i
+        printf "       int x = (a + b * c - (a %% 7)) * (b - c) / (c + 1) + a * a - b * b + %d;\n", i
+        printf "       int y = a < b && b <= c || a == c && !(b != %d) ? x * 2 - a : x / 3 + b;\n", i
+        printf "       x += ((a - 1) * (b + 2) - (c * 3 + a) %% 5) * -y;\n"
+        printf "       y = x > y ? x - y * (a + b + c) : y - x * (a - b - c);\n"
+        printf "       return x * y + (a + (b + (c + (a + (b + (c + %d))))));\n", i
+        printf "   }\n"
+    }
+    print "   int main() {"
+    print "       return f0(1, 2, 3);"
+    print "   }"
+    print "}"
+}' > "$WORK_DIR/parse_expressions.ecl"
+
+best=""
+for run in $(seq 1 "$RUNS"); do
+    (cd "$WORK_DIR" && "$EUCLASE" --stats=stats.json parse_expressions.ecl > /dev/null) || { echo "compile failed"; exit 1; }
+    ms=$(sed -n 's/.*"parse": \([0-9.]*\).*/\1/p' "$WORK_DIR/stats.json")
+    best=$(echo "$best $ms" | awk '{ m = $1; for (i = 2; i <= NF; i++) if ($i < m) m = $i; print m }')
+done
+
+nodes=$(sed -n '/"ast_nodes"/,/}/s/.*"total": \([0-9]*\).*/\1/p' "$WORK_DIR/stats.json")
+printf "%d functions, %s AST nodes: parse %s ms (best of %d)\n" "$FUNCTIONS" "$nodes" "$best" "$RUNS"
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Times the parse phase on a generated namespace with many small functions at several --parse-threads
+# counts (taken from --stats, best of several runs) and checks every count builds the same number of nodes.
+# usage: benchmarks/parse_functions.sh <build_dir> [function_count] [runs] [thread_counts]
+
+BUILD_DIR=${1:-build}
+FUNCTIONS=${2:-10000}
+RUNS=${3:-5}
+THREADS=${4:-"1 2 4 8"}
+
+BUILD_DIR=$(cd "$BUILD_DIR" && pwd)
+EUCLASE="$BUILD_DIR/Euclase"
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+awk -v n="$FUNCTIONS" 'BEGIN {
+    print "namespace parse_functions {"
+    for (i = 0; i < n; i++) {
+        printf "   int f%d(int a, int b) {\n", i
+        printf "       int total = 0;\n"
+        printf "       for (int i = 0; i < a; i++) {\n"
+        printf "           if (i %% 3 == 0) { total += i * b; } else { total -= %d; }\n", i
+        printf "       }\n"
+        printf "       while (total > b) { total = total / 2 - a; }\n"
+        printf "       return total > 0 ? total + %d : b - a;\n", i
+        printf "   }\n"
+    }
+    print "   int main() {"
+    print "       return f0(1, 2);"
+    print "   }"
+    print "}"
+}' > "$WORK_DIR/parse_functions.ecl"
+
+reference=""
+for threads in $THREADS; do
+    best=""
+    for run in $(seq 1 "$RUNS"); do
+        (cd "$WORK_DIR" && "$EUCLASE" --parse-threads="$threads" --stats=stats.json parse_functions.ecl > /dev/null) || { echo "compile failed"; exit 1; }
+        ms=$(sed -n 's/.*"parse": \([0-9.]*\).*/\1/p' "$WORK_DIR/stats.json")
+        best=$(echo "$best $ms" | awk '{ m = $1; for (i = 2; i <= NF; i++) if ($i < m) m = $i; print m }')
+    done
+
+    nodes=$(sed -n '/"ast_nodes"/,/}/s/.*"total": \([0-9]*\).*/\1/p' "$WORK_DIR/stats.json")
+    if [ -z "$reference" ]; then
+        reference=$nodes
+    elif [ "$nodes" != "$reference" ]; then
+        echo "$threads threads built $nodes AST nodes, expected $reference"
+        exit 1
+    fi
+    printf "%d functions, %s AST nodes, %s threads: parse %s ms (best of %d)\n" "$FUNCTIONS" "$nodes" "$threads" "$best" "$RUNS"
+done
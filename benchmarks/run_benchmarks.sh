@@ -0,0 +1,31 @@
+#!/bin/sh
+# Compiles every benchmark with Euclase, optimizes it with opt -O2 and times it under lli.
+# usage: benchmarks/run_benchmarks.sh <build_dir> [benchmark_name...]
+
+BUILD_DIR=${1:-build}
+shift 2>/dev/null
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+BUILD_DIR=$(cd "$BUILD_DIR" && pwd)
+EUCLASE="$BUILD_DIR/Euclase"
+RUNTIME="$BUILD_DIR/libEuclaseRuntime.so"
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+if [ $# -eq 0 ]; then
+    set -- $(cd "$BENCH_DIR" && ls *.ecl | sed 's/\.ecl$//')
+fi
+
+for name in "$@"; do
+    cp "$BENCH_DIR/$name.ecl" "$WORK_DIR/"
+    (cd "$WORK_DIR" && "$EUCLASE" "$name.ecl" > /dev/null) || { echo "$name: compile failed"; continue; }
+    opt -O2 -S "$WORK_DIR/$name.ll" -o "$WORK_DIR/$name.opt.ll" || { echo "$name: opt failed"; continue; }
+
+    start=$(date +%s%N)
+    lli -load="$RUNTIME" "$WORK_DIR/$name.opt.ll" > /dev/null
+    status=$?
+    end=$(date +%s%N)
+
+    printf "%-32s %8d ms  (exit %d)\n" "$name" $(( (end - start) / 1000000 )) "$status"
+done
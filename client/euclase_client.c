@@ -0,0 +1,181 @@
+#include "server_protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// thin client for `Euclase --server`, it only moves bytes and writes the result next to the working directory
+
+static void print_usage(void) {
+    fprintf(stderr, "Usage: <socket> [--emit=ir|bc|obj] [--bounds-check] <source_file.ecl> [-o <output>]\n");
+}
+
+static char* read_file(const char* filename, size_t* out_size) {
+    FILE* fptr = fopen(filename, "rb");
+    if (fptr == NULL) {
+        perror(filename);
+        return NULL;
+    }
+
+    fseek(fptr, 0, SEEK_END);
+    long fsize = ftell(fptr);
+    fseek(fptr, 0, SEEK_SET);
+    if (fsize < 0) {
+        fclose(fptr);
+        return NULL;
+    }
+
+    char* data = malloc(fsize + 1);
+    if (data == NULL || fread(data, 1, fsize, fptr) != (size_t)fsize) {
+        free(data);
+        fclose(fptr);
+        return NULL;
+    }
+
+    fclose(fptr);
+    *out_size = (size_t)fsize;
+    return data;
+}
+
+static char* get_module_name(const char* filename) {
+    const char* basename = strrchr(filename, '/');
+    basename = basename != NULL ? basename + 1 : filename;
+
+    const char* last_dot = strrchr(basename, '.');
+    size_t name_len = last_dot != NULL ? (size_t)(last_dot - basename) : strlen(basename);
+
+    char* module_name = malloc(name_len + 1);
+    if (module_name == NULL)
+        return NULL;
+
+    memcpy(module_name, basename, name_len);
+    module_name[name_len] = '\0';
+    return module_name;
+}
+
+static int connect_to_server(const char* socket_path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror(socket_path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    const char* socket_path = argv[1];
+    const char* filename = NULL;
+    const char* output_filename = NULL;
+    uint32_t emit_kind = REQUEST_EMIT_IR;
+    uint32_t flags = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--emit=ir") == 0)
+            emit_kind = REQUEST_EMIT_IR;
+        else if (strcmp(argv[i], "--emit=bc") == 0)
+            emit_kind = REQUEST_EMIT_BITCODE;
+        else if (strcmp(argv[i], "--emit=obj") == 0)
+            emit_kind = REQUEST_EMIT_OBJECT;
+        else if (strcmp(argv[i], "--bounds-check") == 0)
+            flags |= REQUEST_FLAG_BOUNDS_CHECK;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output_filename = argv[++i];
+        else if (argv[i][0] != '-' && filename == NULL)
+            filename = argv[i];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (filename == NULL) {
+        print_usage();
+        return 1;
+    }
+
+    size_t source_length = 0;
+    char* source = read_file(filename, &source_length);
+    char* module_name = get_module_name(filename);
+    if (source == NULL || module_name == NULL || strlen(module_name) == 0 || strlen(module_name) > SERVER_MAX_NAME_LENGTH) {
+        fprintf(stderr, "Error: Could not read '%s'.\n", filename);
+        free(source);
+        free(module_name);
+        return 1;
+    }
+
+    char* default_output = NULL;
+    if (output_filename == NULL) {
+        const char* extensions[] = { ".ll", ".bc", ".o" };
+        default_output = malloc(strlen(module_name) + strlen(".ll") + 1);
+        if (default_output == NULL) {
+            free(source);
+            free(module_name);
+            return 1;
+        }
+        sprintf(default_output, "%s%s", module_name, extensions[emit_kind]);
+        output_filename = default_output;
+    }
+
+    int status = 1;
+    int fd = connect_to_server(socket_path);
+    if (fd >= 0) {
+        CompileRequestHeader request = {
+            .magic = SERVER_PROTOCOL_MAGIC,
+            .emit_kind = emit_kind,
+            .flags = flags,
+            .name_length = (uint32_t)strlen(module_name),
+            .source_length = source_length
+        };
+
+        CompileResponseHeader response;
+        char* payload = NULL;
+
+        if (write_exact(fd, &request, sizeof(request)) && write_exact(fd, module_name, request.name_length)
+            && write_exact(fd, source, source_length) && read_exact(fd, &response, sizeof(response))
+            && response.magic == SERVER_PROTOCOL_MAGIC
+            && (payload = malloc(response.payload_length + 1)) != NULL
+            && read_exact(fd, payload, response.payload_length)) {
+            payload[response.payload_length] = '\0';
+
+            if (response.status == RESPONSE_OK) {
+                FILE* out = fopen(output_filename, "wb");
+                if (out != NULL && fwrite(payload, 1, response.payload_length, out) == response.payload_length)
+                    status = 0;
+                else
+                    perror(output_filename);
+                if (out != NULL)
+                    fclose(out);
+            }
+            else {
+                // server diagnostics already end in a newline, short protocol errors do not
+                size_t length = response.payload_length;
+                fprintf(stderr, "%s%s", payload, length > 0 && payload[length - 1] == '\n' ? "" : "\n");
+            }
+        }
+        else
+            fprintf(stderr, "Error: Lost connection to the compile server.\n");
+
+        free(payload);
+        close(fd);
+    }
+
+    free(default_output);
+    free(module_name);
+    free(source);
+    return status;
+}
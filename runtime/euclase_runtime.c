@@ -0,0 +1,306 @@
+#include "euclase_runtime.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char output_buffer[ECL_RT_OUTPUT_BUFFER_SIZE];
+static size_t output_length = 0;
+static int flush_registered = 0;
+
+static void write_all(const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written <= 0)
+            return;
+
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+void ecl_rt_flush(void) {
+    if (output_length == 0)
+        return;
+
+    write_all(output_buffer, output_length);
+    output_length = 0;
+}
+
+static void ensure_space(size_t length) {
+    if (!flush_registered) {
+        atexit(ecl_rt_flush);
+        flush_registered = 1;
+    }
+
+    if (output_length + length > ECL_RT_OUTPUT_BUFFER_SIZE)
+        ecl_rt_flush();
+}
+
+static void emit_bytes(const char* data, size_t length) {
+    if (length > ECL_RT_OUTPUT_BUFFER_SIZE) {
+        ecl_rt_flush();
+        write_all(data, length);
+        return;
+    }
+
+    ensure_space(length);
+    memcpy(output_buffer + output_length, data, length);
+    output_length += length;
+}
+
+// writes the digits of value right-aligned into the end of buf, returns the digit count
+static int format_u64(uint64_t value, char* buf_end) {
+    static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    char* p = buf_end;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    else {
+        *--p = (char)('0' + value);
+    }
+
+    return (int)(buf_end - p);
+}
+
+void ecl_rt_print_u64(uint64_t value) {
+    char buf[20];
+    int length = format_u64(value, buf + sizeof(buf));
+    emit_bytes(buf + sizeof(buf) - length, length);
+}
+
+void ecl_rt_print_i64(int64_t value) {
+    char buf[21];
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+    int length = format_u64(magnitude, buf + sizeof(buf));
+    if (value < 0)
+        buf[sizeof(buf) - ++length] = '-';
+
+    emit_bytes(buf + sizeof(buf) - length, length);
+}
+
+static void emit_f64_snprintf(double value) {
+    char buf[512];
+    int length = snprintf(buf, sizeof(buf), "%f", value);
+    emit_bytes(buf, length);
+}
+
+#ifndef __SIZEOF_INT128__
+void ecl_rt_print_f64(double value) {
+    emit_f64_snprintf(value);
+}
+#else
+
+#define FRACTION_DIGITS 6
+#define FRACTION_SCALE 1000000
+
+// fraction * 10^6 rounded half to even like printf, fraction is in [0, 1) so it is exactly mantissa / 2^shift
+static uint64_t round_fraction(double fraction) {
+    if (fraction == 0.0)
+        return 0;
+
+    int exponent;
+    uint64_t mantissa = (uint64_t)ldexp(frexp(fraction, &exponent), 53);
+    int shift = 53 - exponent;
+    if (shift >= 128)
+        return 0;
+
+    unsigned __int128 product = (unsigned __int128)mantissa * FRACTION_SCALE;
+    unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+    uint64_t digits = (uint64_t)(product >> shift);
+    unsigned __int128 remainder = product & ((half << 1) - 1);
+
+    if (remainder > half || (remainder == half && (digits & 1)))
+        digits++;
+    return digits;
+}
+
+// same output as printf("%f"), falls back to snprintf once the integer part no longer fits in 53 bits
+void ecl_rt_print_f64(double value) {
+    if (value != value) {
+        emit_bytes(signbit(value) ? "-nan" : "nan", signbit(value) ? 4 : 3);
+        return;
+    }
+
+    double magnitude = value < 0 ? -value : value;
+    if (magnitude >= 9007199254740992.0) {
+        emit_f64_snprintf(value);
+        return;
+    }
+
+    uint64_t integer_part = (uint64_t)magnitude;
+    uint64_t fraction = round_fraction(magnitude - (double)integer_part);
+    if (fraction == FRACTION_SCALE) {
+        fraction = 0;
+        integer_part++;
+    }
+
+    char buf[32];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+
+    for (int i = 0; i < FRACTION_DIGITS; i++) {
+        *--p = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    *--p = '.';
+
+    p -= format_u64(integer_part, p);
+    if (signbit(value))
+        *--p = '-';
+
+    emit_bytes(p, end - p);
+}
+#endif
+
+void ecl_rt_print_char(char value) {
+    ensure_space(1);
+    output_buffer[output_length++] = value;
+}
+
+void ecl_rt_print_str(const char* value) {
+    if (value == NULL) {
+        emit_bytes("(null)", 6);
+        return;
+    }
+
+    emit_bytes(value, strlen(value));
+}
+
+void ecl_rt_print_ptr(const void* value) {
+    static const char hex_digits[] = "0123456789abcdef";
+
+    char buf[18];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+
+    uintptr_t bits = (uintptr_t)value;
+    do {
+        *--p = hex_digits[bits & 0xf];
+        bits >>= 4;
+    } while (bits != 0);
+
+    *--p = 'x';
+    *--p = '0';
+    emit_bytes(p, end - p);
+}
+
+void ecl_rt_print_sep(void) {
+    ecl_rt_print_char(' ');
+}
+
+void ecl_rt_print_newline(void) {
+    ecl_rt_print_char('\n');
+}
+
+// chunks are kept newest first, the newest one is also the largest
+struct EclArenaChunk {
+    EclArenaChunk* next;
+    size_t size;
+    max_align_t data[];
+};
+
+static int arena_add_chunk(EclArena* arena, size_t size) {
+    EclArenaChunk* chunk = malloc(sizeof(EclArenaChunk) + size);
+    if (chunk == NULL)
+        return 0;
+
+    chunk->next = arena->chunks;
+    chunk->size = size;
+    arena->chunks = chunk;
+    arena->cursor = (char*)chunk->data;
+    arena->limit = (char*)chunk->data + size;
+    return 1;
+}
+
+EclArena* ecl_rt_arena_new(int64_t size) {
+    EclArena* arena = malloc(sizeof(EclArena));
+    if (arena == NULL)
+        return NULL;
+
+    arena->chunks = NULL;
+    arena->chunk_size = size > ECL_RT_ARENA_MIN_CHUNK ? (size_t)size : ECL_RT_ARENA_MIN_CHUNK;
+    if (!arena_add_chunk(arena, arena->chunk_size)) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+// only reached when the inline bump in the generated code runs past limit
+void* ecl_rt_arena_alloc_slow(EclArena* arena, int64_t size, int64_t align) {
+    // also keeps the chunk size doubling below from overflowing
+    if (size < 0 || align <= 0 || (uint64_t)size > SIZE_MAX / 4)
+        return NULL;
+
+    size_t needed = (size_t)size + (size_t)align - 1;
+    while (arena->chunk_size < needed)
+        arena->chunk_size *= 2;
+    arena->chunk_size *= 2;
+
+    if (!arena_add_chunk(arena, arena->chunk_size))
+        return NULL;
+
+    uintptr_t start = ((uintptr_t)arena->cursor + (uintptr_t)align - 1) & ~((uintptr_t)align - 1);
+    arena->cursor = (char*)start + size;
+    return (void*)start;
+}
+
+// keeps the newest chunk so a reset arena refills without going back to malloc
+void ecl_rt_arena_reset(EclArena* arena) {
+    if (arena == NULL || arena->chunks == NULL)
+        return;
+
+    EclArenaChunk* chunk = arena->chunks->next;
+    while (chunk != NULL) {
+        EclArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    arena->chunks->next = NULL;
+    arena->cursor = (char*)arena->chunks->data;
+    arena->limit = (char*)arena->chunks->data + arena->chunks->size;
+}
+
+void ecl_rt_arena_free(EclArena* arena) {
+    if (arena == NULL)
+        return;
+
+    EclArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL) {
+        EclArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+// target of --bounds-check traps, buffered output is written first so it is not lost
+void ecl_rt_bounds_fail(void) {
+    ecl_rt_flush();
+    fputs("euclase: array index out of bounds\n", stderr);
+    abort();
+}
@@ -0,0 +1,38 @@
+#ifndef EUCLASE_RUNTIME_H
+#define EUCLASE_RUNTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ECL_RT_OUTPUT_BUFFER_SIZE (1 << 16)
+#define ECL_RT_ARENA_MIN_CHUNK (1 << 12)
+
+typedef struct EclArenaChunk EclArenaChunk;
+
+// generated code bumps cursor towards limit inline, so these two fields must stay first
+typedef struct EclArena {
+    char* cursor;
+    char* limit;
+    EclArenaChunk* chunks;
+    size_t chunk_size;
+} EclArena;
+
+void ecl_rt_print_i64(int64_t value);
+void ecl_rt_print_u64(uint64_t value);
+void ecl_rt_print_f64(double value);
+void ecl_rt_print_char(char value);
+void ecl_rt_print_str(const char* value);
+void ecl_rt_print_ptr(const void* value);
+void ecl_rt_print_sep(void);
+void ecl_rt_print_newline(void);
+
+void ecl_rt_flush(void);
+
+EclArena* ecl_rt_arena_new(int64_t size);
+void* ecl_rt_arena_alloc_slow(EclArena* arena, int64_t size, int64_t align);
+void ecl_rt_arena_reset(EclArena* arena);
+void ecl_rt_arena_free(EclArena* arena);
+
+void ecl_rt_bounds_fail(void);
+
+#endif
@@ -0,0 +1,102 @@
+#include "ast_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+static _Thread_local AstArena* current_ast_arena = NULL;
+
+AstArena* create_ast_arena(void)
+{
+    AstArena* arena = malloc(sizeof(AstArena));
+    if (arena == NULL)
+        return NULL;
+
+    arena->head = NULL;
+    arena->bytes = 0;
+    return arena;
+}
+
+void free_ast_arena(AstArena* arena)
+{
+    if (arena == NULL)
+        return;
+
+    AstArenaBlock* block = arena->head;
+    while (block != NULL) {
+        AstArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+void* ast_arena_alloc(AstArena* arena, size_t size)
+{
+    if (arena == NULL)
+        return NULL;
+
+    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+    AstArenaBlock* block = arena->head;
+    if (block == NULL || block->capacity - block->used < size) {
+        size_t capacity = size > AST_ARENA_BLOCK_SIZE ? size : AST_ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(AstArenaBlock) + capacity);
+        if (block == NULL)
+            return NULL;
+
+        block->next = arena->head;
+        block->used = 0;
+        block->capacity = capacity;
+        arena->head = block;
+    }
+
+    void* memory = block->data + block->used;
+    block->used += size;
+    arena->bytes += size;
+    return memory;
+}
+
+char* ast_arena_copy_string(AstArena* arena, StringView text)
+{
+    char* copy = ast_arena_alloc(arena, text.length + 1);
+    if (copy == NULL)
+        return NULL;
+
+    memcpy(copy, text.data, text.length);
+    copy[text.length] = '\0';
+    return copy;
+}
+
+void merge_ast_arena(AstArena* arena, AstArena* source)
+{
+    if (source->head == NULL)
+        return;
+
+    // the partially used head of arena stays in front so allocation continues there
+    AstArenaBlock* tail = source->head;
+    while (tail->next != NULL)
+        tail = tail->next;
+
+    if (arena->head == NULL)
+        arena->head = source->head;
+    else {
+        tail->next = arena->head->next;
+        arena->head->next = source->head;
+    }
+
+    arena->bytes += source->bytes;
+    source->head = NULL;
+    source->bytes = 0;
+}
+
+AstArena* set_current_ast_arena(AstArena* arena)
+{
+    AstArena* previous = current_ast_arena;
+    current_ast_arena = arena;
+    return previous;
+}
+
+AstArena* get_current_ast_arena(void)
+{
+    return current_ast_arena;
+}
@@ -0,0 +1,33 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include "string_view.h"
+#include <stddef.h>
+
+#define AST_ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct AstArenaBlock {
+    struct AstArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} AstArenaBlock;
+
+// nodes, child lists and names of one program, released all at once with the program
+typedef struct AstArena {
+    AstArenaBlock* head;
+    size_t bytes;
+} AstArena;
+
+AstArena* create_ast_arena(void);
+void free_ast_arena(AstArena* arena);
+void* ast_arena_alloc(AstArena* arena, size_t size);
+char* ast_arena_copy_string(AstArena* arena, StringView text);
+// moves every block of source into arena, source is left empty
+void merge_ast_arena(AstArena* arena, AstArena* source);
+
+// create_*_node allocates from the arena installed on the calling thread, returns the previous one
+AstArena* set_current_ast_arena(AstArena* arena);
+AstArena* get_current_ast_arena(void);
+
+#endif
@@ -1,18 +1,81 @@
 #include "ast_layout.h"
+#include "diagnostics.h"
 #include "parser.h"
+#include "stats.h"
+#include "type_table.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
-ASTNode* create_program_node(char* name, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+#define AST_NODE_SIZE(member) (offsetof(ASTNode, as) + sizeof(((ASTNode*)0)->as.member))
+
+// a node only takes the bytes of its own union member, BREAK and CONTINUE are just the header
+static const size_t ast_node_sizes[AST_NODE_TYPE_COUNT] = {
+    [AST_PROGRAM] = AST_NODE_SIZE(program),
+    [AST_FUNCTION] = AST_NODE_SIZE(function),
+    [AST_BLOCK] = AST_NODE_SIZE(block),
+    [AST_PARAM_LIST] = AST_NODE_SIZE(param),
+    [AST_RETURN] = AST_NODE_SIZE(return_stmt),
+    [AST_VAR_DECL] = AST_NODE_SIZE(var_decl),
+    [AST_ASSIGN] = AST_NODE_SIZE(assign),
+    [AST_IF] = AST_NODE_SIZE(if_stmt),
+    [AST_FOR] = AST_NODE_SIZE(for_stmt),
+    [AST_WHILE] = AST_NODE_SIZE(while_stmt),
+    [AST_BREAK] = offsetof(ASTNode, as),
+    [AST_CONTINUE] = offsetof(ASTNode, as),
+    [AST_IDENTIFIER] = AST_NODE_SIZE(identifier),
+    [AST_STRING_LITERAL] = AST_NODE_SIZE(string_literal),
+    [AST_CHAR_LITERAL] = AST_NODE_SIZE(char_literal),
+    [AST_INT_LITERAL] = AST_NODE_SIZE(int_literal),
+    [AST_FLOAT_LITERAL] = AST_NODE_SIZE(float_literal),
+    [AST_DOUBLE_LITERAL] = AST_NODE_SIZE(double_literal),
+    [AST_EXPRESSION] = offsetof(ASTNode, as),
+    [AST_FUNC_CALL] = AST_NODE_SIZE(func_call),
+    [AST_CAST] = AST_NODE_SIZE(cast),
+    [AST_BINARY_OP] = AST_NODE_SIZE(binary_op),
+    [AST_UNARY_OP] = AST_NODE_SIZE(unary_op),
+    [AST_TERNARY] = AST_NODE_SIZE(ternary),
+    [AST_STRUCT_DECL] = AST_NODE_SIZE(struct_decl),
+    [AST_MEMBER_ACCESS] = AST_NODE_SIZE(member_access),
+    [AST_ARRAY_ACCESS] = AST_NODE_SIZE(array_access),
+    [AST_PRINT] = AST_NODE_SIZE(print),
+    [AST_TYPE] = AST_NODE_SIZE(type_arg)
+};
+
+size_t ast_node_size(ASTNodeType type) {
+    return ast_node_sizes[type];
+}
+
+static ASTNode* allocate_node(ASTNodeType type, uint32_t offset) {
+    ASTNode* node = ast_arena_alloc(get_current_ast_arena(), ast_node_sizes[type]);
+    if (node == NULL)
+        return NULL;
+
+    compile_stats.ast_bytes[type] += ast_node_sizes[type];
+    node->type = type;
+    node->offset = offset;
+    return node;
+}
+
+// a full type table is a parse error, the node is not built rather than left pointing at the zeroed entry
+static int intern_node_type(const TypeInfo* info, TypeId* id) {
+    *id = intern_type(info);
+    if (*id != TYPE_ID_NONE)
+        return 1;
+
+    report_diagnostic("Parse error: too many distinct types, the type table is full\n");
+    return 0;
+}
+
+ASTNode* create_program_node(char* name, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_PROGRAM, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_PROGRAM;
-    node->line = line;
-    node->column = column;
     node->as.program = (ProgramNode) {
         .name = name,
+        .lines = NULL,
+        .arena = NULL,
         .functions = NULL,
         .function_count = 0,
         .structs = NULL,
@@ -24,17 +87,19 @@ ASTNode* create_program_node(char* name, int line, int column) {
     return node;
 }
 
-ASTNode* create_function_node(char* name, TypeInfo return_type, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_function_node(char* name, TypeInfo return_type, int qualifiers, uint32_t offset) {
+    TypeId type_id;
+    if (!intern_node_type(&return_type, &type_id))
+        return NULL;
+
+    ASTNode* node = allocate_node(AST_FUNCTION, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_FUNCTION;
-    node->line = line;
-    node->column = column;
     node->as.function = (FunctionNode) {
         .name = name,
-        .return_type = return_type,
+        .return_type = type_id,
+        .qualifiers = qualifiers,
         .params = NULL,
         .param_count = 0,
         .body = NULL
@@ -43,14 +108,11 @@ ASTNode* create_function_node(char* name, TypeInfo return_type, int line, int co
     return node;
 }
 
-ASTNode* create_block_node(int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_block_node(uint32_t offset) {
+    ASTNode* node = allocate_node(AST_BLOCK, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_BLOCK;
-    node->line = line;
-    node->column = column;
     node->as.block = (BlockNode) {
         .statements = NULL,
         .statement_count = 0
@@ -59,30 +121,28 @@ ASTNode* create_block_node(int line, int column) {
     return node;
 }
 
-ASTNode* create_param_node(char* name, TypeInfo type, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_param_node(char* name, TypeInfo type, uint32_t offset) {
+    TypeId type_id;
+    if (!intern_node_type(&type, &type_id))
+        return NULL;
+
+    ASTNode* node = allocate_node(AST_PARAM_LIST, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_PARAM_LIST;
-    node->line = line;
-    node->column = column;
     node->as.param = (ParamNode) {
         .name = name,
-        .type = type
+        .type = type_id
     };
 
     return node;
 }
 
-ASTNode* create_return_node(ASTNode* value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_return_node(ASTNode* value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_RETURN, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_RETURN;
-    node->line = line;
-    node->column = column;
     node->as.return_stmt = (ReturnNode) {
         .value = value
     };
@@ -90,31 +150,30 @@ ASTNode* create_return_node(ASTNode* value, int line, int column) {
     return node;
 }
 
-ASTNode* create_var_decl_node(char* name, TypeInfo type, ASTNode* initializer, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_var_decl_node(char* name, TypeInfo type, ASTNode* initializer, uint32_t offset) {
+    TypeId type_id;
+    if (!intern_node_type(&type, &type_id))
+        return NULL;
+
+    ASTNode* node = allocate_node(AST_VAR_DECL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_VAR_DECL;
-    node->line = line;
-    node->column = column;
     node->as.var_decl = (VarDeclNode) {
         .name = name,
-        .type = type,
-        .initializer = initializer
+        .type = type_id,
+        .initializer = initializer,
+        .is_exported = 0
     };
 
     return node;
 }
 
-ASTNode* create_assign_node(ASTNode* target, ASTNode* value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_assign_node(ASTNode* target, ASTNode* value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_ASSIGN, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_ASSIGN;
-    node->line = line;
-    node->column = column;
     node->as.assign = (AssignNode) {
         .target = target,
         .value = value
@@ -123,14 +182,21 @@ ASTNode* create_assign_node(ASTNode* target, ASTNode* value, int line, int colum
     return node;
 }
 
-ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_compound_assign_node(BinaryOp op, ASTNode* target, ASTNode* value, uint32_t offset) {
+    ASTNode* node = create_assign_node(target, value, offset);
+    if (node == NULL)
+        return NULL;
+
+    node->as.assign.is_compound = 1;
+    node->as.assign.op = op;
+    return node;
+}
+
+ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_IF, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_IF;
-    node->line = line;
-    node->column = column;
     node->as.if_stmt = (IfNode) {
         .condition = condition,
         .then_branch = then_branch,
@@ -140,48 +206,60 @@ ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_
     return node;
 }
 
-ASTNode* create_for_node(ASTNode* init, ASTNode* condition, ASTNode* increment, ASTNode* body, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_for_node(ASTNode* init, ASTNode* condition, ASTNode* increment, ASTNode* body, LoopHints hints, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_FOR, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_FOR;
-    node->line = line;
-    node->column = column;
     node->as.for_stmt = (ForNode) {
         .init = init,
         .condition = condition,
         .update = increment,
-        .body = body
+        .body = body,
+        .hints = hints,
+        .range = { 0 }
     };
 
     return node;
 }
 
-ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_while_node(ASTNode* condition, ASTNode* body, LoopHints hints, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_WHILE, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_WHILE;
-    node->line = line;
-    node->column = column;
     node->as.while_stmt = (WhileNode) {
         .condition = condition,
-        .body = body
+        .body = body,
+        .hints = hints
     };
 
     return node;
 }
 
-ASTNode* create_identifier_node(char* name, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_break_node(uint32_t offset) {
+    ASTNode* node = allocate_node(AST_BREAK, offset);
+    if (node == NULL)
+        return NULL;
+
+
+    return node;
+}
+
+ASTNode* create_continue_node(uint32_t offset) {
+    ASTNode* node = allocate_node(AST_CONTINUE, offset);
+    if (node == NULL)
+        return NULL;
+
+
+    return node;
+}
+
+ASTNode* create_identifier_node(char* name, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_IDENTIFIER, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_IDENTIFIER;
-    node->line = line;
-    node->column = column;
     node->as.identifier = (IdentifierNode) {
         .name = name
     };
@@ -189,29 +267,24 @@ ASTNode* create_identifier_node(char* name, int line, int column) {
     return node;
 }
 
-ASTNode* create_int_literal_node(long long value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_int_literal_node(long long value, int is_unsigned, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_INT_LITERAL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_INT_LITERAL;
-    node->line = line;
-    node->column = column;
     node->as.int_literal = (IntLiteralNode) {
-        .value = value
+        .value = value,
+        .is_unsigned = is_unsigned
     };
 
     return node;
 }
 
-ASTNode* create_float_literal_node(float value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_float_literal_node(float value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_FLOAT_LITERAL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_FLOAT_LITERAL;
-    node->line = line;
-    node->column = column;
     node->as.float_literal = (FloatLiteralNode) {
         .value = value
     };
@@ -219,14 +292,11 @@ ASTNode* create_float_literal_node(float value, int line, int column) {
     return node;
 }
 
-ASTNode* create_double_literal_node(double value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_double_literal_node(double value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_DOUBLE_LITERAL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_DOUBLE_LITERAL;
-    node->line = line;
-    node->column = column;
     node->as.double_literal = (DoubleLiteralNode) {
         .value = value
     };
@@ -234,14 +304,11 @@ ASTNode* create_double_literal_node(double value, int line, int column) {
     return node;
 }
 
-ASTNode* create_string_literal_node(char* value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_string_literal_node(char* value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_STRING_LITERAL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_STRING_LITERAL;
-    node->line = line;
-    node->column = column;
     node->as.string_literal = (StringLiteralNode) {
         .value = value,
         .length = strlen(value)
@@ -250,14 +317,11 @@ ASTNode* create_string_literal_node(char* value, int line, int column) {
     return node;
 }
 
-ASTNode* create_char_literal_node(char value, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_char_literal_node(char value, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_CHAR_LITERAL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_CHAR_LITERAL;
-    node->line = line;
-    node->column = column;
     node->as.char_literal = (CharLiteralNode) {
         .value = value
     };
@@ -265,14 +329,11 @@ ASTNode* create_char_literal_node(char value, int line, int column) {
     return node;
 }
 
-ASTNode* create_func_call_node(char* name, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_func_call_node(char* name, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_FUNC_CALL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_FUNC_CALL;
-    node->line = line;
-    node->column = column;
     node->as.func_call = (FuncCallNode) {
         .name = name,
         .args = NULL,
@@ -282,14 +343,11 @@ ASTNode* create_func_call_node(char* name, int line, int column) {
     return node;
 }
 
-ASTNode* create_unary_op_node(UnaryOP op, ASTNode* operand, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_unary_op_node(UnaryOP op, ASTNode* operand, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_UNARY_OP, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_UNARY_OP;
-    node->line = line;
-    node->column = column;
     node->as.unary_op = (UnaryOpNode) {
         .op = op,
         .operand = operand
@@ -298,14 +356,11 @@ ASTNode* create_unary_op_node(UnaryOP op, ASTNode* operand, int line, int column
     return node;
 }
 
-ASTNode* create_binary_op_node(BinaryOp op, ASTNode* left, ASTNode* right, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_binary_op_node(BinaryOp op, ASTNode* left, ASTNode* right, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_BINARY_OP, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_BINARY_OP;
-    node->line = line;
-    node->column = column;
     node->as.binary_op = (BinaryOpNode) {
         .op = op,
         .left = left,
@@ -315,30 +370,42 @@ ASTNode* create_binary_op_node(BinaryOp op, ASTNode* left, ASTNode* right, int l
     return node;
 }
 
-ASTNode* create_cast_node(TypeInfo target_type, ASTNode* expr, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_ternary_node(ASTNode* condition, ASTNode* then_expr, ASTNode* else_expr, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_TERNARY, offset);
+    if (node == NULL)
+        return NULL;
+
+    node->as.ternary = (TernaryNode) {
+        .condition = condition,
+        .then_expr = then_expr,
+        .else_expr = else_expr
+    };
+
+    return node;
+}
+
+ASTNode* create_cast_node(TypeInfo target_type, ASTNode* expr, uint32_t offset) {
+    TypeId type_id;
+    if (!intern_node_type(&target_type, &type_id))
+        return NULL;
+
+    ASTNode* node = allocate_node(AST_CAST, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_CAST;
-    node->line = line;
-    node->column = column;
     node->as.cast = (CastNode) {
-        .target_type = target_type,
+        .target_type = type_id,
         .expr = expr
     };
 
     return node;
 }
 
-ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_member_access_node(ASTNode* object, char* member, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_MEMBER_ACCESS, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_MEMBER_ACCESS;
-    node->line = line;
-    node->column = column;
     node->as.member_access = (MemberAccessNode) {
         .object = object,
         .member = member
@@ -347,14 +414,11 @@ ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int
     return node;
 }
 
-ASTNode* create_struct_decl_node(char* type, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_struct_decl_node(char* type, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_STRUCT_DECL, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_STRUCT_DECL;
-    node->line = line;
-    node->column = column;
     node->as.struct_decl = (StructDeclNode) {
         .type = type,
         .members = NULL,
@@ -364,27 +428,22 @@ ASTNode* create_struct_decl_node(char* type, int line, int column) {
     return node;
 }
 
-ASTNode* create_print_node(ASTNode* expr, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_print_node(uint32_t offset) {
+    ASTNode* node = allocate_node(AST_PRINT, offset);
     if (node == NULL)
         return NULL;
 
-    node->type = AST_PRINT;
-    node->line = line;
-    node->column = column;
     node->as.print = (PrintNode) {
-        .expression = expr
+        .expressions = NULL,
+        .expression_count = 0
     };
 
     return node;
 }
 
-ASTNode* create_array_access_node(ASTNode* target, ASTNode* index, int line, int column) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_array_access_node(ASTNode* target, ASTNode* index, uint32_t offset) {
+    ASTNode* node = allocate_node(AST_ARRAY_ACCESS, offset);
     if (node != NULL) {
-        node->type = AST_ARRAY_ACCESS;
-        node->line = line;
-        node->column = column;
         node->as.array_access = (ArrayAcess){
             .target = target,
             .index = index
@@ -394,51 +453,18 @@ ASTNode* create_array_access_node(ASTNode* target, ASTNode* index, int line, int
     return node;
 }
 
-void add_param_to_function(ASTNode* func, ASTNode* param) {
-    if (func == NULL || param == NULL)
-        return;
-
-    func->as.function.params = realloc(func->as.function.params, sizeof(ASTNode*) * (func->as.function.param_count + 1));
-    func->as.function.params[func->as.function.param_count++] = param;
-}
-
-void add_member_to_struct(ASTNode* struct_decl, ASTNode* member) {
-    if (struct_decl == NULL || member == NULL)
-        return;
-    
-    struct_decl->as.struct_decl.members = realloc(struct_decl->as.struct_decl.members, sizeof(ASTNode*) * (struct_decl->as.struct_decl.member_count + 1));
-    struct_decl->as.struct_decl.members[struct_decl->as.struct_decl.member_count++] = member;
-}
-
-void add_arg_to_func_call(ASTNode* func_call, ASTNode* arg) {
-    if (func_call == NULL || arg == NULL) 
-        return;
-
-    func_call->as.func_call.args = realloc(func_call->as.func_call.args, sizeof(ASTNode*) * (func_call->as.func_call.arg_count + 1));
-    func_call->as.func_call.args[func_call->as.func_call.arg_count++] = arg;
-}
-
-void add_function_to_program(ASTNode* program, ASTNode* function)
-{
-    if (program == NULL || function == NULL)
-        return;
+ASTNode* create_type_node(TypeInfo type, uint32_t offset) {
+    TypeId type_id;
+    if (!intern_node_type(&type, &type_id))
+        return NULL;
 
-    program->as.program.functions = realloc(program->as.program.functions, sizeof(ASTNode*) * (program->as.program.function_count + 1));
-    program->as.program.functions[program->as.program.function_count++] = function;
-}
+    ASTNode* node = allocate_node(AST_TYPE, offset);
+    if (node == NULL)
+        return NULL;
 
-void add_struct_to_program(ASTNode* program, ASTNode* struct_decl) {
-    if (program == NULL || struct_decl == NULL)
-        return;
+    node->as.type_arg = (TypeNode) {
+        .type = type_id
+    };
 
-    program->as.program.structs = realloc(program->as.program.structs, sizeof(ASTNode*) * (program->as.program.struct_count + 1));
-    program->as.program.structs[program->as.program.struct_count++] = struct_decl;
+    return node;
 }
-
-void add_global_to_program(ASTNode* program, ASTNode* global) {
-    if (program == NULL || global == NULL)
-        return;
-
-    program->as.program.globals = realloc(program->as.program.globals, sizeof(ASTNode*) * (program->as.program.global_count + 1));
-    program->as.program.globals[program->as.program.global_count++] = global;
-}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define AST_LAYOUT_H
 
 #include "token.h"
+#include "ast_arena.h"
 
 typedef struct ASTNode ASTNode;
 
@@ -16,7 +17,9 @@ typedef enum {
     OP_LT,
     OP_GT,
     OP_LE,
-    OP_GE
+    OP_GE,
+    OP_AND,
+    OP_OR
 } BinaryOp;
 
 typedef enum {
@@ -27,23 +30,42 @@ typedef enum {
     OP_PRE_DEC,
     OP_POST_INC,
     OP_POST_DEC,
+    OP_NOT,
 } UnaryOP;
 
 #define MAX_ARRAY_DIMS 8
+#define MAX_INT_BIT_WIDTH 64
+#define MAX_VECTOR_LANES 64
 
 typedef struct TypeInfo {
     TokenType base_type;
     char* type;
     int pointer_level;
+    int is_unsigned;
+    int bit_width;
+    int vector_width;
+    int is_restrict;
+    int is_const;
 
     int is_array;
     int array_dim_count;
     int array_sizes[MAX_ARRAY_DIMS];
+    // array parameters are passed as a pointer to their first element, array_sizes[0] is kept for analysis (0 when unsized)
+    int is_decayed;
+    // a[static N], callers promise at least array_sizes[0] readable elements
+    int has_static_extent;
 } TypeInfo;
 
+// index into the interned type table, see type_table.h
+typedef uint32_t TypeId;
+
 
 typedef struct {
     char* name;
+    // borrowed from the Tokens the program was parsed from, maps node offsets back to lines
+    const LineTable* lines;
+    // owns every node, child list and name of the program
+    AstArena* arena;
 
     ASTNode** functions;
     int function_count;
@@ -55,9 +77,21 @@ typedef struct {
     int global_count;
 } ProgramNode;
 
+typedef enum {
+    FUNC_QUAL_NONE     = 0,
+    FUNC_QUAL_INLINE   = 1 << 0,
+    FUNC_QUAL_NOINLINE = 1 << 1,
+    FUNC_QUAL_HOT      = 1 << 2,
+    FUNC_QUAL_COLD     = 1 << 3,
+    FUNC_QUAL_PURE     = 1 << 4,
+    FUNC_QUAL_CONST    = 1 << 5,
+    FUNC_QUAL_EXPORT   = 1 << 6
+} FunctionQualifier;
+
 typedef struct {
     char* name;
-    TypeInfo return_type;
+    TypeId return_type;
+    int qualifiers;
 
     ASTNode** params;
     int param_count;
@@ -72,7 +106,7 @@ typedef struct {
 
 typedef struct {
     char* name;
-    TypeInfo type;
+    TypeId type;
 } ParamNode;
 
 typedef struct {
@@ -81,13 +115,17 @@ typedef struct {
 
 typedef struct {
     char* name;
-    TypeInfo type;
+    TypeId type;
+    int is_exported;
     ASTNode* initializer;
 } VarDeclNode;
 
 typedef struct {
     ASTNode* target;
     ASTNode* value;
+    // a += b keeps op and the target is evaluated once, for plain '=' op is unused
+    int is_compound;
+    BinaryOp op;
 } AssignNode;
 
 typedef struct {
@@ -96,16 +134,36 @@ typedef struct {
     ASTNode* else_branch;
 } IfNode;
 
+// 0 leaves the decision to the optimizer
+typedef struct {
+    int unroll_count;
+    int vectorize_width;
+    int interleave_count;
+} LoopHints;
+
+// filled in by the bounds analysis: var counts up from start by step and stays below limit, or below limit_expr when the bound is a loop-invariant variable
+typedef struct {
+    const char* var;
+    long long start;
+    long long step;
+    long long limit;
+    ASTNode* limit_expr;
+    int is_inclusive;
+} InductionRange;
+
 typedef struct {
     ASTNode* init;
     ASTNode* condition;
     ASTNode* update;
     ASTNode* body;
+    LoopHints hints;
+    InductionRange range;
 } ForNode;
 
 typedef struct {
     ASTNode* condition;
     ASTNode* body;
+    LoopHints hints;
 } WhileNode;
 
 typedef struct {
@@ -114,6 +172,7 @@ typedef struct {
 
 typedef struct {
     long long value;
+    int is_unsigned;
 } IntLiteralNode;
 
 typedef struct {
@@ -152,7 +211,13 @@ typedef struct {
 } BinaryOpNode;
 
 typedef struct {
-    TypeInfo target_type;
+    ASTNode* condition;
+    ASTNode* then_expr;
+    ASTNode* else_expr;
+} TernaryNode;
+
+typedef struct {
+    TypeId target_type;
     ASTNode* expr;
 } CastNode;
 
@@ -169,7 +234,8 @@ typedef struct {
 } StructDeclNode;
 
 typedef struct {
-   ASTNode* expression;
+   ASTNode** expressions;
+   int expression_count;
 } PrintNode;
 
 typedef struct {
@@ -177,37 +243,38 @@ typedef struct {
     ASTNode* index;
 } ArrayAcess;
 
-ASTNode* create_program_node(char* name, int line, int column);
-ASTNode* create_function_node(char* name, TypeInfo return_type, int line, int column);
-ASTNode* create_block_node(int line, int column);
-ASTNode* create_param_node(char* name, TypeInfo type, int line, int column);
-ASTNode* create_return_node(ASTNode* value, int line, int column);
-ASTNode* create_var_decl_node(char* name, TypeInfo type, ASTNode* initializer, int line, int column);
-ASTNode* create_assign_node(ASTNode* target, ASTNode* value, int line, int column);
-ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column);
-ASTNode* create_for_node(ASTNode* init, ASTNode* condition, ASTNode* increment, ASTNode* body, int line, int column);
-ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column);
-ASTNode* create_identifier_node(char* name, int line, int column);
-ASTNode* create_int_literal_node(long long value, int line, int column);
-ASTNode* create_float_literal_node(float value, int line, int column);
-ASTNode* create_double_literal_node(double value, int line, int column);
-ASTNode* create_string_literal_node(char* value, int line, int column);
-ASTNode* create_char_literal_node(char value, int line, int column);
-ASTNode* create_func_call_node(char* name, int line, int column);
-ASTNode* create_unary_op_node(UnaryOP op, ASTNode* operand, int line, int column);
-ASTNode* create_binary_op_node(BinaryOp op, ASTNode* left, ASTNode* right, int line, int column);
-ASTNode* create_cast_node(TypeInfo target_type, ASTNode* expr, int line, int column);
-ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column);
-ASTNode* create_struct_decl_node(char* type, int line, int column);
-ASTNode* create_print_node(ASTNode* expr, int line, int column);
-ASTNode* create_array_access_node(ASTNode* target, ASTNode* index, int line, int column);
-
-void add_param_to_function(ASTNode* func, ASTNode* param);
-void add_member_to_struct(ASTNode* struct_decl, ASTNode* member);
-void add_arg_to_func_call(ASTNode* func_call, ASTNode* arg);
-void add_statement_to_block(ASTNode* block, ASTNode* stmt);
-void add_function_to_program(ASTNode* program, ASTNode* function);
-void add_struct_to_program(ASTNode* program, ASTNode* struct_decl);
-void add_global_to_program(ASTNode* program, ASTNode* global);
-
-#endif
\ No newline at end of file
+typedef struct {
+    TypeId type;
+} TypeNode;
+
+ASTNode* create_program_node(char* name, uint32_t offset);
+ASTNode* create_function_node(char* name, TypeInfo return_type, int qualifiers, uint32_t offset);
+ASTNode* create_block_node(uint32_t offset);
+ASTNode* create_param_node(char* name, TypeInfo type, uint32_t offset);
+ASTNode* create_return_node(ASTNode* value, uint32_t offset);
+ASTNode* create_var_decl_node(char* name, TypeInfo type, ASTNode* initializer, uint32_t offset);
+ASTNode* create_assign_node(ASTNode* target, ASTNode* value, uint32_t offset);
+ASTNode* create_compound_assign_node(BinaryOp op, ASTNode* target, ASTNode* value, uint32_t offset);
+ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, uint32_t offset);
+ASTNode* create_for_node(ASTNode* init, ASTNode* condition, ASTNode* increment, ASTNode* body, LoopHints hints, uint32_t offset);
+ASTNode* create_while_node(ASTNode* condition, ASTNode* body, LoopHints hints, uint32_t offset);
+ASTNode* create_break_node(uint32_t offset);
+ASTNode* create_continue_node(uint32_t offset);
+ASTNode* create_identifier_node(char* name, uint32_t offset);
+ASTNode* create_int_literal_node(long long value, int is_unsigned, uint32_t offset);
+ASTNode* create_float_literal_node(float value, uint32_t offset);
+ASTNode* create_double_literal_node(double value, uint32_t offset);
+ASTNode* create_string_literal_node(char* value, uint32_t offset);
+ASTNode* create_char_literal_node(char value, uint32_t offset);
+ASTNode* create_func_call_node(char* name, uint32_t offset);
+ASTNode* create_unary_op_node(UnaryOP op, ASTNode* operand, uint32_t offset);
+ASTNode* create_binary_op_node(BinaryOp op, ASTNode* left, ASTNode* right, uint32_t offset);
+ASTNode* create_ternary_node(ASTNode* condition, ASTNode* then_expr, ASTNode* else_expr, uint32_t offset);
+ASTNode* create_cast_node(TypeInfo target_type, ASTNode* expr, uint32_t offset);
+ASTNode* create_member_access_node(ASTNode* object, char* member, uint32_t offset);
+ASTNode* create_struct_decl_node(char* type, uint32_t offset);
+ASTNode* create_print_node(uint32_t offset);
+ASTNode* create_array_access_node(ASTNode* target, ASTNode* index, uint32_t offset);
+ASTNode* create_type_node(TypeInfo type, uint32_t offset);
+
+#endif
@@ -0,0 +1,252 @@
+#include "bounds_analysis.h"
+#include "type_table.h"
+#include <limits.h>
+#include <string.h>
+
+typedef struct {
+    const char* name;
+    int found;
+} NameQuery;
+
+static int is_named(ASTNode* node, const char* name)
+{
+    return node != NULL && node->type == AST_IDENTIFIER && strcmp(node->as.identifier.name, name) == 0;
+}
+
+// any store to name, or a declaration that shadows it
+static void find_write(ASTNode* node, void* data)
+{
+    NameQuery* query = data;
+    if (node == NULL || query->found)
+        return;
+
+    switch (node->type) {
+        case AST_ASSIGN:
+            query->found = is_named(node->as.assign.target, query->name);
+            break;
+
+        case AST_UNARY_OP:
+            query->found = node->as.unary_op.op != OP_NEG && node->as.unary_op.op != OP_NOT && node->as.unary_op.op != OP_DEREF
+                && is_named(node->as.unary_op.operand, query->name);
+            break;
+
+        case AST_VAR_DECL:
+            query->found = strcmp(node->as.var_decl.name, query->name) == 0;
+            break;
+
+        default:
+            break;
+    }
+
+    visit_ast_children(node, find_write, data);
+}
+
+// once &name exists anywhere in the function a store through a pointer can change it
+static void find_address_taken(ASTNode* node, void* data)
+{
+    NameQuery* query = data;
+    if (node == NULL || query->found)
+        return;
+
+    if (node->type == AST_UNARY_OP && node->as.unary_op.op == OP_ADDR && is_named(node->as.unary_op.operand, query->name)) {
+        query->found = 1;
+        return;
+    }
+
+    visit_ast_children(node, find_address_taken, data);
+}
+
+static void find_declaration(ASTNode* node, void* data)
+{
+    NameQuery* query = data;
+    if (node == NULL || query->found)
+        return;
+
+    if ((node->type == AST_VAR_DECL && strcmp(node->as.var_decl.name, query->name) == 0)
+        || (node->type == AST_PARAM_LIST && strcmp(node->as.param.name, query->name) == 0)) {
+        query->found = 1;
+        return;
+    }
+
+    visit_ast_children(node, find_declaration, data);
+}
+
+static int search(ASTNode* node, AstChildFn finder, const char* name)
+{
+    NameQuery query = { .name = name, .found = 0 };
+    finder(node, &query);
+    return query.found;
+}
+
+static ASTNode* find_global(ASTNode* program, const char* name)
+{
+    for (int i = 0; i < program->as.program.global_count; i++) {
+        ASTNode* global = program->as.program.globals[i];
+        if (global->type == AST_VAR_DECL && strcmp(global->as.var_decl.name, name) == 0)
+            return global;
+    }
+    return NULL;
+}
+
+int match_induction_index(ASTNode* index, const char* var, long long* offset)
+{
+    if (is_named(index, var)) {
+        *offset = 0;
+        return 1;
+    }
+
+    if (index == NULL || index->type != AST_BINARY_OP)
+        return 0;
+
+    ASTNode* left = index->as.binary_op.left;
+    ASTNode* right = index->as.binary_op.right;
+
+    if (index->as.binary_op.op == OP_ADD && is_named(left, var) && right->type == AST_INT_LITERAL) {
+        *offset = right->as.int_literal.value;
+        return 1;
+    }
+    if (index->as.binary_op.op == OP_ADD && is_named(right, var) && left->type == AST_INT_LITERAL) {
+        *offset = left->as.int_literal.value;
+        return 1;
+    }
+    if (index->as.binary_op.op == OP_SUB && is_named(left, var) && right->type == AST_INT_LITERAL) {
+        *offset = -right->as.int_literal.value;
+        return 1;
+    }
+    return 0;
+}
+
+// i++, ++i, i += c and i = i + c with c > 0
+static int match_increasing_update(ASTNode* update, const char* var, long long* step)
+{
+    if (update == NULL)
+        return 0;
+
+    if (update->type == AST_UNARY_OP) {
+        *step = 1;
+        return (update->as.unary_op.op == OP_PRE_INC || update->as.unary_op.op == OP_POST_INC) && is_named(update->as.unary_op.operand, var);
+    }
+
+    if (update->type != AST_ASSIGN || !is_named(update->as.assign.target, var))
+        return 0;
+
+    ASTNode* value = update->as.assign.value;
+    if (update->as.assign.is_compound) {
+        if (update->as.assign.op != OP_ADD || value == NULL || value->type != AST_INT_LITERAL)
+            return 0;
+
+        *step = value->as.int_literal.value;
+        return *step > 0;
+    }
+
+    return value != NULL && value->type == AST_BINARY_OP && value->as.binary_op.op == OP_ADD
+        && match_induction_index(value, var, step) && *step > 0;
+}
+
+// a literal, a const global with a literal initializer, or a local that the loop never writes
+static int match_loop_limit(ASTNode* program, ASTNode* function, ForNode* for_node, ASTNode* bound, InductionRange* range)
+{
+    if (bound->type == AST_INT_LITERAL) {
+        range->limit = bound->as.int_literal.value;
+        return 1;
+    }
+
+    if (bound->type != AST_IDENTIFIER || is_named(bound, range->var))
+        return 0;
+
+    const char* name = bound->as.identifier.name;
+    if (!search(function, find_declaration, name)) {
+        ASTNode* global = find_global(program, name);
+        if (global == NULL || !get_type_info(global->as.var_decl.type)->is_const)
+            return 0;
+
+        ASTNode* init = global->as.var_decl.initializer;
+        if (init == NULL || init->type != AST_INT_LITERAL)
+            return 0;
+
+        range->limit = init->as.int_literal.value;
+        return 1;
+    }
+
+    if (search(for_node->body, find_write, name) || search(function, find_address_taken, name))
+        return 0;
+
+    range->limit_expr = bound;
+    return 1;
+}
+
+static int match_counted_loop(ASTNode* program, ASTNode* function, ForNode* for_node, InductionRange* range)
+{
+    ASTNode* init = for_node->init;
+    if (init == NULL || init->type != AST_VAR_DECL)
+        return 0;
+
+    TypeInfo type = *get_type_info(init->as.var_decl.type);
+    if ((type.base_type != TOK_INT && type.base_type != TOK_UINT) || type.pointer_level > 0 || type.is_array || type.vector_width > 0)
+        return 0;
+    if (type.bit_width != 0 && type.bit_width < 32)
+        return 0;
+
+    ASTNode* start = init->as.var_decl.initializer;
+    if (start == NULL || start->type != AST_INT_LITERAL || start->as.int_literal.value < 0)
+        return 0;
+
+    *range = (InductionRange) { .var = init->as.var_decl.name, .start = start->as.int_literal.value };
+
+    ASTNode* condition = for_node->condition;
+    if (condition == NULL || condition->type != AST_BINARY_OP || !is_named(condition->as.binary_op.left, range->var))
+        return 0;
+    if (condition->as.binary_op.op != OP_LT && condition->as.binary_op.op != OP_LE)
+        return 0;
+    range->is_inclusive = condition->as.binary_op.op == OP_LE;
+
+    if (!match_increasing_update(for_node->update, range->var, &range->step))
+        return 0;
+
+    if (search(for_node->body, find_write, range->var) || search(function, find_address_taken, range->var))
+        return 0;
+
+    if (!match_loop_limit(program, function, for_node, condition->as.binary_op.right, range))
+        return 0;
+
+    // a variable limit is checked once before the loop, which needs a signed counter so a negative limit just skips the loop
+    if (range->limit_expr != NULL)
+        return type.base_type == TOK_INT && !type.is_unsigned;
+
+    // the counter must not wrap before it reaches a literal limit
+    if (range->is_inclusive)
+        range->limit++;
+    return range->limit <= INT_MAX;
+}
+
+typedef struct {
+    ASTNode* program;
+    ASTNode* function;
+} LoopScan;
+
+static void analyze_node(ASTNode* node, void* data)
+{
+    LoopScan* scan = data;
+    if (node == NULL)
+        return;
+
+    if (node->type == AST_FOR) {
+        InductionRange range;
+        if (!match_counted_loop(scan->program, scan->function, &node->as.for_stmt, &range))
+            range = (InductionRange) { 0 };
+        node->as.for_stmt.range = range;
+    }
+
+    visit_ast_children(node, analyze_node, data);
+}
+
+void analyze_counted_loops(ASTNode* program)
+{
+    if (program == NULL || program->type != AST_PROGRAM)
+        return;
+
+    for (int i = 0; i < program->as.program.function_count; i++) {
+        LoopScan scan = { .program = program, .function = program->as.program.functions[i] };
+        analyze_node(scan.function->as.function.body, &scan);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef BOUNDS_ANALYSIS_H
+#define BOUNDS_ANALYSIS_H
+
+#include "parser.h"
+
+// fills ForNode.range for every counted loop so --bounds-check can drop checks on its induction variable
+void analyze_counted_loops(ASTNode* program);
+
+// index is var, var + c or var - c with a literal c
+int match_induction_index(ASTNode* index, const char* var, long long* offset);
+
+#endif
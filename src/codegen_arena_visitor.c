@@ -0,0 +1,215 @@
+#include "codegen_arena_visitor.h"
+#include "codegen_expr_visitor.h"
+#include "codegen_decl_visitor.h"
+#include "diagnostics.h"
+#include "type_table.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// only the leading cursor/limit fields of the runtime EclArena are visible to generated code
+LLVMTypeRef get_arena_type(CodegenContext* ctx) {
+    LLVMTypeRef arena_struct = LLVMGetTypeByName2(ctx->context, ARENA_STRUCT_NAME);
+    if (arena_struct == NULL) {
+        LLVMTypeRef byte_ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+        LLVMTypeRef fields[2] = { byte_ptr, byte_ptr };
+
+        arena_struct = LLVMStructCreateNamed(ctx->context, ARENA_STRUCT_NAME);
+        LLVMStructSetBody(arena_struct, fields, 2, 0);
+    }
+    return LLVMPointerType(arena_struct, 0);
+}
+
+// user functions with the same name shadow the builtins
+int is_arena_builtin(CodegenVisitor* visitor, const char* name) {
+    if (strcmp(name, "arena_new") != 0 && strcmp(name, "arena_alloc") != 0
+        && strcmp(name, "arena_reset") != 0 && strcmp(name, "arena_free") != 0)
+        return 0;
+
+    return LLVMGetNamedFunction(visitor->ctx->module, name) == NULL;
+}
+
+int get_arena_builtin_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out) {
+    FuncCallNode func_call = node->as.func_call;
+    if (!is_arena_builtin(visitor, func_call.name))
+        return 0;
+
+    if (strcmp(func_call.name, "arena_new") == 0) {
+        *out = (TypeInfo) { .base_type = TOK_ARENA, .type = "arena" };
+        return 1;
+    }
+
+    // arena_alloc(a, T, n) is a T*
+    if (strcmp(func_call.name, "arena_alloc") == 0 && func_call.arg_count == 3 && func_call.args[1]->type == AST_TYPE) {
+        *out = *get_type_info(func_call.args[1]->as.type_arg.type);
+        out->pointer_level++;
+        return 1;
+    }
+
+    return 0;
+}
+
+static LLVMValueRef visit_arena_operand(CodegenVisitor* visitor, ASTNode* node, const char* builtin) {
+    LLVMValueRef arena = visit_expression(visitor, node);
+    if (arena == NULL || LLVMTypeOf(arena) != get_arena_type(visitor->ctx)) {
+        report_diagnostic("Codegen: %s expects an arena\n", builtin);
+        return NULL;
+    }
+    return arena;
+}
+
+static LLVMValueRef visit_arena_new(CodegenVisitor* visitor, FuncCallNode func_call) {
+    if (func_call.arg_count != 1) {
+        report_diagnostic("Codegen: arena_new expects (size)\n");
+        return NULL;
+    }
+
+    LLVMValueRef size = visit_expression(visitor, func_call.args[0]);
+    if (size == NULL || LLVMGetTypeKind(LLVMTypeOf(size)) != LLVMIntegerTypeKind) {
+        report_diagnostic("Codegen: arena_new expects an integer size\n");
+        return NULL;
+    }
+
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(visitor->ctx->context);
+    size = generate_cast_instruction(visitor, size, LLVMTypeOf(size), i64, is_unsigned_expr(visitor, func_call.args[0]), 0, "arena_size");
+
+    LLVMTypeRef arena_type = get_arena_type(visitor->ctx);
+    LLVMValueRef func = get_runtime_func(visitor->ctx, "ecl_rt_arena_new", arena_type, &i64, 1);
+    return LLVMBuildCall2(visitor->ctx->builder, LLVMGlobalGetValueType(func), func, &size, 1, "arena");
+}
+
+static LLVMValueRef visit_arena_release(CodegenVisitor* visitor, FuncCallNode func_call, const char* runtime_name) {
+    if (func_call.arg_count != 1) {
+        report_diagnostic("Codegen: %s expects (arena)\n", func_call.name);
+        return NULL;
+    }
+
+    LLVMValueRef arena = visit_arena_operand(visitor, func_call.args[0], func_call.name);
+    if (arena == NULL)
+        return NULL;
+
+    LLVMTypeRef arena_type = get_arena_type(visitor->ctx);
+    LLVMValueRef func = get_runtime_func(visitor->ctx, runtime_name, LLVMVoidTypeInContext(visitor->ctx->context), &arena_type, 1);
+    return LLVMBuildCall2(visitor->ctx->builder, LLVMGlobalGetValueType(func), func, &arena, 1, "");
+}
+
+static LLVMValueRef get_arena_slow_path(CodegenVisitor* visitor) {
+    LLVMValueRef func = LLVMGetNamedFunction(visitor->ctx->module, "ecl_rt_arena_alloc_slow");
+    if (func != NULL)
+        return func;
+
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(visitor->ctx->context);
+    LLVMTypeRef byte_ptr = LLVMPointerType(LLVMInt8TypeInContext(visitor->ctx->context), 0);
+    LLVMTypeRef param_types[3] = { get_arena_type(visitor->ctx), i64, i64 };
+
+    func = get_runtime_func(visitor->ctx, "ecl_rt_arena_alloc_slow", byte_ptr, param_types, 3);
+    add_function_attribute(visitor, func, "cold", 0);
+    add_function_attribute(visitor, func, "noinline", 0);
+    return func;
+}
+
+// bumps cursor inline and only calls into the runtime when the current chunk cannot hold the request
+static LLVMValueRef visit_arena_alloc(CodegenVisitor* visitor, FuncCallNode func_call) {
+    if (func_call.arg_count != 3 || func_call.args[1]->type != AST_TYPE) {
+        report_diagnostic("Codegen: arena_alloc expects (arena, type, count)\n");
+        return NULL;
+    }
+
+    CodegenContext* ctx = visitor->ctx;
+    LLVMBuilderRef builder = ctx->builder;
+
+    LLVMValueRef arena = visit_arena_operand(visitor, func_call.args[0], "arena_alloc");
+    if (arena == NULL)
+        return NULL;
+
+    TypeId elem_id = func_call.args[1]->as.type_arg.type;
+    LLVMTypeRef elem_type = get_llvm_type(ctx, elem_id);
+    if (elem_type == NULL || LLVMGetTypeKind(elem_type) == LLVMVoidTypeKind) {
+        report_diagnostic("Codegen: arena_alloc expects a sized element type\n");
+        return NULL;
+    }
+
+    LLVMValueRef count = visit_expression(visitor, func_call.args[2]);
+    if (count == NULL || LLVMGetTypeKind(LLVMTypeOf(count)) != LLVMIntegerTypeKind) {
+        report_diagnostic("Codegen: arena_alloc expects an integer count\n");
+        return NULL;
+    }
+
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ctx->context);
+    LLVMTypeRef i8 = LLVMInt8TypeInContext(ctx->context);
+    LLVMTypeRef byte_ptr = LLVMPointerType(i8, 0);
+
+    unsigned long long elem_size = get_type_size(ctx, elem_id);
+    unsigned long long align = get_type_alignment(ctx, elem_id);
+
+    count = generate_cast_instruction(visitor, count, LLVMTypeOf(count), i64, is_unsigned_expr(visitor, func_call.args[2]), 0, "arena_count");
+
+    // one unsigned compare rejects both a negative count and a byte size past INT64_MAX
+    unsigned long long max_count = elem_size > 0 ? (unsigned long long)INT64_MAX / elem_size : (unsigned long long)INT64_MAX;
+    LLVMValueRef count_ok = LLVMBuildICmp(builder, LLVMIntULE, count, LLVMConstInt(i64, max_count, 0), "arena_count_ok");
+    LLVMValueRef size = LLVMBuildMul(builder, count, LLVMConstInt(i64, elem_size, 0), "arena_bytes");
+
+    LLVMTypeRef arena_struct = LLVMGetElementType(get_arena_type(ctx));
+    LLVMValueRef cursor_ptr = LLVMBuildStructGEP2(builder, arena_struct, arena, 0, "cursor_ptr");
+    LLVMValueRef limit_ptr = LLVMBuildStructGEP2(builder, arena_struct, arena, 1, "limit_ptr");
+    LLVMValueRef cursor = LLVMBuildLoad2(builder, byte_ptr, cursor_ptr, "cursor");
+    LLVMValueRef limit = LLVMBuildLoad2(builder, byte_ptr, limit_ptr, "limit");
+
+    LLVMValueRef cursor_addr = LLVMBuildPtrToInt(builder, cursor, i64, "cursor_addr");
+    LLVMValueRef remaining = LLVMBuildSub(builder, LLVMBuildPtrToInt(builder, limit, i64, "limit_addr"), cursor_addr, "arena_remaining");
+
+    // the start is rounded up with a byte offset rather than an inttoptr so it keeps the chunk's provenance
+    LLVMValueRef start = cursor;
+    LLVMValueRef needed = size;
+    if (align > 1) {
+        LLVMValueRef padding = LLVMBuildAnd(builder, LLVMBuildNeg(builder, cursor_addr, "neg_addr"), LLVMConstInt(i64, align - 1, 0), "padding");
+        start = LLVMBuildGEP2(builder, i8, cursor, &padding, 1, "aligned");
+        needed = LLVMBuildAdd(builder, size, padding, "arena_needed");
+    }
+
+    // compared as byte counts so the end pointer is only formed once it is known to stay inside the chunk
+    LLVMValueRef fits = LLVMBuildAnd(builder, count_ok, LLVMBuildICmp(builder, LLVMIntULE, needed, remaining, "arena_room"), "fits");
+
+    LLVMBasicBlockRef fastBB = LLVMAppendBasicBlockInContext(ctx->context, ctx->current_function, "arena_fast");
+    LLVMBasicBlockRef slowBB = LLVMAppendBasicBlockInContext(ctx->context, ctx->current_function, "arena_slow");
+    LLVMBasicBlockRef mergeBB = LLVMAppendBasicBlockInContext(ctx->context, ctx->current_function, "arena_merge");
+
+    LLVMValueRef branch = LLVMBuildCondBr(builder, fits, fastBB, slowBB);
+    set_branch_weights(visitor, branch, ARENA_FAST_PATH_WEIGHT, ARENA_SLOW_PATH_WEIGHT);
+
+    LLVMPositionBuilderAtEnd(builder, fastBB);
+    LLVMValueRef end = LLVMBuildInBoundsGEP2(builder, i8, start, &size, 1, "arena_end");
+    LLVMBuildStore(builder, end, cursor_ptr);
+    LLVMBuildBr(builder, mergeBB);
+
+    LLVMPositionBuilderAtEnd(builder, slowBB);
+    LLVMValueRef slow_path = get_arena_slow_path(visitor);
+    // an invalid count reaches the runtime as a negative size, which it answers with NULL
+    LLVMValueRef slow_size = LLVMBuildSelect(builder, count_ok, size, LLVMConstInt(i64, (unsigned long long)-1, 1), "arena_request");
+    LLVMValueRef slow_args[3] = { arena, slow_size, LLVMConstInt(i64, align, 0) };
+    LLVMValueRef slow_result = LLVMBuildCall2(builder, LLVMGlobalGetValueType(slow_path), slow_path, slow_args, 3, "arena_refill");
+    LLVMBuildBr(builder, mergeBB);
+
+    LLVMPositionBuilderAtEnd(builder, mergeBB);
+    LLVMValueRef phi = LLVMBuildPhi(builder, byte_ptr, "arena_ptr");
+    LLVMValueRef incoming_values[2] = { start, slow_result };
+    LLVMBasicBlockRef incoming_blocks[2] = { fastBB, slowBB };
+    LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
+
+    return LLVMBuildBitCast(builder, phi, LLVMPointerType(elem_type, 0), "arena_alloc");
+}
+
+LLVMValueRef visit_arena_builtin(CodegenVisitor* visitor, ASTNode* node) {
+    FuncCallNode func_call = node->as.func_call;
+
+    if (strcmp(func_call.name, "arena_new") == 0)
+        return visit_arena_new(visitor, func_call);
+    if (strcmp(func_call.name, "arena_alloc") == 0)
+        return visit_arena_alloc(visitor, func_call);
+    if (strcmp(func_call.name, "arena_reset") == 0)
+        return visit_arena_release(visitor, func_call, "ecl_rt_arena_reset");
+    if (strcmp(func_call.name, "arena_free") == 0)
+        return visit_arena_release(visitor, func_call, "ecl_rt_arena_free");
+
+    return NULL;
+}
@@ -0,0 +1,17 @@
+#ifndef CODEGEN_ARENA_VISITOR_H
+#define CODEGEN_ARENA_VISITOR_H
+
+#include "codegen_visitor.h"
+
+#define ARENA_STRUCT_NAME "ecl_arena"
+
+// weights for the bump-pointer check, the runtime slow path only runs when a chunk is exhausted
+#define ARENA_FAST_PATH_WEIGHT 2000
+#define ARENA_SLOW_PATH_WEIGHT 1
+
+LLVMTypeRef get_arena_type(CodegenContext* ctx);
+int is_arena_builtin(CodegenVisitor* visitor, const char* name);
+int get_arena_builtin_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out);
+LLVMValueRef visit_arena_builtin(CodegenVisitor* visitor, ASTNode* node);
+
+#endif
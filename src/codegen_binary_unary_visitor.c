@@ -1,4 +1,7 @@
 #include "codegen_expr_visitor.h"
+#include "codegen_binary_unary_visitor.h"
+#include "codegen_vector_visitor.h"
+#include "diagnostics.h"
 #include <stdio.h>
 
 int does_type_kind_match(LLVMValueRef left, LLVMValueRef right, LLVMTypeKind* out_kind) {
@@ -19,6 +22,97 @@ int does_type_kind_match(LLVMValueRef left, LLVMValueRef right, LLVMTypeKind* ou
     return 0;
 }
 
+// conditions are i1, other scalars compare against zero and vectors become lane masks
+LLVMValueRef build_truth_value(CodegenVisitor* visitor, LLVMValueRef value)
+{
+    if (value == NULL)
+        return NULL;
+
+    LLVMTypeRef type = LLVMTypeOf(value);
+    LLVMTypeRef scalar_type = type;
+    if (LLVMGetTypeKind(type) == LLVMVectorTypeKind)
+        scalar_type = LLVMGetElementType(type);
+
+    switch (LLVMGetTypeKind(scalar_type)) {
+        case LLVMIntegerTypeKind:
+            if (LLVMGetIntTypeWidth(scalar_type) == 1)
+                return value;
+            return LLVMBuildICmp(visitor->ctx->builder, LLVMIntNE, value, LLVMConstNull(type), "tobool");
+
+        case LLVMFloatTypeKind:
+        case LLVMDoubleTypeKind:
+            return LLVMBuildFCmp(visitor->ctx->builder, LLVMRealUNE, value, LLVMConstNull(type), "tobool");
+
+        case LLVMPointerTypeKind:
+            return LLVMBuildIsNotNull(visitor->ctx->builder, value, "tobool");
+
+        default:
+            report_diagnostic("Codegen: Expression cannot be used as a condition\n");
+            return NULL;
+    }
+}
+
+static LLVMValueRef build_scalar_condition(CodegenVisitor* visitor, ASTNode* node)
+{
+    LLVMValueRef condition = build_truth_value(visitor, visit_expression(visitor, node));
+    if (condition != NULL && LLVMGetTypeKind(LLVMTypeOf(condition)) == LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: Logical operators need scalar operands\n");
+        return NULL;
+    }
+    return condition;
+}
+
+// the right operand only runs when the left one does not already decide the result
+LLVMValueRef visit_logical_op(CodegenVisitor* visitor, BinaryOpNode node)
+{
+    LLVMBuilderRef builder = visitor->ctx->builder;
+    int is_and = node.op == OP_AND;
+
+    LLVMValueRef left = build_scalar_condition(visitor, node.left);
+    if (left == NULL)
+        return NULL;
+
+    LLVMBasicBlockRef left_end = LLVMGetInsertBlock(builder);
+    LLVMBasicBlockRef rhsBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, is_and ? "and_rhs" : "or_rhs");
+    LLVMBasicBlockRef mergeBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, is_and ? "and_merge" : "or_merge");
+
+    if (is_and)
+        LLVMBuildCondBr(builder, left, rhsBB, mergeBB);
+    else
+        LLVMBuildCondBr(builder, left, mergeBB, rhsBB);
+
+    LLVMPositionBuilderAtEnd(builder, rhsBB);
+    LLVMValueRef right = build_scalar_condition(visitor, node.right);
+    if (right == NULL)
+        return NULL;
+
+    LLVMBasicBlockRef right_end = LLVMGetInsertBlock(builder);
+    LLVMBuildBr(builder, mergeBB);
+
+    LLVMPositionBuilderAtEnd(builder, mergeBB);
+    LLVMValueRef phi = LLVMBuildPhi(builder, LLVMInt1TypeInContext(visitor->ctx->context), is_and ? "and" : "or");
+
+    LLVMValueRef incoming_values[2] = { LLVMConstInt(LLVMInt1TypeInContext(visitor->ctx->context), !is_and, 0), right };
+    LLVMBasicBlockRef incoming_blocks[2] = { left_end, right_end };
+    LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
+
+    return phi;
+}
+
+// mixed-width operands are extended to the wider width, each according to its own signedness
+void widen_integer_operands(CodegenVisitor* visitor, LLVMValueRef* left, int left_unsigned, LLVMValueRef* right, int right_unsigned) {
+    LLVMTypeRef left_type = LLVMTypeOf(*left);
+    LLVMTypeRef right_type = LLVMTypeOf(*right);
+
+    unsigned left_width = LLVMGetIntTypeWidth(left_type);
+    unsigned right_width = LLVMGetIntTypeWidth(right_type);
+
+    if (left_width < right_width)
+        *left = generate_cast_instruction(visitor, *left, left_type, right_type, left_unsigned, 0, "widen");
+    else if (right_width < left_width)
+        *right = generate_cast_instruction(visitor, *right, right_type, left_type, right_unsigned, 0, "widen");
+}
+
 LLVMValueRef build_addition(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFAdd(visitor->ctx->builder, left, right, "fadd");
@@ -40,16 +134,20 @@ LLVMValueRef build_multiplication(CodegenVisitor* visitor, LLVMValueRef left, LL
         return LLVMBuildMul(visitor->ctx->builder, left, right, "mul");
 }
 
-LLVMValueRef build_division(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_division(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFDiv(visitor->ctx->builder, left, right, "fdiv");
+    else if (is_unsigned)
+        return LLVMBuildUDiv(visitor->ctx->builder, left, right, "udiv");
     else
         return LLVMBuildSDiv(visitor->ctx->builder, left, right, "sdiv");
 }
 
-LLVMValueRef build_modulo(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_modulo(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFRem(visitor->ctx->builder, left, right, "frem");
+    else if (is_unsigned)
+        return LLVMBuildURem(visitor->ctx->builder, left, right, "urem");
     else
         return LLVMBuildSRem(visitor->ctx->builder, left, right, "srem");
 }
@@ -61,64 +159,89 @@ LLVMValueRef build_compare(CodegenVisitor* visitor, LLVMValueRef left, LLVMValue
         return LLVMBuildICmp(visitor->ctx->builder, is_not_equal ? LLVMIntNE : LLVMIntEQ, left, right, "icmp");
 }
 
-LLVMValueRef build_greater(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_greater(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFCmp(visitor->ctx->builder, LLVMRealOGT, left, right, "fgr");
     else
-        return LLVMBuildICmp(visitor->ctx->builder, LLVMIntSGT, left, right, "lgr");
+        return LLVMBuildICmp(visitor->ctx->builder, is_unsigned ? LLVMIntUGT : LLVMIntSGT, left, right, is_unsigned ? "ugr" : "lgr");
 }
 
-LLVMValueRef build_less(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_less(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFCmp(visitor->ctx->builder, LLVMRealOLT, left, right, "flt");
     else
-        return LLVMBuildICmp(visitor->ctx->builder, LLVMIntSLT, left, right, "llt");
+        return LLVMBuildICmp(visitor->ctx->builder, is_unsigned ? LLVMIntULT : LLVMIntSLT, left, right, is_unsigned ? "ult" : "llt");
 }
 
-LLVMValueRef build_less_equal(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_less_equal(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFCmp(visitor->ctx->builder, LLVMRealOLE, left, right, "fle");
     else
-        return LLVMBuildICmp(visitor->ctx->builder, LLVMIntSLE, left, right, "lle");
+        return LLVMBuildICmp(visitor->ctx->builder, is_unsigned ? LLVMIntULE : LLVMIntSLE, left, right, is_unsigned ? "ule" : "lle");
 }
 
-LLVMValueRef build_greater_equal(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type) {
+LLVMValueRef build_greater_equal(CodegenVisitor* visitor, LLVMValueRef left, LLVMValueRef right, LLVMTypeKind type, int is_unsigned) {
     if (type == LLVMFloatTypeKind || type == LLVMDoubleTypeKind)
         return LLVMBuildFCmp(visitor->ctx->builder, LLVMRealOGE, left, right, "fge");
     else
-        return LLVMBuildICmp(visitor->ctx->builder, LLVMIntSGE, left, right, "lle");
+        return LLVMBuildICmp(visitor->ctx->builder, is_unsigned ? LLVMIntUGE : LLVMIntSGE, left, right, is_unsigned ? "uge" : "lle");
 }
 
-LLVMValueRef visit_binary_op_expr(CodegenVisitor* visitor, ASTNode* node)
+// arithmetic and comparisons on operands that are already evaluated, compound assignments share it
+LLVMValueRef build_binary_values(CodegenVisitor* visitor, BinaryOp op, LLVMValueRef left, int left_unsigned, LLVMValueRef right, int right_unsigned)
 {
-    BinaryOpNode binary_node = node->as.binary_op;
-
-    LLVMValueRef left = visit_expression(visitor, binary_node.left);
-    LLVMValueRef right = visit_expression(visitor, binary_node.right);
+    int is_unsigned = left_unsigned || right_unsigned;
 
-    if (left == NULL || right == NULL) 
-        return NULL;
+    splat_scalar_operand(visitor, &left, left_unsigned, &right, right_unsigned);
 
     LLVMTypeKind type;
     if (!does_type_kind_match(left, right, &type))
         return NULL;
 
-    switch (binary_node.op) {
+    // vectors go through the same helpers, the lane type picks the instruction
+    if (type == LLVMVectorTypeKind) {
+        if (LLVMTypeOf(left) != LLVMTypeOf(right)) {
+            report_diagnostic("Codegen: Mismatched vector operand types\n");
+            return NULL;
+        }
+        type = LLVMGetTypeKind(LLVMGetElementType(LLVMTypeOf(left)));
+    }
+
+    if (type == LLVMIntegerTypeKind)
+        widen_integer_operands(visitor, &left, left_unsigned, &right, right_unsigned);
+
+    switch (op) {
         case OP_ADD: return build_addition(visitor, left, right, type);
         case OP_SUB: return build_subtraction(visitor, left, right, type);
         case OP_MUL: return build_multiplication(visitor, left, right, type);
-        case OP_DIV: return build_division(visitor, left, right, type);
-        case OP_MOD: return build_modulo(visitor, left, right, type);
+        case OP_DIV: return build_division(visitor, left, right, type, is_unsigned);
+        case OP_MOD: return build_modulo(visitor, left, right, type, is_unsigned);
         case OP_EQ:  return build_compare(visitor, left, right, type, 0);
         case OP_NE:  return build_compare(visitor, left, right, type, 1);
-        case OP_LT:  return build_less(visitor, left, right, type);
-        case OP_GT:  return build_greater(visitor, left, right, type);
-        case OP_LE:  return build_less_equal(visitor, left, right, type);
-        case OP_GE:  return build_greater_equal(visitor, left, right, type);
+        case OP_LT:  return build_less(visitor, left, right, type, is_unsigned);
+        case OP_GT:  return build_greater(visitor, left, right, type, is_unsigned);
+        case OP_LE:  return build_less_equal(visitor, left, right, type, is_unsigned);
+        case OP_GE:  return build_greater_equal(visitor, left, right, type, is_unsigned);
         default:     return NULL;
     }
 }
 
+LLVMValueRef visit_binary_op_expr(CodegenVisitor* visitor, ASTNode* node)
+{
+    BinaryOpNode binary_node = node->as.binary_op;
+    if (binary_node.op == OP_AND || binary_node.op == OP_OR)
+        return visit_logical_op(visitor, binary_node);
+
+    LLVMValueRef left = visit_expression(visitor, binary_node.left);
+    LLVMValueRef right = visit_expression(visitor, binary_node.right);
+
+    if (left == NULL || right == NULL) 
+        return NULL;
+
+    return build_binary_values(visitor, binary_node.op, left, is_unsigned_expr(visitor, binary_node.left),
+        right, is_unsigned_expr(visitor, binary_node.right));
+}
+
 LLVMValueRef visit_negation(CodegenVisitor* visitor, UnaryOpNode node)
 {
     LLVMValueRef expression = visit_expression(visitor, node.operand);
@@ -127,6 +250,8 @@ LLVMValueRef visit_negation(CodegenVisitor* visitor, UnaryOpNode node)
 
     LLVMTypeRef type = LLVMTypeOf(expression);
     LLVMTypeKind type_kind = LLVMGetTypeKind(type);
+    if (type_kind == LLVMVectorTypeKind)
+        type_kind = LLVMGetTypeKind(LLVMGetElementType(type));
 
     if (type_kind == LLVMFloatTypeKind || type_kind == LLVMDoubleTypeKind)
         return LLVMBuildFNeg(visitor->ctx->builder, expression, "fneg");
@@ -136,6 +261,15 @@ LLVMValueRef visit_negation(CodegenVisitor* visitor, UnaryOpNode node)
     return NULL;
 }
 
+LLVMValueRef visit_logical_not(CodegenVisitor* visitor, UnaryOpNode node)
+{
+    LLVMValueRef condition = build_truth_value(visitor, visit_expression(visitor, node.operand));
+    if (condition == NULL)
+        return NULL;
+
+    return LLVMBuildNot(visitor->ctx->builder, condition, "not");
+}
+
 LLVMValueRef visit_address_of(CodegenVisitor* visitor, UnaryOpNode node)
 {
     ASTNode* addressed_node = node.operand;
@@ -165,8 +299,8 @@ LLVMValueRef visit_dereference(CodegenVisitor* visitor, UnaryOpNode node)
     if (alloca == NULL)
         return NULL;
 
-    if (var_data.type.pointer_level <= 0) {
-        printf("Codegen: Cannot dereference non-pointer variable '%s'\n", ptr_expr->as.identifier.name);
+    if (get_type_info(var_data.type)->pointer_level <= 0) {
+        report_diagnostic("Codegen: Cannot dereference non-pointer variable '%s'\n", ptr_expr->as.identifier.name);
         return NULL;
     }
 
@@ -176,12 +310,13 @@ LLVMValueRef visit_dereference(CodegenVisitor* visitor, UnaryOpNode node)
     else
         ptr_val = LLVMBuildLoad2(visitor->ctx->builder, LLVMGetAllocatedType(alloca), alloca, "ptr_load");
 
-    LLVMTypeRef pointed_type = token_type_to_llvm_type(visitor->ctx, var_data.type.base_type);
-    for (int j = 0; j < var_data.type.pointer_level - 1; j++) {
-        pointed_type = LLVMPointerType(pointed_type, 0);
-    }
+    TypeInfo pointed_info = *get_type_info(var_data.type);
+    pointed_info.pointer_level--;
+    LLVMTypeRef pointed_type = build_type_from_info(visitor->ctx, &pointed_info);
 
-    return LLVMBuildLoad2(visitor->ctx->builder, pointed_type, ptr_val, "deref");
+    LLVMValueRef load = LLVMBuildLoad2(visitor->ctx->builder, pointed_type, ptr_val, "deref");
+    tag_restrict_access(visitor, load, ptr_expr);
+    return load;
 }
 
 LLVMValueRef visit_pre_inc(CodegenVisitor* visitor, UnaryOpNode node)
@@ -192,7 +327,7 @@ LLVMValueRef visit_pre_inc(CodegenVisitor* visitor, UnaryOpNode node)
     const char* var_name = node.operand->as.identifier.name;
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, var_name);
 
-    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) 
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || reject_const_write(visitor, entry, var_name)) 
         return NULL;
 
     LLVMValueRef alloca = entry->symbol_data.as.variable.alloc;
@@ -221,7 +356,7 @@ LLVMValueRef visit_pre_dec(CodegenVisitor* visitor, UnaryOpNode node)
     const char* var_name = node.operand->as.identifier.name;
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, var_name);
 
-    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) 
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || reject_const_write(visitor, entry, var_name)) 
         return NULL;
 
     LLVMValueRef alloca = entry->symbol_data.as.variable.alloc;
@@ -250,7 +385,7 @@ LLVMValueRef visit_post_inc(CodegenVisitor* visitor, UnaryOpNode node)
     const char* var_name = node.operand->as.identifier.name;
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, var_name);
 
-    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) 
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || reject_const_write(visitor, entry, var_name)) 
         return NULL;
 
     LLVMValueRef alloca = entry->symbol_data.as.variable.alloc;
@@ -279,7 +414,7 @@ LLVMValueRef visit_post_dec(CodegenVisitor* visitor, UnaryOpNode node)
     const char* var_name = node.operand->as.identifier.name;
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, var_name);
 
-    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) 
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || reject_const_write(visitor, entry, var_name)) 
         return NULL;
 
     LLVMValueRef alloca = entry->symbol_data.as.variable.alloc;
@@ -308,6 +443,7 @@ LLVMValueRef visit_unary_op_expr(CodegenVisitor* visitor, ASTNode* node)
         case OP_ADDR:       return visit_address_of(visitor, unary_node);
         case OP_DEREF:      return visit_dereference(visitor, unary_node);
         case OP_NEG:        return visit_negation(visitor, unary_node);
+        case OP_NOT:        return visit_logical_not(visitor, unary_node);
         case OP_PRE_INC:    return visit_pre_inc(visitor, unary_node);
         case OP_PRE_DEC:    return visit_pre_dec(visitor, unary_node);
         case OP_POST_INC:   return visit_post_inc(visitor, unary_node);
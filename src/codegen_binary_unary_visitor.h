@@ -1,9 +1,13 @@
 #ifndef CODEGEN_BINARY_UNARY_VISITOR_H
 #define CODEGEN_BINARY_UNARY_VISITOR_H
 
+#include "codegen_visitor.h"
 #include <llvm-c/Core.h>
 #include <llvm-c/Types.h>
 
 int does_type_kind_match(LLVMValueRef left, LLVMValueRef right, LLVMTypeKind* out_kind);
+LLVMValueRef build_truth_value(CodegenVisitor* visitor, LLVMValueRef value);
+LLVMValueRef build_binary_values(CodegenVisitor* visitor, BinaryOp op, LLVMValueRef left, int left_unsigned, LLVMValueRef right, int right_unsigned);
+void widen_integer_operands(CodegenVisitor* visitor, LLVMValueRef* left, int left_unsigned, LLVMValueRef* right, int right_unsigned);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "codegen_bounds_visitor.h"
+#include "codegen_expr_visitor.h"
+#include "codegen_decl_visitor.h"
+#include "bounds_analysis.h"
+#include "diagnostics.h"
+#include <stdio.h>
+
+static LLVMBasicBlockRef get_bounds_trap_block(CodegenVisitor* visitor)
+{
+    CodegenContext* ctx = visitor->ctx;
+    if (ctx->bounds_trap_block != NULL)
+        return ctx->bounds_trap_block;
+
+    LLVMValueRef fail = LLVMGetNamedFunction(ctx->module, "ecl_rt_bounds_fail");
+    if (fail == NULL) {
+        fail = get_runtime_func(ctx, "ecl_rt_bounds_fail", LLVMVoidTypeInContext(ctx->context), NULL, 0);
+        add_function_attribute(visitor, fail, "cold", 0);
+        add_function_attribute(visitor, fail, "noreturn", 0);
+        add_function_attribute(visitor, fail, "nounwind", 0);
+    }
+
+    LLVMBasicBlockRef current = LLVMGetInsertBlock(ctx->builder);
+    ctx->bounds_trap_block = LLVMAppendBasicBlockInContext(ctx->context, ctx->current_function, "bounds_trap");
+
+    LLVMPositionBuilderAtEnd(ctx->builder, ctx->bounds_trap_block);
+    LLVMBuildCall2(ctx->builder, LLVMGlobalGetValueType(fail), fail, NULL, 0, "");
+    LLVMBuildUnreachable(ctx->builder);
+
+    LLVMPositionBuilderAtEnd(ctx->builder, current);
+    return ctx->bounds_trap_block;
+}
+
+// continues in a fresh block when ok holds, the trap block is the unlikely successor
+static void branch_to_trap_unless(CodegenVisitor* visitor, LLVMValueRef ok, const char* name)
+{
+    LLVMBasicBlockRef trap = get_bounds_trap_block(visitor);
+    LLVMBasicBlockRef passBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, name);
+
+    LLVMValueRef branch = LLVMBuildCondBr(visitor->ctx->builder, ok, passBB, trap);
+    set_branch_weights(visitor, branch, BOUNDS_PASS_WEIGHT, BOUNDS_FAIL_WEIGHT);
+    LLVMPositionBuilderAtEnd(visitor->ctx->builder, passBB);
+}
+
+static int is_proven_in_bounds(CodegenVisitor* visitor, ASTNode* index_node, long long extent)
+{
+    if (index_node->type == AST_INT_LITERAL)
+        return index_node->as.int_literal.value >= 0 && index_node->as.int_literal.value < extent;
+
+    CodegenContext* ctx = visitor->ctx;
+    for (int i = ctx->induction_depth - 1; i >= 0; i--) {
+        ActiveInduction* induction = &ctx->inductions[i];
+        long long offset;
+        if (match_induction_index(index_node, induction->range->var, &offset))
+            return induction->range->start + offset >= 0 && induction->limit + offset <= extent;
+    }
+    return 0;
+}
+
+void emit_bounds_check(CodegenVisitor* visitor, LLVMValueRef index_val, ASTNode* index_node, long long extent)
+{
+    CodegenContext* ctx = visitor->ctx;
+    if (!ctx->options.bounds_check || extent <= 0 || index_node == NULL)
+        return;
+
+    if (is_proven_in_bounds(visitor, index_node, extent)) {
+        ctx->bounds_checks_removed++;
+        return;
+    }
+    ctx->bounds_checks_kept++;
+
+    // one unsigned compare also rejects negative indices
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef index = generate_cast_instruction(visitor, index_val, LLVMTypeOf(index_val), i64, is_unsigned_expr(visitor, index_node), 0, "bounds_index");
+    LLVMValueRef ok = LLVMBuildICmp(ctx->builder, LLVMIntULT, index, LLVMConstInt(i64, extent, 0), "in_bounds");
+    branch_to_trap_unless(visitor, ok, "bounds_ok");
+}
+
+static long long get_index_extent(CodegenVisitor* visitor, ASTNode* target)
+{
+    TypeInfo info;
+    if (!get_declared_type_info(visitor, target, &info) || !info.is_array)
+        return 0;
+    return info.array_sizes[0];
+}
+
+typedef struct {
+    CodegenVisitor* visitor;
+    const InductionRange* range;
+    long long limit;
+    int found;
+    int exits_early;
+} HoistScan;
+
+static void find_early_exit(ASTNode* node, void* data)
+{
+    HoistScan* scan = data;
+    if (node == NULL || scan->exits_early)
+        return;
+
+    if (node->type == AST_RETURN || node->type == AST_BREAK || node->type == AST_CONTINUE) {
+        scan->exits_early = 1;
+        return;
+    }
+    visit_ast_children(node, find_early_exit, data);
+}
+
+// only accesses that run on every iteration count, branches and short-circuited operands may be skipped
+static void collect_hoist_limit(ASTNode* node, void* data)
+{
+    HoistScan* scan = data;
+    if (node == NULL)
+        return;
+
+    switch (node->type) {
+        case AST_IF:
+            collect_hoist_limit(node->as.if_stmt.condition, data);
+            return;
+
+        case AST_WHILE:
+            collect_hoist_limit(node->as.while_stmt.condition, data);
+            return;
+
+        case AST_FOR:
+            collect_hoist_limit(node->as.for_stmt.init, data);
+            collect_hoist_limit(node->as.for_stmt.condition, data);
+            return;
+
+        case AST_TERNARY:
+            collect_hoist_limit(node->as.ternary.condition, data);
+            return;
+
+        case AST_BINARY_OP:
+            if (node->as.binary_op.op == OP_AND || node->as.binary_op.op == OP_OR) {
+                collect_hoist_limit(node->as.binary_op.left, data);
+                return;
+            }
+            break;
+
+        case AST_ARRAY_ACCESS: {
+            long long offset;
+            long long extent = get_index_extent(scan->visitor, node->as.array_access.target);
+            const InductionRange* range = scan->range;
+
+            // the iteration with var == extent - offset must exist, that is where the unchecked loop would have trapped
+            if (extent > 0 && match_induction_index(node->as.array_access.index, range->var, &offset)
+                && range->start + offset >= 0 && range->start < extent - offset) {
+                if (!scan->found || extent - offset < scan->limit)
+                    scan->limit = extent - offset;
+                scan->found = 1;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    visit_ast_children(node, collect_hoist_limit, data);
+}
+
+// one check of the loop-invariant limit before the loop covers every access on the induction variable,
+// a limit that fails it would have trapped inside the loop anyway, only earlier
+static int hoist_limit_check(CodegenVisitor* visitor, ForNode* for_node, long long* out_limit)
+{
+    HoistScan scan = { .visitor = visitor, .range = &for_node->range };
+    if (for_node->range.step != 1)
+        return 0;
+
+    find_early_exit(for_node->body, &scan);
+    if (scan.exits_early)
+        return 0;
+
+    collect_hoist_limit(for_node->body, &scan);
+    if (!scan.found)
+        return 0;
+
+    TypeInfo limit_info;
+    ASTNode* limit_expr = for_node->range.limit_expr;
+    if (!get_declared_type_info(visitor, limit_expr, &limit_info) || limit_info.base_type != TOK_INT
+        || limit_info.is_unsigned || limit_info.pointer_level > 0 || limit_info.is_array || limit_info.vector_width > 0)
+        return 0;
+
+    LLVMValueRef limit = visit_expression(visitor, limit_expr);
+    if (limit == NULL)
+        return 0;
+
+    CodegenContext* ctx = visitor->ctx;
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ctx->context);
+    limit = generate_cast_instruction(visitor, limit, LLVMTypeOf(limit), i64, 0, 0, "loop_limit");
+
+    LLVMIntPredicate predicate = for_node->range.is_inclusive ? LLVMIntSLT : LLVMIntSLE;
+    LLVMValueRef ok = LLVMBuildICmp(ctx->builder, predicate, limit, LLVMConstInt(i64, scan.limit, 1), "limit_in_bounds");
+    branch_to_trap_unless(visitor, ok, "loop_bounds_ok");
+
+    ctx->bounds_checks_hoisted++;
+    *out_limit = scan.limit;
+    return 1;
+}
+
+int begin_bounds_loop(CodegenVisitor* visitor, ForNode* for_node)
+{
+    CodegenContext* ctx = visitor->ctx;
+    if (!ctx->options.bounds_check || for_node->range.var == NULL || ctx->induction_depth >= MAX_LOOP_DEPTH)
+        return 0;
+
+    long long limit = for_node->range.limit;
+    if (for_node->range.limit_expr != NULL && !hoist_limit_check(visitor, for_node, &limit))
+        return 0;
+
+    ctx->inductions[ctx->induction_depth++] = (ActiveInduction) { .range = &for_node->range, .limit = limit };
+    return 1;
+}
+
+void end_bounds_loop(CodegenVisitor* visitor)
+{
+    visitor->ctx->induction_depth--;
+}
+
+void print_bounds_check_report(CodegenContext* ctx)
+{
+    report_diagnostic("Bounds checks: %d kept, %d removed, %d hoisted out of loops\n",
+        ctx->bounds_checks_kept, ctx->bounds_checks_removed, ctx->bounds_checks_hoisted);
+}
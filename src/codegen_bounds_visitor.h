@@ -0,0 +1,19 @@
+#ifndef CODEGEN_BOUNDS_VISITOR_H
+#define CODEGEN_BOUNDS_VISITOR_H
+
+#include "codegen_visitor.h"
+
+// failed bounds checks leave through a cold trap block
+#define BOUNDS_PASS_WEIGHT 2000
+#define BOUNDS_FAIL_WEIGHT 1
+
+// extent is the number of elements of the indexed dimension, 0 when it is unknown and nothing can be checked
+void emit_bounds_check(CodegenVisitor* visitor, LLVMValueRef index_val, ASTNode* index_node, long long extent);
+
+// called after the init of a for loop, returns 1 when end_bounds_loop has to follow the body
+int begin_bounds_loop(CodegenVisitor* visitor, ForNode* for_node);
+void end_bounds_loop(CodegenVisitor* visitor);
+
+void print_bounds_check_report(CodegenContext* ctx);
+
+#endif
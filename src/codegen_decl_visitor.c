@@ -1,47 +1,161 @@
 #include "codegen_decl_visitor.h"
 #include "codegen_visitor.h"
+#include "codegen_expr_visitor.h"
+#include "codegen_vector_visitor.h"
+#include "codegen_stmt_visitor.h"
+#include "diagnostics.h"
+#include "type_table.h"
 #include <llvm-c/Analysis.h>
+#include <llvm/Config/llvm-config.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// unknown struct names reach codegen as TOK_IDENTIFIER types
+static LLVMTypeRef build_declared_type(CodegenVisitor* visitor, TypeId type_id, const char* name)
+{
+    LLVMTypeRef type = get_llvm_type(visitor->ctx, type_id);
+    if (type == NULL) {
+        const char* type_name = get_type_info(type_id)->type;
+        report_diagnostic("Codegen: Unknown type '%s' for '%s'\n", type_name != NULL ? type_name : "?", name);
+        visitor->ctx->error_count++;
+    }
+    return type;
+}
+
+static int reject_const_initializer(CodegenVisitor* visitor, VarDeclNode var_decl)
+{
+    char what[128];
+    snprintf(what, sizeof(what), "'%s'", var_decl.name);
+    return reject_const_escape(visitor, var_decl.initializer, get_type_info(var_decl.type), what);
+}
+
 void visit_var_decl_decl(CodegenVisitor* visitor, ASTNode* node)
 {
     VarDeclNode var_decl = node->as.var_decl;
-    TypeInfo var_decl_type = var_decl.type;
+    const TypeInfo* var_decl_type = get_type_info(var_decl.type);
+
+    LLVMTypeRef var_type = build_declared_type(visitor, var_decl.type, var_decl.name);
+    if (var_type == NULL)
+        return;
 
-    LLVMTypeRef var_type = build_type_from_info(visitor->ctx, &var_decl_type);
     LLVMValueRef alloca = LLVMBuildAlloca(visitor->ctx->builder, var_type, var_decl.name);
+    if (var_decl_type->is_array)
+        LLVMSetAlignment(alloca, VECTOR_ARRAY_ALIGNMENT);
     
-    if (var_decl.initializer != NULL)
+    if (var_decl.initializer != NULL && !reject_const_initializer(visitor, var_decl))
     {
         LLVMValueRef init_val = visit_expression(visitor, var_decl.initializer);
         if (init_val != NULL)
         {
+            init_val = coerce_value(visitor, init_val, var_type, is_unsigned_expr(visitor, var_decl.initializer));
             LLVMBuildStore(visitor->ctx->builder, init_val, alloca);
         }
     }
     
     add_variable_symbol(visitor->ctx->symbol_table, var_decl.name, var_decl.type, alloca, 0);
+
+    if (var_decl_type->is_restrict && var_decl_type->pointer_level > 0) {
+        SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, var_decl.name);
+        entry->symbol_data.as.variable.alias_scope = create_alias_scope(visitor->ctx, var_decl.name);
+    }
+}
+
+// only main and exported symbols are visible outside the namespace
+int is_externally_visible(const char* name, int is_exported)
+{
+    return is_exported || strcmp(name, "main") == 0;
+}
+
+void apply_symbol_visibility(LLVMValueRef global, int is_external)
+{
+    if (is_external)
+        return;
+
+    LLVMSetLinkage(global, LLVMInternalLinkage);
+    LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+
+    if (LLVMIsAFunction(global))
+        LLVMSetFunctionCallConv(global, LLVMFastCallConv);
+}
+
+// decided on the tree before anything is emitted, a call or load has no block to go into at global scope
+static int is_constant_initializer(CodegenVisitor* visitor, ASTNode* node)
+{
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+        case AST_CHAR_LITERAL:
+        case AST_STRING_LITERAL:
+            return 1;
+
+        // scalar constant globals are folded, see visit_identifier_expr
+        case AST_IDENTIFIER: {
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, node->as.identifier.name);
+            if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+                return 0;
+
+            const TypeInfo* type = get_type_info(entry->symbol_data.as.variable.type);
+            return entry->symbol_data.as.variable.is_global && type->is_const && !type->is_array;
+        }
+
+        case AST_CAST:
+            return is_constant_initializer(visitor, node->as.cast.expr);
+
+        case AST_UNARY_OP: {
+            ASTNode* operand = node->as.unary_op.operand;
+            if (node->as.unary_op.op == OP_NEG || node->as.unary_op.op == OP_NOT)
+                return is_constant_initializer(visitor, operand);
+            if (node->as.unary_op.op != OP_ADDR || operand->type != AST_IDENTIFIER)
+                return 0;
+
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, operand->as.identifier.name);
+            return entry != NULL && entry->symbol_data.kind == SYMBOL_VARIABLE && entry->symbol_data.as.variable.is_global;
+        }
+
+        // && and || branch
+        case AST_BINARY_OP:
+            return node->as.binary_op.op != OP_AND && node->as.binary_op.op != OP_OR
+                && is_constant_initializer(visitor, node->as.binary_op.left)
+                && is_constant_initializer(visitor, node->as.binary_op.right);
+
+        default:
+            return 0;
+    }
 }
 
 void visit_global_var_decl(CodegenVisitor* visitor, ASTNode* node)
 {
     VarDeclNode var_decl = node->as.var_decl;
-    TypeInfo var_decl_type = var_decl.type;
+    const TypeInfo* var_decl_type = get_type_info(var_decl.type);
+
+    LLVMTypeRef var_type = build_declared_type(visitor, var_decl.type, var_decl.name);
+    if (var_type == NULL)
+        return;
 
-    LLVMTypeRef var_type = build_type_from_info(visitor->ctx, &var_decl_type);
     LLVMValueRef global_alloca = LLVMAddGlobal(visitor->ctx->module, var_type, var_decl.name);
+    if (var_decl_type->is_array)
+        LLVMSetAlignment(global_alloca, VECTOR_ARRAY_ALIGNMENT);
 
-    if (var_decl.initializer != NULL) {
-        LLVMValueRef init_val = visit_expression(visitor, var_decl.initializer);
-        if (init_val != NULL) {
-            LLVMSetInitializer(global_alloca, init_val);
+    apply_symbol_visibility(global_alloca, is_externally_visible(var_decl.name, var_decl.is_exported));
+
+    LLVMValueRef init_val = NULL;
+    if (var_decl.initializer != NULL && !reject_const_initializer(visitor, var_decl)) {
+        if (!is_constant_initializer(visitor, var_decl.initializer)) {
+            report_diagnostic("Codegen: Initializer of global '%s' is not a constant\n", var_decl.name);
+            visitor->ctx->error_count++;
+        }
+        else {
+            init_val = visit_expression(visitor, var_decl.initializer);
+            if (init_val != NULL)
+                init_val = coerce_value(visitor, init_val, var_type, is_unsigned_expr(visitor, var_decl.initializer));
         }
-    } 
-    else {
-        LLVMSetInitializer(global_alloca, LLVMConstNull(var_type));
     }
+    LLVMSetInitializer(global_alloca, init_val != NULL ? init_val : LLVMConstNull(var_type));
+
+    if (var_decl_type->is_const)
+        LLVMSetGlobalConstant(global_alloca, 1);
 
     add_variable_symbol(visitor->ctx->symbol_table, var_decl.name, var_decl.type, global_alloca, 1);
 }
@@ -50,16 +164,25 @@ void visit_struct_decl_decl(CodegenVisitor* visitor, ASTNode* node)
 {
     StructDeclNode struct_decl = node->as.struct_decl;
 
-    LLVMTypeRef structType = LLVMStructCreateNamed(LLVMGetGlobalContext(), struct_decl.type);
+    LLVMTypeRef structType = LLVMStructCreateNamed(visitor->ctx->context, struct_decl.type);
     LLVMTypeRef* field_types = malloc(sizeof(LLVMTypeRef) * struct_decl.member_count);
 
     char** member_names = malloc(sizeof(char*) * struct_decl.member_count);
-    TypeInfo* member_types = malloc(sizeof(TypeInfo) * struct_decl.member_count);
+    TypeId* member_types = malloc(sizeof(TypeId) * struct_decl.member_count);
 
     for (int i = 0; i < struct_decl.member_count; i++) {
         ASTNode* field = struct_decl.members[i];
         VarDeclNode field_decl = field->as.var_decl;
-        LLVMTypeRef field_type = build_type_from_info(visitor->ctx, &field_decl.type);
+        LLVMTypeRef field_type = build_declared_type(visitor, field_decl.type, field_decl.name);
+
+        if (field_type == NULL) {
+            for (int j = 0; j < i; j++)
+                free(member_names[j]);
+            free(member_names);
+            free(member_types);
+            free(field_types);
+            return;
+        }
 
         field_types[i] = field_type;
         member_names[i] = strdup(field_decl.name);
@@ -72,23 +195,37 @@ void visit_struct_decl_decl(CodegenVisitor* visitor, ASTNode* node)
     add_struct_symbol(visitor->ctx->symbol_table, struct_decl.type, structType, struct_decl.member_count, member_names, member_types);
 }
 
-void collect_function_param_types(CodegenVisitor* visitor, FunctionNode func_node, LLVMTypeRef* param_types) {
+int collect_function_param_types(CodegenVisitor* visitor, FunctionNode func_node, LLVMTypeRef* param_types) {
+    int ok = 1;
     for (int i = 0; i < func_node.param_count; i++) {
         ASTNode* param = func_node.params[i];
-        param_types[i] = build_type_from_info(visitor->ctx, &param->as.param.type);
+        param_types[i] = build_declared_type(visitor, param->as.param.type, param->as.param.name);
+        if (param_types[i] == NULL)
+            ok = 0;
     }
+    return ok;
 }
 
 void setup_function_params(CodegenVisitor* visitor, LLVMValueRef function, FunctionNode func_node) {
     for (int i = 0; i < func_node.param_count; i++) {
         ASTNode* param = func_node.params[i];
-        TypeInfo* param_info = &param->as.param.type;
+        const TypeInfo* param_info = get_type_info(param->as.param.type);
         char* param_name = param->as.param.name;
 
-        LLVMTypeRef param_type = build_type_from_info(visitor->ctx, param_info);
+        LLVMTypeRef param_type = get_llvm_type(visitor->ctx, param->as.param.type);
         LLVMValueRef alloca = LLVMBuildAlloca(visitor->ctx->builder, param_type, param_name);
 
-        add_variable_symbol(visitor->ctx->symbol_table, param_name, *param_info, alloca, 0);
+        add_variable_symbol(visitor->ctx->symbol_table, param_name, param->as.param.type, alloca, 0);
+
+        if (param_info->is_restrict && param_info->pointer_level > 0)
+            add_param_attribute(visitor, function, i, "noalias", 0);
+
+        // only a[static N] is a contract, calls with a smaller known extent are rejected in visit_func_call_expr
+        if (param_info->has_static_extent) {
+            LLVMTypeRef elem_type = LLVMGetElementType(param_type);
+            add_param_attribute(visitor, function, i, "nonnull", 0);
+            add_param_attribute(visitor, function, i, "dereferenceable", (uint64_t)param_info->array_sizes[0] * LLVMABISizeOfType(visitor->ctx->target_data, elem_type));
+        }
 
         LLVMValueRef param_val = LLVMGetParam(function, i);
         LLVMBuildStore(visitor->ctx->builder, param_val, alloca);
@@ -96,22 +233,107 @@ void setup_function_params(CodegenVisitor* visitor, LLVMValueRef function, Funct
 }
 
 void generate_function_body(CodegenVisitor* visitor, BlockNode body_node) {
-    for (int i = 0; i < body_node.statement_count; i++) {
+    for (int i = 0; i < body_node.statement_count && !is_block_terminated(visitor); i++) {
         visit_statement(visitor, body_node.statements[i]);
     }
+
+    // falling off the end returns from void functions, anything else cannot reach it
+    if (LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(visitor->ctx->builder)) == NULL) {
+        LLVMTypeRef return_type = LLVMGetReturnType(LLVMGlobalGetValueType(visitor->ctx->current_function));
+        if (LLVMGetTypeKind(return_type) == LLVMVoidTypeKind)
+            LLVMBuildRetVoid(visitor->ctx->builder);
+        else
+            LLVMBuildUnreachable(visitor->ctx->builder);
+    }
+}
+
+LLVMAttributeRef create_attribute(CodegenVisitor* visitor, const char* name, uint64_t value)
+{
+    unsigned kind = LLVMGetEnumAttributeKindForName(name, strlen(name));
+    if (kind == 0) {
+        report_diagnostic("Codegen: Unknown attribute '%s'\n", name);
+        return NULL;
+    }
+
+    return LLVMCreateEnumAttribute(visitor->ctx->context, kind, value);
+}
+
+void add_function_attribute(CodegenVisitor* visitor, LLVMValueRef function, const char* name, uint64_t value)
+{
+    LLVMAttributeRef attribute = create_attribute(visitor, name, value);
+    if (attribute != NULL)
+        LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex, attribute);
+}
+
+void add_param_attribute(CodegenVisitor* visitor, LLVMValueRef function, int param_index, const char* name, uint64_t value)
+{
+    LLVMAttributeRef attribute = create_attribute(visitor, name, value);
+    if (attribute != NULL)
+        LLVMAddAttributeAtIndex(function, param_index + 1, attribute);
+}
+
+// pure functions only read memory, const functions touch none, both always return without unwinding
+static void add_memory_attributes(CodegenVisitor* visitor, LLVMValueRef function, int reads_memory)
+{
+#if LLVM_VERSION_MAJOR >= 16
+    add_function_attribute(visitor, function, "memory", reads_memory ? MEMORY_EFFECTS_READ : MEMORY_EFFECTS_NONE);
+#else
+    add_function_attribute(visitor, function, reads_memory ? "readonly" : "readnone", 0);
+#endif
+    add_function_attribute(visitor, function, "willreturn", 0);
+    add_function_attribute(visitor, function, "nounwind", 0);
+}
+
+void apply_function_qualifiers(CodegenVisitor* visitor, LLVMValueRef function, int qualifiers)
+{
+    if (qualifiers & FUNC_QUAL_INLINE)
+        add_function_attribute(visitor, function, "alwaysinline", 0);
+    if (qualifiers & FUNC_QUAL_NOINLINE)
+        add_function_attribute(visitor, function, "noinline", 0);
+
+    if (qualifiers & FUNC_QUAL_HOT) {
+        add_function_attribute(visitor, function, "hot", 0);
+        LLVMSetSection(function, HOT_TEXT_SECTION);
+    }
+    if (qualifiers & FUNC_QUAL_COLD) {
+        add_function_attribute(visitor, function, "cold", 0);
+        LLVMSetSection(function, COLD_TEXT_SECTION);
+    }
+
+    if (qualifiers & FUNC_QUAL_CONST)
+        add_memory_attributes(visitor, function, 0);
+    else if (qualifiers & FUNC_QUAL_PURE)
+        add_memory_attributes(visitor, function, 1);
 }
 
 void visit_function_decl(CodegenVisitor* visitor, ASTNode* node) {
     FunctionNode func_node = node->as.function;
 
     LLVMTypeRef* param_types = malloc(sizeof(LLVMTypeRef) * func_node.param_count);
-    collect_function_param_types(visitor, func_node, param_types);
+    int params_ok = collect_function_param_types(visitor, func_node, param_types);
+
+    LLVMTypeRef return_type = build_declared_type(visitor, func_node.return_type, func_node.name);
+    if (!params_ok || return_type == NULL) {
+        free(param_types);
+        return;
+    }
 
-    LLVMTypeRef return_type = token_type_to_llvm_type(visitor->ctx, func_node.return_type.base_type);
     LLVMTypeRef func_type = LLVMFunctionType(return_type, param_types, func_node.param_count, 0);
+    free(param_types);
 
     LLVMValueRef function = LLVMAddFunction(visitor->ctx->module, func_node.name, func_type);
+    apply_function_qualifiers(visitor, function, func_node.qualifiers);
+    apply_symbol_visibility(function, is_externally_visible(func_node.name, func_node.qualifiers & FUNC_QUAL_EXPORT));
     visitor->ctx->current_function = function;
+    visitor->ctx->alias_domain = NULL;
+    visitor->ctx->alias_scope_count = 0;
+    visitor->ctx->bounds_trap_block = NULL;
+
+    TypeId* param_ids = malloc(sizeof(TypeId) * func_node.param_count);
+    for (int i = 0; i < func_node.param_count; i++) {
+        param_ids[i] = func_node.params[i]->as.param.type;
+    }
+    add_function_symbol(visitor->ctx->symbol_table, func_node.name, func_node.return_type, func_node.param_count, param_ids, function);
 
     LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(visitor->ctx->context, function, "entry");
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, entry);
@@ -143,6 +365,7 @@ void visit_program_decl(CodegenVisitor* visitor, ASTNode* node)
     ProgramNode program = node->as.program;
 
     set_module_identifier(visitor, program.name);
+    visitor->ctx->lines = program.lines;
 
     for (int i = 0; i < program.struct_count; i++) {
         visit_struct_decl_decl(visitor, program.structs[i]);
@@ -2,6 +2,14 @@
 #define CODEGEN_DECL_VISITOR_H
 
 #include "codegen_visitor.h"
+#include <stdint.h>
+
+#define HOT_TEXT_SECTION ".text.hot"
+#define COLD_TEXT_SECTION ".text.unlikely"
+
+// memory(...) attribute payload, two ModRef bits for each of the argument, inaccessible and other locations
+#define MEMORY_EFFECTS_NONE 0x00
+#define MEMORY_EFFECTS_READ 0x15
 
 void visit_var_decl_decl(CodegenVisitor* visitor, ASTNode* node);
 void visit_function_decl(CodegenVisitor* visitor, ASTNode* node);
@@ -11,8 +19,14 @@ void visit_program_decl(CodegenVisitor* visitor, ASTNode* node);
 void visit_global_var_decl(CodegenVisitor* visitor, ASTNode* node);
 
 void set_module_identifier(CodegenVisitor* visitor, const char* name);
-void collect_function_param_types(CodegenVisitor* visitor, FunctionNode func_node, LLVMTypeRef* param_types);
+int collect_function_param_types(CodegenVisitor* visitor, FunctionNode func_node, LLVMTypeRef* param_types);
 void setup_function_params(CodegenVisitor* visitor, LLVMValueRef function, FunctionNode func_node);
 void generate_function_body(CodegenVisitor* visitor, BlockNode body_node);
+LLVMAttributeRef create_attribute(CodegenVisitor* visitor, const char* name, uint64_t value);
+void add_param_attribute(CodegenVisitor* visitor, LLVMValueRef function, int param_index, const char* name, uint64_t value);
+void add_function_attribute(CodegenVisitor* visitor, LLVMValueRef function, const char* name, uint64_t value);
+int is_externally_visible(const char* name, int is_exported);
+void apply_symbol_visibility(LLVMValueRef global, int is_external);
+void apply_function_qualifiers(CodegenVisitor* visitor, LLVMValueRef function, int qualifiers);
 
 #endif
\ No newline at end of file
@@ -1,12 +1,24 @@
 #include "codegen_expr_visitor.h"
+#include "codegen_vector_visitor.h"
+#include "codegen_arena_visitor.h"
+#include "codegen_bounds_visitor.h"
+#include "codegen_binary_unary_visitor.h"
+#include "codegen_decl_visitor.h"
 #include "ast_layout.h"
 #include "lookup_table.h"
+#include "diagnostics.h"
+#include "type_table.h"
 #include <llvm-c/Types.h>
 #include <stdio.h>
 #include <string.h>
 
 LLVMValueRef visit_int_literal_expr(CodegenVisitor* visitor, ASTNode* node) {
     IntLiteralNode int_node = node->as.int_literal;
+
+    long long max_i32 = int_node.is_unsigned ? 4294967295LL : 2147483647LL;
+    if (int_node.value > max_i32)
+        return LLVMConstInt(LLVMInt64TypeInContext(visitor->ctx->context), int_node.value, 0);
+
     return LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), int_node.value, 0);
 }
 
@@ -22,7 +34,22 @@ LLVMValueRef visit_double_literal_expr(CodegenVisitor* visitor, ASTNode* node) {
 
 LLVMValueRef visit_string_literal_expr(CodegenVisitor* visitor, ASTNode* node) {
     StringLiteralNode string_node = node->as.string_literal;
-    return LLVMBuildGlobalStringPtr(visitor->ctx->builder, string_node.value, "str");
+    if (LLVMGetInsertBlock(visitor->ctx->builder) != NULL)
+        return LLVMBuildGlobalStringPtr(visitor->ctx->builder, string_node.value, "str");
+
+    // global initializers have no insert block, which LLVMBuildGlobalStringPtr needs to find the module
+    LLVMValueRef text = LLVMConstStringInContext(visitor->ctx->context, string_node.value, strlen(string_node.value), 0);
+    LLVMValueRef global = LLVMAddGlobal(visitor->ctx->module, LLVMTypeOf(text), "str");
+    LLVMSetInitializer(global, text);
+    LLVMSetGlobalConstant(global, 1);
+    LLVMSetLinkage(global, LLVMPrivateLinkage);
+    LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+
+    LLVMValueRef indices[2] = {
+        LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0),
+        LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0)
+    };
+    return LLVMConstInBoundsGEP2(LLVMTypeOf(text), global, indices, 2);
 }
 
 LLVMValueRef visit_char_literal_expr(CodegenVisitor* visitor, ASTNode* node) {
@@ -39,18 +66,33 @@ LLVMValueRef visit_identifier_expr(CodegenVisitor* visitor, ASTNode* node)
 
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, name);
     if (entry == NULL) {
-        printf("Codegen: Undefined variable '%s'\n", name);
+        report_diagnostic("Codegen: Undefined variable '%s'\n", name);
         return NULL;
     }
 
     if (entry->symbol_data.kind != SYMBOL_VARIABLE) {
-        printf("Codegen: '%s' is not a variable\n", name);
+        report_diagnostic("Codegen: '%s' is not a variable\n", name);
         return NULL;
     }
 
     VariableSymbolData var_data = entry->symbol_data.as.variable;
+    const TypeInfo* var_type = get_type_info(var_data.type);
     LLVMValueRef alloca = var_data.alloc;
 
+    // constant globals are folded into their uses
+    if (var_data.is_global && var_type->is_const && LLVMGetInitializer(alloca) != NULL)
+        return LLVMGetInitializer(alloca);
+
+    // arrays used as values decay to a pointer to their first element
+    if (var_type->is_array && !var_type->is_decayed) {
+        LLVMTypeRef array_type = var_data.is_global ? LLVMGlobalGetValueType(alloca) : LLVMGetAllocatedType(alloca);
+        LLVMValueRef indices[2] = {
+            LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0),
+            LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0)
+        };
+        return LLVMBuildInBoundsGEP2(visitor->ctx->builder, array_type, alloca, indices, 2, "decay");
+    }
+
     if (var_data.is_global) {
         return LLVMBuildLoad2(visitor->ctx->builder, LLVMGlobalGetValueType(alloca), alloca, "global_load");
     } else {
@@ -58,16 +100,92 @@ LLVMValueRef visit_identifier_expr(CodegenVisitor* visitor, ASTNode* node)
     }
 }
 
+// &x arguments point at a whole variable, so they are known non-null and dereferenceable for its size
+static void add_call_argument_attributes(CodegenVisitor* visitor, LLVMValueRef call, FuncCallNode func_call)
+{
+    for (int i = 0; i < func_call.arg_count; i++) {
+        ASTNode* arg = func_call.args[i];
+        if (arg->type != AST_UNARY_OP || arg->as.unary_op.op != OP_ADDR || arg->as.unary_op.operand->type != AST_IDENTIFIER)
+            continue;
+
+        SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, arg->as.unary_op.operand->as.identifier.name);
+        if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+            continue;
+
+        LLVMValueRef storage = entry->symbol_data.as.variable.alloc;
+        LLVMTypeRef storage_type = entry->symbol_data.as.variable.is_global ? LLVMGlobalGetValueType(storage) : LLVMGetAllocatedType(storage);
+        unsigned long long size = LLVMStoreSizeOfType(visitor->ctx->target_data, storage_type);
+
+        LLVMAttributeRef nonnull = create_attribute(visitor, "nonnull", 0);
+        LLVMAttributeRef dereferenceable = create_attribute(visitor, "dereferenceable", size);
+        if (nonnull != NULL)
+            LLVMAddCallSiteAttribute(call, i + 1, nonnull);
+        if (dereferenceable != NULL && size > 0)
+            LLVMAddCallSiteAttribute(call, i + 1, dereferenceable);
+    }
+}
+
+// extent an argument is known to provide, 0 when it cannot be told from the call site
+static int known_argument_extent(CodegenVisitor* visitor, ASTNode* arg)
+{
+    if (arg->type != AST_IDENTIFIER)
+        return 0;
+
+    SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, arg->as.identifier.name);
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+        return 0;
+
+    const TypeInfo* info = get_type_info(entry->symbol_data.as.variable.type);
+    if (!info->is_array || (info->is_decayed && !info->has_static_extent))
+        return 0;
+    return info->array_sizes[0];
+}
+
+// a[static N] extents and pointers to const storage are checked against the declared parameters
+static int check_call_arguments(CodegenVisitor* visitor, FuncCallNode func_call)
+{
+    SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, func_call.name);
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_FUNCTION || entry->symbol_data.as.function.param_count != func_call.arg_count)
+        return 1;
+
+    for (int i = 0; i < func_call.arg_count; i++) {
+        const TypeInfo* param_info = get_type_info(entry->symbol_data.as.function.param_types[i]);
+        char what[64];
+        snprintf(what, sizeof(what), "argument %d of '%s'", i, func_call.name);
+        if (reject_const_escape(visitor, func_call.args[i], param_info, what))
+            return 0;
+
+        if (!param_info->has_static_extent)
+            continue;
+
+        int extent = known_argument_extent(visitor, func_call.args[i]);
+        if (extent > 0 && extent < param_info->array_sizes[0]) {
+            report_diagnostic("Codegen: argument %d of '%s' has %d elements, the parameter requires at least %d\n",
+                i, func_call.name, extent, param_info->array_sizes[0]);
+            visitor->ctx->error_count++;
+            return 0;
+        }
+    }
+    return 1;
+}
+
 LLVMValueRef visit_func_call_expr(CodegenVisitor* visitor, ASTNode* node)
 {
     FuncCallNode func_call = node->as.func_call;
+    if (is_vector_builtin(visitor, func_call.name))
+        return visit_vector_builtin(visitor, node);
+    if (is_arena_builtin(visitor, func_call.name))
+        return visit_arena_builtin(visitor, node);
+    if (!check_call_arguments(visitor, func_call))
+        return NULL;
+
     LLVMValueRef args[func_call.arg_count];
 
     for (int i = 0; i < func_call.arg_count; i++)
     {
         args[i] = visit_expression(visitor, func_call.args[i]);
         if (args[i] == NULL) {
-            printf("Codegen: Failed to generate argument %d for function call\n", i);
+            report_diagnostic("Codegen: Failed to generate argument %d for function call\n", i);
             return NULL;
         }
     }
@@ -80,7 +198,20 @@ LLVMValueRef visit_func_call_expr(CodegenVisitor* visitor, ASTNode* node)
     if (func_type == NULL)
         return NULL;
 
-    return LLVMBuildCall2(visitor->ctx->builder, func_type, func, args, func_call.arg_count, "func_call");
+    if (LLVMCountParamTypes(func_type) == (unsigned)func_call.arg_count) {
+        LLVMTypeRef param_types[func_call.arg_count + 1];
+        LLVMGetParamTypes(func_type, param_types);
+
+        for (int i = 0; i < func_call.arg_count; i++) {
+            args[i] = coerce_value(visitor, args[i], param_types[i], is_unsigned_expr(visitor, func_call.args[i]));
+        }
+    }
+
+    int returns_void = LLVMGetTypeKind(LLVMGetReturnType(func_type)) == LLVMVoidTypeKind;
+    LLVMValueRef call = LLVMBuildCall2(visitor->ctx->builder, func_type, func, args, func_call.arg_count, returns_void ? "" : "func_call");
+    LLVMSetInstructionCallConv(call, LLVMGetFunctionCallConv(func));
+    add_call_argument_attributes(visitor, call, func_call);
+    return call;
 }
 
 int are_types_compatible(LLVMTypeRef form_type, LLVMTypeRef to_type)
@@ -88,6 +219,9 @@ int are_types_compatible(LLVMTypeRef form_type, LLVMTypeRef to_type)
     LLVMTypeKind from_kind = LLVMGetTypeKind(form_type);
     LLVMTypeKind to_kind = LLVMGetTypeKind(to_type);
 
+    if (from_kind == LLVMVectorTypeKind && to_kind == LLVMVectorTypeKind)
+        return LLVMGetVectorSize(form_type) == LLVMGetVectorSize(to_type);
+
     if(from_kind == to_kind)
         return 1;
 
@@ -102,11 +236,14 @@ int are_types_compatible(LLVMTypeRef form_type, LLVMTypeRef to_type)
 
     if ((from_kind == LLVMIntegerTypeKind && to_kind == LLVMPointerTypeKind) || (from_kind == LLVMPointerTypeKind && to_kind == LLVMIntegerTypeKind)) 
         return 1;
+
+    if (to_kind == LLVMVectorTypeKind && from_kind != LLVMPointerTypeKind)
+        return are_types_compatible(form_type, LLVMGetElementType(to_type));
     
     return 0;
 }
 
-LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, const char* name)
+LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, int from_unsigned, int to_unsigned, const char* name)
 {
     if (from_type == to_type) 
         return value;
@@ -114,6 +251,22 @@ LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef val
     LLVMTypeKind from_kind = LLVMGetTypeKind(from_type);
     LLVMTypeKind to_kind = LLVMGetTypeKind(to_type);
 
+    if (to_kind == LLVMVectorTypeKind && from_kind != LLVMVectorTypeKind)
+        return build_splat(visitor, value, to_type, from_unsigned);
+
+    // vector casts are element-wise, so the lane types pick the instruction
+    LLVMTypeRef from_scalar = from_type;
+    LLVMTypeRef to_scalar = to_type;
+    if (from_kind == LLVMVectorTypeKind && to_kind == LLVMVectorTypeKind) {
+        if (LLVMGetVectorSize(from_type) != LLVMGetVectorSize(to_type))
+            return NULL;
+
+        from_scalar = LLVMGetElementType(from_type);
+        to_scalar = LLVMGetElementType(to_type);
+        from_kind = LLVMGetTypeKind(from_scalar);
+        to_kind = LLVMGetTypeKind(to_scalar);
+    }
+
     if (from_kind == LLVMPointerTypeKind && to_kind == LLVMPointerTypeKind)
         return LLVMBuildBitCast(visitor->ctx->builder, value, to_type, name);
 
@@ -129,11 +282,30 @@ LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef val
     if (from_kind == LLVMDoubleTypeKind && to_kind == LLVMFloatTypeKind)
         return LLVMBuildFPTrunc(visitor->ctx->builder, value, to_type, name);
 
-    if (from_kind == LLVMIntegerTypeKind && (to_kind == LLVMFloatTypeKind || to_kind == LLVMDoubleTypeKind))
+    if (from_kind == LLVMIntegerTypeKind && to_kind == LLVMIntegerTypeKind) {
+        unsigned from_width = LLVMGetIntTypeWidth(from_scalar);
+        unsigned to_width = LLVMGetIntTypeWidth(to_scalar);
+
+        if (from_width == to_width)
+            return value;
+        if (from_width > to_width)
+            return LLVMBuildTrunc(visitor->ctx->builder, value, to_type, name);
+        if (from_unsigned || from_width == 1)
+            return LLVMBuildZExt(visitor->ctx->builder, value, to_type, name);
+        return LLVMBuildSExt(visitor->ctx->builder, value, to_type, name);
+    }
+
+    if (from_kind == LLVMIntegerTypeKind && (to_kind == LLVMFloatTypeKind || to_kind == LLVMDoubleTypeKind)) {
+        if (from_unsigned || LLVMGetIntTypeWidth(from_scalar) == 1)
+            return LLVMBuildUIToFP(visitor->ctx->builder, value, to_type, name);
         return LLVMBuildSIToFP(visitor->ctx->builder, value, to_type, name);
+    }
     
-    if ((from_kind == LLVMFloatTypeKind || from_kind == LLVMDoubleTypeKind) && to_kind == LLVMIntegerTypeKind)
+    if ((from_kind == LLVMFloatTypeKind || from_kind == LLVMDoubleTypeKind) && to_kind == LLVMIntegerTypeKind) {
+        if (to_unsigned)
+            return LLVMBuildFPToUI(visitor->ctx->builder, value, to_type, name);
         return LLVMBuildFPToSI(visitor->ctx->builder, value, to_type, name);
+    }
 
     return NULL;
 }
@@ -143,99 +315,357 @@ LLVMValueRef visit_cast_expr(CodegenVisitor* visitor, ASTNode* node) {
 
     LLVMValueRef value = visit_expression(visitor, cast_node.expr);
     if (value == NULL) {
-        printf("Codegen: Failed to generate expression for cast\n");
+        report_diagnostic("Codegen: Failed to generate expression for cast\n");
         return NULL;
     }
 
     LLVMTypeRef from_type = LLVMTypeOf(value);
-    LLVMTypeRef to_type = token_type_to_llvm_type(visitor->ctx, cast_node.target_type.base_type);
+    LLVMTypeRef to_type = get_llvm_type(visitor->ctx, cast_node.target_type);
+    if (to_type == NULL)
+        return NULL;
 
-    for (int i = 0; i < cast_node.target_type.pointer_level; i++) {
-        to_type = LLVMPointerType(to_type, 0);
+    if (!are_types_compatible(from_type, to_type)) {
+        report_diagnostic("Codegen: Incompatible cast\n");
+        return NULL;
     }
 
-    if (!are_types_compatible(from_type, to_type)) {
-        printf("Codegen: Incompatible cast\n");
+    int from_unsigned = is_unsigned_expr(visitor, cast_node.expr);
+    const TypeInfo* target_info = get_type_info(cast_node.target_type);
+    int to_unsigned = target_info->is_unsigned && target_info->pointer_level == 0;
+    return generate_cast_instruction(visitor, value, from_type, to_type, from_unsigned, to_unsigned, "cast_result");
+}
+
+// both arms of a select are evaluated, so only arms that can neither trap nor write qualify
+static int is_side_effect_free(ASTNode* node)
+{
+    if (node == NULL)
+        return 0;
+
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+        case AST_CHAR_LITERAL:
+        case AST_STRING_LITERAL:
+        case AST_IDENTIFIER:
+            return 1;
+
+        case AST_CAST:
+            return is_side_effect_free(node->as.cast.expr);
+
+        case AST_UNARY_OP:
+            switch (node->as.unary_op.op) {
+                case OP_NEG: case OP_NOT: case OP_ADDR:
+                    return is_side_effect_free(node->as.unary_op.operand);
+                default:
+                    return 0;
+            }
+
+        case AST_BINARY_OP:
+            if (node->as.binary_op.op == OP_DIV || node->as.binary_op.op == OP_MOD)
+                return 0;
+            return is_side_effect_free(node->as.binary_op.left) && is_side_effect_free(node->as.binary_op.right);
+
+        case AST_TERNARY:
+            return is_side_effect_free(node->as.ternary.condition)
+                && is_side_effect_free(node->as.ternary.then_expr)
+                && is_side_effect_free(node->as.ternary.else_expr);
+
+        default:
+            return 0;
+    }
+}
+
+// arms meet at the wider of the two types, floating point wins over integers
+static LLVMTypeRef get_common_arm_type(LLVMTypeRef then_type, LLVMTypeRef else_type)
+{
+    if (then_type == else_type)
+        return then_type;
+
+    LLVMTypeKind then_kind = LLVMGetTypeKind(then_type);
+    LLVMTypeKind else_kind = LLVMGetTypeKind(else_type);
+
+    if (then_kind == LLVMIntegerTypeKind && else_kind == LLVMIntegerTypeKind)
+        return LLVMGetIntTypeWidth(then_type) >= LLVMGetIntTypeWidth(else_type) ? then_type : else_type;
+
+    int then_numeric = then_kind == LLVMIntegerTypeKind || then_kind == LLVMFloatTypeKind || then_kind == LLVMDoubleTypeKind;
+    int else_numeric = else_kind == LLVMIntegerTypeKind || else_kind == LLVMFloatTypeKind || else_kind == LLVMDoubleTypeKind;
+    if (!then_numeric || !else_numeric)
+        return NULL;
+
+    if (then_kind == LLVMDoubleTypeKind || else_kind == LLVMDoubleTypeKind)
+        return then_kind == LLVMDoubleTypeKind ? then_type : else_type;
+
+    return then_kind == LLVMFloatTypeKind ? then_type : else_type;
+}
+
+static LLVMValueRef visit_select_ternary(CodegenVisitor* visitor, TernaryNode ternary, LLVMValueRef condition)
+{
+    LLVMValueRef then_val = visit_expression(visitor, ternary.then_expr);
+    LLVMValueRef else_val = visit_expression(visitor, ternary.else_expr);
+    if (then_val == NULL || else_val == NULL)
+        return NULL;
+
+    LLVMTypeRef result_type = get_common_arm_type(LLVMTypeOf(then_val), LLVMTypeOf(else_val));
+    if (result_type == NULL) {
+        report_diagnostic("Codegen: Mismatched types in conditional expression\n");
+        return NULL;
+    }
+
+    LLVMTypeRef condition_type = LLVMTypeOf(condition);
+    if (LLVMGetTypeKind(condition_type) == LLVMVectorTypeKind
+        && (LLVMGetTypeKind(result_type) != LLVMVectorTypeKind || LLVMGetVectorSize(result_type) != LLVMGetVectorSize(condition_type))) {
+        report_diagnostic("Codegen: Vector condition needs vector arms with the same lane count\n");
         return NULL;
     }
 
-    return generate_cast_instruction(visitor, value, from_type, to_type, "cast_result");
+    then_val = coerce_value(visitor, then_val, result_type, is_unsigned_expr(visitor, ternary.then_expr));
+    else_val = coerce_value(visitor, else_val, result_type, is_unsigned_expr(visitor, ternary.else_expr));
+    return LLVMBuildSelect(visitor->ctx->builder, condition, then_val, else_val, "select");
 }
 
-LLVMValueRef visit_member_access_expr(CodegenVisitor* visitor, ASTNode* node) {
-    MemberAccessNode access_node = node->as.member_access;
-    if (access_node.object == NULL)
+static LLVMValueRef visit_branching_ternary(CodegenVisitor* visitor, TernaryNode ternary, LLVMValueRef condition)
+{
+    LLVMBuilderRef builder = visitor->ctx->builder;
+
+    if (LLVMGetTypeKind(LLVMTypeOf(condition)) == LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: Vector condition needs side-effect-free arms\n");
         return NULL;
+    }
+
+    LLVMBasicBlockRef thenBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "cond_then");
+    LLVMBasicBlockRef elseBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "cond_else");
+    LLVMBasicBlockRef mergeBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "cond_merge");
+    LLVMBuildCondBr(builder, condition, thenBB, elseBB);
+
+    LLVMPositionBuilderAtEnd(builder, thenBB);
+    LLVMValueRef then_val = visit_expression(visitor, ternary.then_expr);
+    LLVMBasicBlockRef then_end = LLVMGetInsertBlock(builder);
+
+    LLVMPositionBuilderAtEnd(builder, elseBB);
+    LLVMValueRef else_val = visit_expression(visitor, ternary.else_expr);
+    LLVMBasicBlockRef else_end = LLVMGetInsertBlock(builder);
 
-    const char* member_name = access_node.member;
-    if (member_name == NULL && access_node.object->type != AST_IDENTIFIER)
+    if (then_val == NULL || else_val == NULL)
         return NULL;
 
-    const char* var_name = access_node.object->as.identifier.name;
-    SymbolEntry* var_entry = lookup_symbol(visitor->ctx->symbol_table, var_name);    
-    TypeInfo var_type  = var_entry->symbol_data.as.variable.type;
-    if (var_entry == NULL || var_entry->symbol_data.kind != SYMBOL_VARIABLE) {
+    LLVMTypeRef result_type = get_common_arm_type(LLVMTypeOf(then_val), LLVMTypeOf(else_val));
+    if (result_type == NULL) {
+        report_diagnostic("Codegen: Mismatched types in conditional expression\n");
         return NULL;
     }
 
-    const char* struct_type_name = var_type.type;
-    LLVMValueRef struct_ptr = var_entry->symbol_data.as.variable.alloc;
+    // the arms are only known after both are built, so each one is widened at the end of its own block
+    LLVMPositionBuilderAtEnd(builder, then_end);
+    then_val = coerce_value(visitor, then_val, result_type, is_unsigned_expr(visitor, ternary.then_expr));
+    LLVMBuildBr(builder, mergeBB);
+
+    LLVMPositionBuilderAtEnd(builder, else_end);
+    else_val = coerce_value(visitor, else_val, result_type, is_unsigned_expr(visitor, ternary.else_expr));
+    LLVMBuildBr(builder, mergeBB);
+
+    LLVMPositionBuilderAtEnd(builder, mergeBB);
+    LLVMValueRef phi = LLVMBuildPhi(builder, result_type, "cond");
+
+    LLVMValueRef incoming_values[2] = { then_val, else_val };
+    LLVMBasicBlockRef incoming_blocks[2] = { then_end, else_end };
+    LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
+
+    return phi;
+}
+
+LLVMValueRef visit_ternary_expr(CodegenVisitor* visitor, ASTNode* node)
+{
+    TernaryNode ternary = node->as.ternary;
+
+    LLVMValueRef condition = build_truth_value(visitor, visit_expression(visitor, ternary.condition));
+    if (condition == NULL)
+        return NULL;
+
+    if (is_side_effect_free(ternary.then_expr) && is_side_effect_free(ternary.else_expr))
+        return visit_select_ternary(visitor, ternary, condition);
+
+    return visit_branching_ternary(visitor, ternary, condition);
+}
+
+// the address a member is read from, a struct variable's own storage or the pointer loaded for (*p) and p->
+static LLVMValueRef get_struct_ptr(CodegenVisitor* visitor, ASTNode* object)
+{
+    switch (object->type) {
+        case AST_IDENTIFIER: {
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, object->as.identifier.name);
+            if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+                return NULL;
+            return entry->symbol_data.as.variable.alloc;
+        }
+
+        case AST_UNARY_OP:
+            if (object->as.unary_op.op != OP_DEREF)
+                return NULL;
+            return visit_expression(visitor, object->as.unary_op.operand);
+
+        case AST_MEMBER_ACCESS:
+            return get_member_ptr(visitor, object, NULL);
 
-    LLVMTypeRef struct_type = lookup_struct_type(visitor->ctx->symbol_table, struct_type_name);
+        case AST_ARRAY_ACCESS: {
+            LLVMValueRef index_val = visit_expression(visitor, object->as.array_access.index);
+            if (index_val == NULL)
+                return NULL;
+
+            LLVMTypeRef elem_type;
+            return get_array_element_ptr(visitor, object->as.array_access.target, index_val, object->as.array_access.index, &elem_type);
+        }
+
+        default:
+            return NULL;
+    }
+}
+
+LLVMValueRef get_member_ptr(CodegenVisitor* visitor, ASTNode* node, LLVMTypeRef* out_member_type)
+{
+    MemberAccessNode access_node = node->as.member_access;
+    if (access_node.object == NULL || access_node.member == NULL)
+        return NULL;
+
+    TypeInfo object_type;
+    if (!get_declared_type_info(visitor, access_node.object, &object_type) || object_type.base_type != TOK_IDENTIFIER || object_type.is_array) {
+        report_diagnostic("Codegen: Member '%s' accessed on a non-struct value\n", access_node.member);
+        return NULL;
+    }
+
+    if (object_type.pointer_level > 0) {
+        report_diagnostic("Codegen: Member '%s' accessed through a pointer, use '->'\n", access_node.member);
+        return NULL;
+    }
+
+    LLVMTypeRef struct_type = lookup_struct_type(visitor->ctx->symbol_table, object_type.type);
     if (struct_type == NULL)
         return NULL;
 
-    int member_index = get_struct_member_index(visitor->ctx->symbol_table, struct_type_name, member_name);
-    if (member_index < 0)
+    int member_index = get_struct_member_index(visitor->ctx->symbol_table, object_type.type, access_node.member);
+    if (member_index < 0) {
+        report_diagnostic("Codegen: Struct '%s' has no member '%s'\n", object_type.type, access_node.member);
         return NULL;
+    }
+
+    LLVMValueRef struct_ptr = get_struct_ptr(visitor, access_node.object);
+    if (struct_ptr == NULL)
+        return NULL;
+
+    if (out_member_type != NULL)
+        *out_member_type = LLVMStructGetTypeAtIndex(struct_type, member_index);
 
-    LLVMValueRef indices[2];
-    indices[0] = LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0);
-    indices[1] = LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), member_index, 0);
+    return LLVMBuildStructGEP2(visitor->ctx->builder, struct_type, struct_ptr, member_index, "member_ptr");
+}
 
-    LLVMValueRef member_ptr = LLVMBuildGEP2(
-        visitor->ctx->builder,
-        struct_type,
-        struct_ptr,
-        indices,
-        2,
-        "member_ptr"
-    );
+LLVMValueRef visit_member_access_expr(CodegenVisitor* visitor, ASTNode* node) {
+    LLVMTypeRef member_type;
+    LLVMValueRef member_ptr = get_member_ptr(visitor, node, &member_type);
+    if (member_ptr == NULL)
+        return NULL;
 
-    LLVMTypeRef member_type = LLVMStructGetTypeAtIndex(struct_type, member_index);
     return LLVMBuildLoad2(visitor->ctx->builder, member_type, member_ptr, "member_value");
 }
 
-LLVMValueRef get_array_element_ptr(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, LLVMTypeRef* out_elem_type) {
-    if (target->type == AST_IDENTIFIER) {
-        const char* name = target->as.identifier.name;
-        SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, name);
-        if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) {
-            return NULL;
+// a[i][j]... is addressed by one GEP, each in-memory array step adds an index instead of a separate GEP
+typedef struct {
+    LLVMValueRef base;
+    LLVMTypeRef source_type;
+    LLVMValueRef indices[MAX_ARRAY_DIMS + 1];
+    int index_count;
+} ElementAddress;
+
+static int build_element_address(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, ASTNode* index_node, ElementAddress* address);
+
+// address of an array object that lives in memory: a variable, a struct member or a row of an outer array
+static int build_array_address(CodegenVisitor* visitor, ASTNode* array_expr, ElementAddress* address)
+{
+    LLVMValueRef zero = LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0);
+
+    switch (array_expr->type) {
+        case AST_IDENTIFIER: {
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, array_expr->as.identifier.name);
+            if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+                return 0;
+
+            VariableSymbolData* var_data = &entry->symbol_data.as.variable;
+            address->base = var_data->alloc;
+            address->source_type = get_llvm_type(visitor->ctx, var_data->type);
+            address->indices[0] = zero;
+            address->index_count = 1;
+            return address->source_type != NULL;
         }
 
-        VariableSymbolData* var_data = &entry->symbol_data.as.variable;
-        LLVMValueRef base_ptr = var_data->alloc;        
-        LLVMTypeRef base_type = build_type_from_info(visitor->ctx, &var_data->type);
-        
-        *out_elem_type = get_element_type_from_info(visitor, var_data->type);
-        if (*out_elem_type == NULL) 
-            return NULL;
+        case AST_MEMBER_ACCESS: {
+            LLVMTypeRef member_type;
+            address->base = get_member_ptr(visitor, array_expr, &member_type);
+            address->source_type = member_type;
+            address->indices[0] = zero;
+            address->index_count = 1;
+            return address->base != NULL;
+        }
 
-        if (var_data->type.is_array) {
-            LLVMValueRef indices[] = { 
-                LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0), 
-                index_val 
-            };
-            return LLVMBuildGEP2(visitor->ctx->builder, base_type, base_ptr, indices, 2, "array_gep");
-        } 
-        else {
-            LLVMValueRef loaded_ptr = LLVMBuildLoad2(visitor->ctx->builder, base_type, base_ptr, "ptr_load");
-            LLVMValueRef indices[] = { index_val };
-            return LLVMBuildGEP2(visitor->ctx->builder, *out_elem_type, loaded_ptr, indices, 1, "ptr_gep");
+        case AST_ARRAY_ACCESS: {
+            ASTNode* row_node = array_expr->as.array_access.index;
+            LLVMValueRef row_index = visit_expression(visitor, row_node);
+            if (row_index == NULL)
+                return 0;
+            return build_element_address(visitor, array_expr->as.array_access.target, row_index, row_node, address);
         }
+
+        default:
+            return 0;
     }
-    return NULL;
+}
+
+static int build_element_address(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, ASTNode* index_node, ElementAddress* address)
+{
+    TypeInfo target_info;
+    if (!get_declared_type_info(visitor, target, &target_info))
+        return 0;
+
+    if (target_info.is_array && !target_info.is_decayed) {
+        if (!build_array_address(visitor, target, address))
+            return 0;
+
+        emit_bounds_check(visitor, index_val, index_node, target_info.array_sizes[0]);
+
+        if (address->index_count > MAX_ARRAY_DIMS) {
+            report_diagnostic("Codegen: Too many array indices\n");
+            return 0;
+        }
+        address->indices[address->index_count++] = index_val;
+        return 1;
+    }
+
+    if (!target_info.is_array && target_info.pointer_level == 0)
+        return 0;
+
+    // pointers and decayed array parameters: the chain restarts from the loaded pointer
+    address->base = visit_expression(visitor, target);
+    if (target_info.is_array)
+        emit_bounds_check(visitor, index_val, index_node, target_info.array_sizes[0]);
+
+    address->source_type = get_element_type_from_info(visitor, target_info);
+    address->indices[0] = index_val;
+    address->index_count = 1;
+    return address->base != NULL && address->source_type != NULL;
+}
+
+LLVMValueRef get_array_element_ptr(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, ASTNode* index_node, LLVMTypeRef* out_elem_type) {
+    TypeInfo target_info;
+    if (!get_declared_type_info(visitor, target, &target_info))
+        return NULL;
+
+    *out_elem_type = get_element_type_from_info(visitor, target_info);
+    if (*out_elem_type == NULL)
+        return NULL;
+
+    ElementAddress address;
+    if (!build_element_address(visitor, target, index_val, index_node, &address))
+        return NULL;
+
+    return LLVMBuildInBoundsGEP2(visitor->ctx->builder, address.source_type, address.base, address.indices, address.index_count, "element_ptr");
 }
 
 LLVMValueRef visit_array_access_expr(CodegenVisitor* visitor, ASTNode* node) {
@@ -246,10 +676,256 @@ LLVMValueRef visit_array_access_expr(CodegenVisitor* visitor, ASTNode* node) {
     if (index_val == NULL) 
         return NULL;
 
+    TypeInfo target_type;
+    if (get_declared_type_info(visitor, target, &target_type) && is_vector_info(&target_type))
+        return visit_lane_access(visitor, target, index_val);
+
     LLVMTypeRef elem_type = NULL;
-    LLVMValueRef element_ptr = get_array_element_ptr(visitor, target, index_val, &elem_type);
+    LLVMValueRef element_ptr = get_array_element_ptr(visitor, target, index_val, index, &elem_type);
     if (element_ptr == NULL || elem_type == NULL)
         return NULL;
 
-    return LLVMBuildLoad2(visitor->ctx->builder, elem_type, element_ptr, "array_load");
-}
\ No newline at end of file
+    LLVMValueRef load = LLVMBuildLoad2(visitor->ctx->builder, elem_type, element_ptr, "array_load");
+    tag_restrict_access(visitor, load, target);
+    return load;
+}
+
+static const TypeInfo* lookup_variable_type(CodegenVisitor* visitor, ASTNode* node) {
+    if (node == NULL || node->type != AST_IDENTIFIER)
+        return NULL;
+
+    SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, node->as.identifier.name);
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+        return NULL;
+
+    return get_type_info(entry->symbol_data.as.variable.type);
+}
+
+// declared type of an expression that names storage or carries a type (casts, calls), 0 for literals and arithmetic
+int get_declared_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out)
+{
+    if (node == NULL)
+        return 0;
+
+    switch (node->type) {
+        case AST_IDENTIFIER: {
+            const TypeInfo* type = lookup_variable_type(visitor, node);
+            if (type == NULL)
+                return 0;
+
+            *out = *type;
+            return 1;
+        }
+
+        case AST_CAST:
+            *out = *get_type_info(node->as.cast.target_type);
+            return 1;
+
+        case AST_ARRAY_ACCESS: {
+            TypeInfo target_type;
+            if (!get_declared_type_info(visitor, node->as.array_access.target, &target_type))
+                return 0;
+
+            *out = get_element_info(target_type);
+            return 1;
+        }
+
+        case AST_MEMBER_ACCESS: {
+            TypeInfo object_type;
+            if (!get_declared_type_info(visitor, node->as.member_access.object, &object_type))
+                return 0;
+
+            TypeId member_type = get_struct_member_type(visitor->ctx->symbol_table, object_type.type, node->as.member_access.member);
+            if (member_type == TYPE_ID_NONE)
+                return 0;
+
+            *out = *get_type_info(member_type);
+            return 1;
+        }
+
+        case AST_FUNC_CALL: {
+            if (get_vector_builtin_type_info(visitor, node, out) || get_arena_builtin_type_info(visitor, node, out))
+                return 1;
+
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, node->as.func_call.name);
+            if (entry == NULL || entry->symbol_data.kind != SYMBOL_FUNCTION)
+                return 0;
+
+            *out = *get_type_info(entry->symbol_data.as.function.return_type);
+            return 1;
+        }
+
+        case AST_UNARY_OP: {
+            if (node->as.unary_op.op != OP_DEREF)
+                return 0;
+
+            TypeInfo pointer_type;
+            if (!get_declared_type_info(visitor, node->as.unary_op.operand, &pointer_type) || pointer_type.pointer_level <= 0)
+                return 0;
+
+            pointer_type.pointer_level--;
+            *out = pointer_type;
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+static int is_scalar_info(TypeInfo* type) {
+    return type->pointer_level == 0 && !type->is_array;
+}
+
+// reports writes to const variables, returns 1 when the write must be rejected
+int reject_const_write(CodegenVisitor* visitor, SymbolEntry* entry, const char* name)
+{
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || !get_type_info(entry->symbol_data.as.variable.type)->is_const)
+        return 0;
+
+    report_diagnostic("Codegen: Cannot assign to const variable '%s'\n", name);
+    visitor->ctx->error_count++;
+    return 1;
+}
+
+static int is_const_storage(CodegenVisitor* visitor, ASTNode* node);
+
+// &k, a const array or a const pointer, const on a pointer variable also covers what it points to
+static int points_to_const(CodegenVisitor* visitor, ASTNode* node)
+{
+    switch (node->type) {
+        case AST_IDENTIFIER: {
+            const TypeInfo* type = lookup_variable_type(visitor, node);
+            return type != NULL && type->is_const && (type->pointer_level > 0 || type->is_array);
+        }
+
+        case AST_UNARY_OP:
+            return node->as.unary_op.op == OP_ADDR && is_const_storage(visitor, node->as.unary_op.operand);
+
+        case AST_CAST:
+            return points_to_const(visitor, node->as.cast.expr);
+
+        case AST_BINARY_OP:
+            return points_to_const(visitor, node->as.binary_op.left) || points_to_const(visitor, node->as.binary_op.right);
+
+        case AST_TERNARY:
+            return points_to_const(visitor, node->as.ternary.then_expr) || points_to_const(visitor, node->as.ternary.else_expr);
+
+        default:
+            return 0;
+    }
+}
+
+// the storage an assignment target names is const itself or reached through a const pointer or array
+static int is_const_storage(CodegenVisitor* visitor, ASTNode* node)
+{
+    switch (node->type) {
+        case AST_IDENTIFIER: {
+            const TypeInfo* type = lookup_variable_type(visitor, node);
+            return type != NULL && type->is_const;
+        }
+
+        case AST_ARRAY_ACCESS:
+            return is_const_storage(visitor, node->as.array_access.target) || points_to_const(visitor, node->as.array_access.target);
+
+        case AST_MEMBER_ACCESS:
+            return is_const_storage(visitor, node->as.member_access.object) || points_to_const(visitor, node->as.member_access.object);
+
+        case AST_UNARY_OP:
+            return node->as.unary_op.op == OP_DEREF && points_to_const(visitor, node->as.unary_op.operand);
+
+        default:
+            return 0;
+    }
+}
+
+// *p = 1, p[0] = 1 and s.x = 1 where p, s or an array on the way is const
+int reject_const_store(CodegenVisitor* visitor, ASTNode* target)
+{
+    if (target->type == AST_IDENTIFIER || !is_const_storage(visitor, target))
+        return 0;
+
+    report_diagnostic("Codegen: Cannot assign through a const variable or pointer\n");
+    visitor->ctx->error_count++;
+    return 1;
+}
+
+// int* q = &k would let a later *q = 1 reach k, only a const pointer may hold the address of const storage
+int reject_const_escape(CodegenVisitor* visitor, ASTNode* value, const TypeInfo* target, const char* what)
+{
+    if (value == NULL || target->pointer_level == 0 || target->is_const || !points_to_const(visitor, value))
+        return 0;
+
+    report_diagnostic("Codegen: %s cannot hold the address of const storage, it is not a const pointer\n", what);
+    visitor->ctx->error_count++;
+    return 1;
+}
+
+// signedness is not part of LLVM integer types, so it is recovered from the declared types
+int is_unsigned_expr(CodegenVisitor* visitor, ASTNode* node)
+{
+    if (node == NULL)
+        return 0;
+
+    switch (node->type) {
+        case AST_INT_LITERAL:
+            return node->as.int_literal.is_unsigned;
+
+        case AST_UNARY_OP:
+            if (node->as.unary_op.op == OP_NEG || node->as.unary_op.op == OP_PRE_INC || node->as.unary_op.op == OP_PRE_DEC
+                || node->as.unary_op.op == OP_POST_INC || node->as.unary_op.op == OP_POST_DEC)
+                return is_unsigned_expr(visitor, node->as.unary_op.operand);
+            break;
+
+        case AST_TERNARY:
+            return is_unsigned_expr(visitor, node->as.ternary.then_expr) || is_unsigned_expr(visitor, node->as.ternary.else_expr);
+
+        case AST_BINARY_OP: {
+            BinaryOpNode binary_node = node->as.binary_op;
+            switch (binary_node.op) {
+                case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+                    return is_unsigned_expr(visitor, binary_node.left) || is_unsigned_expr(visitor, binary_node.right);
+                default:
+                    return 0;
+            }
+        }
+
+        default:
+            break;
+    }
+
+    TypeInfo type;
+    return get_declared_type_info(visitor, node, &type) && is_scalar_info(&type) && type.is_unsigned;
+}
+
+int is_char_expr(CodegenVisitor* visitor, ASTNode* node)
+{
+    if (node == NULL)
+        return 0;
+
+    if (node->type == AST_CHAR_LITERAL)
+        return 1;
+
+    TypeInfo type;
+    if (!get_declared_type_info(visitor, node, &type) || !is_scalar_info(&type))
+        return 0;
+
+    return type.base_type == TOK_CHAR || type.base_type == TOK_UCHAR;
+}
+
+// implicit conversion at stores, returns and call arguments
+LLVMValueRef coerce_value(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef to_type, int from_unsigned)
+{
+    if (value == NULL || to_type == NULL)
+        return value;
+
+    LLVMTypeRef from_type = LLVMTypeOf(value);
+    if (from_type == to_type || !are_types_compatible(from_type, to_type))
+        return value;
+
+    if ((LLVMGetTypeKind(from_type) == LLVMPointerTypeKind) != (LLVMGetTypeKind(to_type) == LLVMPointerTypeKind))
+        return value;
+
+    LLVMValueRef result = generate_cast_instruction(visitor, value, from_type, to_type, from_unsigned, 0, "coerce");
+    return result != NULL ? result : value;
+}
@@ -12,13 +12,23 @@ LLVMValueRef visit_char_literal_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_identifier_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_func_call_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_cast_expr(CodegenVisitor* visitor, ASTNode* node);
+LLVMValueRef visit_ternary_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_binary_op_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_unary_op_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_member_access_expr(CodegenVisitor* visitor, ASTNode* node);
 LLVMValueRef visit_array_access_expr(CodegenVisitor* visitor, ASTNode* node);
 
 int are_types_compatible(LLVMTypeRef form_type, LLVMTypeRef to_type);
-LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, const char* name);
-LLVMValueRef get_array_element_ptr(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, LLVMTypeRef* out_elem_type);
+LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, int from_unsigned, int to_unsigned, const char* name);
+int get_declared_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out);
+int reject_const_write(CodegenVisitor* visitor, SymbolEntry* entry, const char* name);
+int reject_const_store(CodegenVisitor* visitor, ASTNode* target);
+int reject_const_escape(CodegenVisitor* visitor, ASTNode* value, const TypeInfo* target, const char* what);
+int is_unsigned_expr(CodegenVisitor* visitor, ASTNode* node);
+int is_char_expr(CodegenVisitor* visitor, ASTNode* node);
+LLVMValueRef coerce_value(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef to_type, int from_unsigned);
+LLVMValueRef get_member_ptr(CodegenVisitor* visitor, ASTNode* node, LLVMTypeRef* out_member_type);
+// index_node is the source of index_val, --bounds-check decides from it whether the access needs a check
+LLVMValueRef get_array_element_ptr(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, ASTNode* index_node, LLVMTypeRef* out_elem_type);
 
 #endif
\ No newline at end of file
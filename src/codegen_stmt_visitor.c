@@ -1,6 +1,10 @@
 #include "codegen_stmt_visitor.h"
 #include "codegen_expr_visitor.h"
+#include "codegen_vector_visitor.h"
+#include "codegen_binary_unary_visitor.h"
+#include "codegen_bounds_visitor.h"
 #include "parser.h"
+#include "diagnostics.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -14,24 +18,28 @@ void visit_return_stmt(CodegenVisitor* visitor, ASTNode* node)
     }
 
     LLVMValueRef return_value = visit_expression(visitor, return_node.value);
-    if (return_value == NULL)
+    if (return_value == NULL) {
         LLVMBuildRetVoid(visitor->ctx->builder);
-    else
-        LLVMBuildRet(visitor->ctx->builder, return_value);
+        return;
+    }
+
+    LLVMTypeRef return_type = LLVMGetReturnType(LLVMGlobalGetValueType(visitor->ctx->current_function));
+    return_value = coerce_value(visitor, return_value, return_type, is_unsigned_expr(visitor, return_node.value));
+    LLVMBuildRet(visitor->ctx->builder, return_value);
 }
 
 void visit_if_stmt(CodegenVisitor* visitor, ASTNode* node)
 {
     IfNode if_node = node->as.if_stmt;
 
-    LLVMValueRef condition = visit_expression(visitor, if_node.condition);
-    LLVMBasicBlockRef thenBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "then");
-    LLVMBasicBlockRef mergeBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "if_cont");
+    LLVMValueRef condition = build_truth_value(visitor, visit_expression(visitor, if_node.condition));
+    LLVMBasicBlockRef thenBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "then");
+    LLVMBasicBlockRef mergeBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "if_cont");
 
     LLVMBasicBlockRef elseBB = NULL;
     if (if_node.else_branch)
     {
-        elseBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "else");
+        elseBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "else");
         LLVMBuildCondBr(visitor->ctx->builder, condition, thenBB, elseBB);
     } 
     else {
@@ -55,27 +63,138 @@ void visit_if_stmt(CodegenVisitor* visitor, ASTNode* node)
     }
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, mergeBB);
+
+    // both arms left the block, so nothing after the if can run
+    if (LLVMGetFirstUse(LLVMBasicBlockAsValue(mergeBB)) == NULL)
+        LLVMBuildUnreachable(visitor->ctx->builder);
+}
+
+static int is_power_of_two(int value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+static LLVMMetadataRef build_loop_property(LLVMContextRef context, const char* name, LLVMValueRef value)
+{
+    LLVMMetadataRef operands[2];
+    operands[0] = LLVMMDStringInContext2(context, name, strlen(name));
+
+    if (value == NULL)
+        return LLVMMDNodeInContext2(context, operands, 1);
+
+    operands[1] = LLVMValueAsMetadata(value);
+    return LLVMMDNodeInContext2(context, operands, 2);
+}
+
+// hints the vectorizer would silently drop are reported here, the rest are checked by the optimizer's transform warnings
+static LoopHints validate_loop_hints(LoopHints hints)
+{
+    if (hints.vectorize_width > 0 && (!is_power_of_two(hints.vectorize_width) || hints.vectorize_width > MAX_LOOP_VECTORIZE_WIDTH)) {
+        report_diagnostic("Warning: vectorize(%d) ignored, the width must be a power of two up to %d\n", hints.vectorize_width, MAX_LOOP_VECTORIZE_WIDTH);
+        hints.vectorize_width = 0;
+    }
+
+    if (hints.interleave_count > 0 && (!is_power_of_two(hints.interleave_count) || hints.interleave_count > MAX_LOOP_INTERLEAVE_COUNT)) {
+        report_diagnostic("Warning: interleave(%d) ignored, the count must be a power of two up to %d\n", hints.interleave_count, MAX_LOOP_INTERLEAVE_COUNT);
+        hints.interleave_count = 0;
+    }
+    return hints;
+}
+
+// llvm.loop metadata lives on the latch branch
+void attach_loop_hints(CodegenVisitor* visitor, LLVMValueRef latch, LoopHints hints)
+{
+    hints = validate_loop_hints(hints);
+    if (latch == NULL || (hints.unroll_count == 0 && hints.vectorize_width == 0 && hints.interleave_count == 0))
+        return;
+
+    LLVMContextRef context = visitor->ctx->context;
+    LLVMTypeRef i32_type = LLVMInt32TypeInContext(context);
+    LLVMTypeRef i1_type = LLVMInt1TypeInContext(context);
+
+    LLVMMetadataRef operands[5];
+    int operand_count = 1;
+
+    if (hints.unroll_count > 0)
+        operands[operand_count++] = build_loop_property(context, "llvm.loop.unroll.count", LLVMConstInt(i32_type, hints.unroll_count, 0));
+
+    if (hints.vectorize_width > 0) {
+        int enable = hints.vectorize_width > 1;
+        operands[operand_count++] = build_loop_property(context, "llvm.loop.vectorize.enable", LLVMConstInt(i1_type, enable, 0));
+        if (enable)
+            operands[operand_count++] = build_loop_property(context, "llvm.loop.vectorize.width", LLVMConstInt(i32_type, hints.vectorize_width, 0));
+    }
+
+    if (hints.interleave_count > 0)
+        operands[operand_count++] = build_loop_property(context, "llvm.loop.interleave.count", LLVMConstInt(i32_type, hints.interleave_count, 0));
+
+    LLVMMetadataRef loop_id = build_distinct_metadata_node(visitor->ctx, operands, operand_count);
+
+    unsigned kind = LLVMGetMDKindIDInContext(context, "llvm.loop", strlen("llvm.loop"));
+    LLVMSetMetadata(latch, kind, LLVMMetadataAsValue(context, loop_id));
+}
+
+static int push_loop_targets(CodegenVisitor* visitor, LLVMBasicBlockRef break_block, LLVMBasicBlockRef continue_block)
+{
+    CodegenContext* ctx = visitor->ctx;
+    if (ctx->loop_depth >= MAX_LOOP_DEPTH) {
+        report_diagnostic("Codegen: Loops nested deeper than %d\n", MAX_LOOP_DEPTH);
+        return 0;
+    }
+
+    ctx->loop_targets[ctx->loop_depth++] = (LoopTargets) {
+        .break_block = break_block,
+        .continue_block = continue_block
+    };
+    return 1;
+}
+
+static void pop_loop_targets(CodegenVisitor* visitor)
+{
+    if (visitor->ctx->loop_depth > 0)
+        visitor->ctx->loop_depth--;
+}
+
+// statements after a return, break or continue are unreachable and are not emitted
+int is_block_terminated(CodegenVisitor* visitor)
+{
+    return LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(visitor->ctx->builder)) != NULL;
 }
 
 void visit_while_stmt(CodegenVisitor* visitor, ASTNode* node)
 {
     WhileNode while_node = node->as.while_stmt;
 
-    LLVMBasicBlockRef condBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "while_cond");
-    LLVMBasicBlockRef bodyBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "while_body");
-    LLVMBasicBlockRef afterBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "while_after");
+    LLVMBasicBlockRef condBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "while_cond");
+    LLVMBasicBlockRef bodyBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "while_body");
+    LLVMBasicBlockRef latchBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "while_latch");
+    LLVMBasicBlockRef afterBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "while_after");
 
     LLVMBuildBr(visitor->ctx->builder, condBB);
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, condBB);
-    LLVMValueRef cond_val = visit_expression(visitor, while_node.condition);
+    LLVMValueRef cond_val = build_truth_value(visitor, visit_expression(visitor, while_node.condition));
     LLVMBuildCondBr(visitor->ctx->builder, cond_val, bodyBB, afterBB);
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, bodyBB);
-    visit_block_stmt(visitor, while_node.body);
+    if (push_loop_targets(visitor, afterBB, latchBB)) {
+        visit_block_stmt(visitor, while_node.body);
+        pop_loop_targets(visitor);
+    }
+
+    // continue needs a shared latch so the loop keeps a single back edge for its hints
+    if (LLVMGetFirstUse(LLVMBasicBlockAsValue(latchBB)) != NULL) {
+        if (!is_block_terminated(visitor))
+            LLVMBuildBr(visitor->ctx->builder, latchBB);
+        LLVMPositionBuilderAtEnd(visitor->ctx->builder, latchBB);
+    }
+    else {
+        LLVMDeleteBasicBlock(latchBB);
+    }
 
-    if (LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(visitor->ctx->builder)) == NULL)
-        LLVMBuildBr(visitor->ctx->builder, condBB);
+    if (!is_block_terminated(visitor)) {
+        LLVMValueRef latch = LLVMBuildBr(visitor->ctx->builder, condBB);
+        attach_loop_hints(visitor, latch, while_node.hints);
+    }
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, afterBB);
 }
@@ -88,132 +207,238 @@ void visit_for_stmt(CodegenVisitor* visitor, ASTNode* node)
     if (for_node.init != NULL)
         visit_statement(visitor, for_node.init);
 
-    LLVMBasicBlockRef updBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "for_upd");
-    LLVMBasicBlockRef condBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "for_cond");
-    LLVMBasicBlockRef bodyBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "for_body");
-    LLVMBasicBlockRef afterBB = LLVMAppendBasicBlock(visitor->ctx->current_function, "for_after");
+    int tracks_induction = begin_bounds_loop(visitor, &node->as.for_stmt);
+
+    LLVMBasicBlockRef updBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "for_upd");
+    LLVMBasicBlockRef condBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "for_cond");
+    LLVMBasicBlockRef bodyBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "for_body");
+    LLVMBasicBlockRef afterBB = LLVMAppendBasicBlockInContext(visitor->ctx->context, visitor->ctx->current_function, "for_after");
 
     LLVMBuildBr(visitor->ctx->builder, condBB);
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, condBB);
-    LLVMValueRef cond_val = visit_expression(visitor, for_node.condition);
+    LLVMValueRef cond_val = build_truth_value(visitor, visit_expression(visitor, for_node.condition));
     LLVMBuildCondBr(visitor->ctx->builder, cond_val, bodyBB, afterBB);
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, bodyBB);
-    visit_block_stmt(visitor, for_node.body);
-    if (LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(visitor->ctx->builder)) == NULL)
+    if (push_loop_targets(visitor, afterBB, updBB)) {
+        visit_block_stmt(visitor, for_node.body);
+        pop_loop_targets(visitor);
+    }
+    if (!is_block_terminated(visitor))
         LLVMBuildBr(visitor->ctx->builder, updBB);
 
+    if (tracks_induction)
+        end_bounds_loop(visitor);
+
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, updBB);
     if (for_node.update != NULL)
         visit_statement(visitor, for_node.update);
 
-    LLVMBuildBr(visitor->ctx->builder, condBB);
+    LLVMValueRef latch = LLVMBuildBr(visitor->ctx->builder, condBB);
+    attach_loop_hints(visitor, latch, for_node.hints);
 
     LLVMPositionBuilderAtEnd(visitor->ctx->builder, afterBB);
     pop_scope(visitor->ctx->symbol_table);
 }
 
+void visit_break_stmt(CodegenVisitor* visitor, ASTNode* node)
+{
+    if (visitor->ctx->loop_depth == 0) {
+        report_diagnostic("Codegen: 'break' outside of a loop at line %d\n", locate_offset(visitor->ctx->lines, node->offset).line);
+        visitor->ctx->error_count++;
+        return;
+    }
+
+    LLVMBuildBr(visitor->ctx->builder, visitor->ctx->loop_targets[visitor->ctx->loop_depth - 1].break_block);
+}
+
+void visit_continue_stmt(CodegenVisitor* visitor, ASTNode* node)
+{
+    if (visitor->ctx->loop_depth == 0) {
+        report_diagnostic("Codegen: 'continue' outside of a loop at line %d\n", locate_offset(visitor->ctx->lines, node->offset).line);
+        visitor->ctx->error_count++;
+        return;
+    }
+
+    LLVMBuildBr(visitor->ctx->builder, visitor->ctx->loop_targets[visitor->ctx->loop_depth - 1].continue_block);
+}
+
 void visit_block_stmt(CodegenVisitor* visitor, ASTNode* node)
 {
     BlockNode block_node = node->as.block;
 
     push_scope(visitor->ctx->symbol_table);
-    for (int i = 0; i < block_node.statement_count; i++)
+    for (int i = 0; i < block_node.statement_count && !is_block_terminated(visitor); i++)
     {
         visit_statement(visitor, block_node.statements[i]);
     }
     pop_scope(visitor->ctx->symbol_table);
 }
 
-void assign_to_identifier(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val)
+void assign_to_identifier(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val, int from_unsigned)
 {
     const char* lhs_name = lhs->as.identifier.name;
     SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, lhs_name);
 
     if (entry == NULL) {
-        printf("Codegen: Undefined variable '%s'\n", lhs_name);
+        report_diagnostic("Codegen: Undefined variable '%s'\n", lhs_name);
         return;
     }
 
     if (entry->symbol_data.kind != SYMBOL_VARIABLE) {
-        printf("Codegen: '%s' is not a variable\n", lhs_name);
+        report_diagnostic("Codegen: '%s' is not a variable\n", lhs_name);
         return;
     }
 
-    LLVMBuildStore(visitor->ctx->builder, new_val, entry->symbol_data.as.variable.alloc);
+    if (reject_const_write(visitor, entry, lhs_name))
+        return;
+
+    VariableSymbolData var_data = entry->symbol_data.as.variable;
+    LLVMTypeRef var_type = var_data.is_global ? LLVMGlobalGetValueType(var_data.alloc) : LLVMGetAllocatedType(var_data.alloc);
+
+    new_val = coerce_value(visitor, new_val, var_type, from_unsigned);
+    LLVMBuildStore(visitor->ctx->builder, new_val, var_data.alloc);
 }
 
-void assign_to_dereference(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val)
+void assign_to_dereference(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val, int from_unsigned)
 {
     UnaryOpNode unary_node = lhs->as.unary_op;
     LLVMValueRef ptr = visit_expression(visitor, unary_node.operand);
     if (ptr == NULL)
         return;
 
-    LLVMBuildStore(visitor->ctx->builder, new_val, ptr);
+    TypeInfo pointee_info;
+    if (get_declared_type_info(visitor, lhs, &pointee_info))
+        new_val = coerce_value(visitor, new_val, build_type_from_info(visitor->ctx, &pointee_info), from_unsigned);
+
+    LLVMValueRef store = LLVMBuildStore(visitor->ctx->builder, new_val, ptr);
+    tag_restrict_access(visitor, store, unary_node.operand);
 }
 
-void assign_to_member_access(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val)
+void assign_to_member_access(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val, int from_unsigned)
 {
-    MemberAccessNode access_node = lhs->as.member_access;
-    if (access_node.object == NULL)
+    LLVMTypeRef member_type;
+    LLVMValueRef member_ptr = get_member_ptr(visitor, lhs, &member_type);
+    if (member_ptr == NULL)
         return;
-    
-    const char* member_name = access_node.member;
-    if (member_name == NULL && access_node.object->type != AST_IDENTIFIER) {
-        return;
-    }
 
-    const char* var_name = access_node.object->as.identifier.name;
-    SymbolEntry* var_entry = lookup_symbol(visitor->ctx->symbol_table, var_name);
-    TypeInfo var_type = var_entry->symbol_data.as.variable.type;
-    if (var_entry == NULL || var_entry->symbol_data.kind != SYMBOL_VARIABLE) {
-        return;
-    }
+    new_val = coerce_value(visitor, new_val, member_type, from_unsigned);
+    LLVMBuildStore(visitor->ctx->builder, new_val, member_ptr);
+}
+
+void assign_to_array_access(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val, int from_unsigned) {
+    ASTNode* target = lhs->as.array_access.target;
+    ASTNode* index_node = lhs->as.array_access.index;
 
-    const char* struct_type_name = var_type.type;
-    LLVMValueRef struct_ptr = var_entry->symbol_data.as.variable.alloc;
-    if (struct_ptr == NULL)
+    LLVMValueRef index_val = visit_expression(visitor, index_node);
+    if (index_val == NULL) 
         return;
 
-    LLVMTypeRef struct_type = lookup_struct_type(visitor->ctx->symbol_table, struct_type_name);
-    if (struct_type == NULL)
+    TypeInfo target_type;
+    if (get_declared_type_info(visitor, target, &target_type) && is_vector_info(&target_type)) {
+        assign_to_lane(visitor, target, index_val, new_val, from_unsigned);
         return;
+    }
 
-    int member_index = get_struct_member_index(visitor->ctx->symbol_table, struct_type_name, member_name);
-    if (member_index < 0)
+    LLVMTypeRef elem_type = NULL;
+    LLVMValueRef element_ptr = get_array_element_ptr(visitor, target, index_val, index_node, &elem_type);
+
+    if (element_ptr == NULL)
         return;
 
-    LLVMValueRef indices[2];
-    indices[0] = LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), 0, 0);
-    indices[1] = LLVMConstInt(LLVMInt32TypeInContext(visitor->ctx->context), member_index, 0);
+    new_val = coerce_value(visitor, new_val, elem_type, from_unsigned);
+    LLVMValueRef store = LLVMBuildStore(visitor->ctx->builder, new_val, element_ptr);
+    tag_restrict_access(visitor, store, target);
+}
 
-    LLVMValueRef member_ptr = LLVMBuildGEP2(
-        visitor->ctx->builder,
-        struct_type,
-        struct_ptr,
-        indices,
-        2,
-        "member_ptr"
-    );
+// the address an assignment stores to, base is the pointer operand restrict metadata is keyed on
+static LLVMValueRef get_assign_target_ptr(CodegenVisitor* visitor, ASTNode* lhs, LLVMTypeRef* out_type, ASTNode** base)
+{
+    *base = NULL;
 
-    LLVMBuildStore(visitor->ctx->builder, new_val, member_ptr);
+    switch (lhs->type) {
+        case AST_IDENTIFIER: {
+            const char* name = lhs->as.identifier.name;
+            SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, name);
+            if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE) {
+                report_diagnostic("Codegen: Undefined variable '%s'\n", name);
+                return NULL;
+            }
+            if (reject_const_write(visitor, entry, name))
+                return NULL;
+
+            VariableSymbolData var_data = entry->symbol_data.as.variable;
+            *out_type = var_data.is_global ? LLVMGlobalGetValueType(var_data.alloc) : LLVMGetAllocatedType(var_data.alloc);
+            return var_data.alloc;
+        }
+
+        case AST_UNARY_OP: {
+            TypeInfo pointee_info;
+            if (lhs->as.unary_op.op != OP_DEREF || !get_declared_type_info(visitor, lhs, &pointee_info))
+                return NULL;
+
+            *base = lhs->as.unary_op.operand;
+            *out_type = build_type_from_info(visitor->ctx, &pointee_info);
+            return visit_expression(visitor, lhs->as.unary_op.operand);
+        }
+
+        case AST_MEMBER_ACCESS:
+            return get_member_ptr(visitor, lhs, out_type);
+
+        case AST_ARRAY_ACCESS: {
+            LLVMValueRef index_val = visit_expression(visitor, lhs->as.array_access.index);
+            if (index_val == NULL)
+                return NULL;
+
+            *base = lhs->as.array_access.target;
+            return get_array_element_ptr(visitor, lhs->as.array_access.target, index_val, lhs->as.array_access.index, out_type);
+        }
+
+        default:
+            return NULL;
+    }
 }
 
-void assign_to_array_access(CodegenVisitor* visitor, ASTNode* lhs, LLVMValueRef new_val) {
-    ASTNode* target = lhs->as.array_access.target;
-    ASTNode* index_node = lhs->as.array_access.index;
+// a[i++] += k computes the element address once, then loads, applies op and stores through it
+static void visit_compound_assign(CodegenVisitor* visitor, AssignNode assign_node)
+{
+    ASTNode* lhs = assign_node.target;
+    ASTNode* rhs = assign_node.value;
+    LLVMBuilderRef builder = visitor->ctx->builder;
+
+    if (lhs->type == AST_ARRAY_ACCESS) {
+        TypeInfo target_type;
+        ASTNode* target = lhs->as.array_access.target;
+        if (get_declared_type_info(visitor, target, &target_type) && is_vector_info(&target_type)) {
+            LLVMValueRef index_val = visit_expression(visitor, lhs->as.array_access.index);
+            if (index_val != NULL)
+                compound_assign_to_lane(visitor, target, index_val, assign_node.op, rhs);
+            return;
+        }
+    }
 
-    LLVMValueRef index_val = visit_expression(visitor, index_node);
-    if (index_val == NULL) 
+    LLVMTypeRef target_type = NULL;
+    ASTNode* base = NULL;
+    LLVMValueRef target_ptr = get_assign_target_ptr(visitor, lhs, &target_type, &base);
+    if (target_ptr == NULL || target_type == NULL)
         return;
 
-    LLVMTypeRef elem_type = NULL;
-    LLVMValueRef element_ptr = get_array_element_ptr(visitor, target, index_val, &elem_type);
+    LLVMValueRef current = LLVMBuildLoad2(builder, target_type, target_ptr, "compound_load");
+    tag_restrict_access(visitor, current, base);
 
-    if (element_ptr == NULL)
+    LLVMValueRef value = visit_expression(visitor, rhs);
+    if (value == NULL)
+        return;
+
+    int target_unsigned = is_unsigned_expr(visitor, lhs);
+    int value_unsigned = is_unsigned_expr(visitor, rhs);
+    LLVMValueRef result = build_binary_values(visitor, assign_node.op, current, target_unsigned, value, value_unsigned);
+    if (result == NULL)
         return;
-    LLVMBuildStore(visitor->ctx->builder, new_val, element_ptr);
+
+    result = coerce_value(visitor, result, target_type, target_unsigned || value_unsigned);
+    LLVMValueRef store = LLVMBuildStore(builder, result, target_ptr);
+    tag_restrict_access(visitor, store, base);
 }
 
 void visit_assign_stmt(CodegenVisitor* visitor, ASTNode* node)
@@ -225,60 +450,122 @@ void visit_assign_stmt(CodegenVisitor* visitor, ASTNode* node)
     if (lhs == NULL || rhs == NULL) 
         return;
 
+    if (reject_const_store(visitor, lhs))
+        return;
+
+    TypeInfo target_info;
+    if (!assign_node.is_compound && get_declared_type_info(visitor, lhs, &target_info) && reject_const_escape(visitor, rhs, &target_info, "the assignment target"))
+        return;
+
+    if (assign_node.is_compound) {
+        visit_compound_assign(visitor, assign_node);
+        return;
+    }
+
     LLVMValueRef new_val = visit_expression(visitor, rhs);
     if (new_val == NULL)
         return;
 
+    int from_unsigned = is_unsigned_expr(visitor, rhs);
+
     switch (lhs->type) {
-        case AST_IDENTIFIER:    assign_to_identifier(visitor, lhs, new_val); break;
+        case AST_IDENTIFIER:    assign_to_identifier(visitor, lhs, new_val, from_unsigned); break;
         case AST_UNARY_OP:
             if (lhs->as.unary_op.op == OP_DEREF)
-                assign_to_dereference(visitor, lhs, new_val);
+                assign_to_dereference(visitor, lhs, new_val, from_unsigned);
             break;
 
-        case AST_MEMBER_ACCESS: assign_to_member_access(visitor, lhs, new_val); break;
-        case AST_ARRAY_ACCESS:  assign_to_array_access(visitor, lhs, new_val); break;
+        case AST_MEMBER_ACCESS: assign_to_member_access(visitor, lhs, new_val, from_unsigned); break;
+        case AST_ARRAY_ACCESS:  assign_to_array_access(visitor, lhs, new_val, from_unsigned); break;
         default: break;
     }
 }
 
-void visit_print_stmt(CodegenVisitor* visitor, ASTNode* node) {
-    LLVMValueRef value_to_print = visit_expression(visitor, node->as.print.expression);
-    if (value_to_print == NULL)
-        return;
-    
-    LLVMTypeRef type = LLVMTypeOf(value_to_print);
-    LLVMTypeKind type_kind = LLVMGetTypeKind(type);
-    
-    const char* format = "%d\n";
-    if (type_kind == LLVMIntegerTypeKind) {
-        format = "%d\n";
-    }
-    else if (type_kind == LLVMPointerTypeKind) {
-        format = "%s\n";
-    }
-    else if (type_kind == LLVMDoubleTypeKind) {
-        format = "%f\n";
-    }
-    else if (type_kind == LLVMFloatTypeKind) {
-        value_to_print = LLVMBuildFPExt(visitor->ctx->builder, value_to_print, LLVMDoubleTypeInContext(visitor->ctx->context), "promote_float");
-        format = "%f\n";
+void build_runtime_call(CodegenVisitor* visitor, const char* name, LLVMValueRef arg)
+{
+    LLVMTypeRef void_type = LLVMVoidTypeInContext(visitor->ctx->context);
+    LLVMTypeRef param_types[1];
+    int param_count = 0;
+
+    if (arg != NULL)
+        param_types[param_count++] = LLVMTypeOf(arg);
+
+    LLVMValueRef func = get_runtime_func(visitor->ctx, name, void_type, param_types, param_count);
+    LLVMBuildCall2(visitor->ctx->builder, LLVMGlobalGetValueType(func), func, &arg, param_count, "");
+}
+
+void emit_print_value(CodegenVisitor* visitor, LLVMValueRef value, int is_unsigned, int is_char)
+{
+    LLVMContextRef context = visitor->ctx->context;
+    LLVMBuilderRef builder = visitor->ctx->builder;
+
+    LLVMTypeRef type = LLVMTypeOf(value);
+    switch (LLVMGetTypeKind(type)) {
+        case LLVMIntegerTypeKind:
+            if (is_char) {
+                build_runtime_call(visitor, "ecl_rt_print_char", value);
+                return;
+            }
+
+            is_unsigned = is_unsigned || LLVMGetIntTypeWidth(type) == 1;
+            value = generate_cast_instruction(visitor, value, type, LLVMInt64TypeInContext(context), is_unsigned, 0, "print_ext");
+            build_runtime_call(visitor, is_unsigned ? "ecl_rt_print_u64" : "ecl_rt_print_i64", value);
+            return;
+
+        case LLVMFloatTypeKind:
+            value = LLVMBuildFPExt(builder, value, LLVMDoubleTypeInContext(context), "promote_float");
+            build_runtime_call(visitor, "ecl_rt_print_f64", value);
+            return;
+
+        case LLVMDoubleTypeKind:
+            build_runtime_call(visitor, "ecl_rt_print_f64", value);
+            return;
+
+        case LLVMPointerTypeKind: {
+            LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+            if (type == i8_ptr) {
+                build_runtime_call(visitor, "ecl_rt_print_str", value);
+                return;
+            }
+
+            value = LLVMBuildBitCast(builder, value, i8_ptr, "print_ptr");
+            build_runtime_call(visitor, "ecl_rt_print_ptr", value);
+            return;
+        }
+
+        case LLVMVectorTypeKind: {
+            unsigned lanes = LLVMGetVectorSize(type);
+            for (unsigned i = 0; i < lanes; i++) {
+                if (i > 0)
+                    build_runtime_call(visitor, "ecl_rt_print_sep", NULL);
+
+                LLVMValueRef lane_index = LLVMConstInt(LLVMInt32TypeInContext(context), i, 0);
+                emit_print_value(visitor, LLVMBuildExtractElement(builder, value, lane_index, "print_lane"), is_unsigned, is_char);
+            }
+            return;
+        }
+
+        default:
+            report_diagnostic("Codegen: Unsupported type in print\n");
+            return;
     }
+}
 
-    LLVMValueRef format_str = LLVMBuildGlobalStringPtr(visitor->ctx->builder, format, "print_fmt");
+void visit_print_stmt(CodegenVisitor* visitor, ASTNode* node) {
+    PrintNode print_node = node->as.print;
 
-    LLVMValueRef args[] = { format_str, value_to_print };
-    LLVMValueRef printf_func = get_printf_func(visitor->ctx);
+    for (int i = 0; i < print_node.expression_count; i++)
+    {
+        LLVMValueRef value_to_print = visit_expression(visitor, print_node.expressions[i]);
+        if (value_to_print == NULL)
+            return;
+
+        if (i > 0)
+            build_runtime_call(visitor, "ecl_rt_print_sep", NULL);
 
-    LLVMTypeRef param_types[] = { LLVMPointerType(LLVMInt8TypeInContext(visitor->ctx->context), 0) };
-    LLVMTypeRef printf_type = LLVMFunctionType(LLVMInt32TypeInContext(visitor->ctx->context), param_types, 1, 1);
+        ASTNode* expr = print_node.expressions[i];
+        emit_print_value(visitor, value_to_print, is_unsigned_expr(visitor, expr), is_char_expr(visitor, expr));
+    }
 
-    LLVMBuildCall2(
-        visitor->ctx->builder, 
-        LLVMGetElementType(LLVMTypeOf(printf_func)), 
-        printf_func, 
-        args, 
-        2, 
-        ""
-    );
+    build_runtime_call(visitor, "ecl_rt_print_newline", NULL);
 }
\ No newline at end of file
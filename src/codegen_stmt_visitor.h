@@ -3,11 +3,19 @@
 
 #include "codegen_visitor.h"
 
+// limits of the loop vectorizer, larger hints are dropped with a warning
+#define MAX_LOOP_VECTORIZE_WIDTH 64
+#define MAX_LOOP_INTERLEAVE_COUNT 16
+
 void visit_return_stmt(CodegenVisitor* visitor, ASTNode* node);
 void visit_if_stmt(CodegenVisitor* visitor, ASTNode* node);
 void visit_while_stmt(CodegenVisitor* visitor, ASTNode* node);
 void visit_for_stmt(CodegenVisitor* visitor, ASTNode* node);
 void visit_block_stmt(CodegenVisitor* visitor, ASTNode* node);
 void visit_assign_stmt(CodegenVisitor* visitor, ASTNode* node);
+void visit_break_stmt(CodegenVisitor* visitor, ASTNode* node);
+void visit_continue_stmt(CodegenVisitor* visitor, ASTNode* node);
+int is_block_terminated(CodegenVisitor* visitor);
+void attach_loop_hints(CodegenVisitor* visitor, LLVMValueRef latch, LoopHints hints);
 
 #endif
\ No newline at end of file
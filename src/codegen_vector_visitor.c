@@ -0,0 +1,323 @@
+#include "codegen_vector_visitor.h"
+#include "codegen_expr_visitor.h"
+#include "codegen_binary_unary_visitor.h"
+#include "diagnostics.h"
+#include "type_table.h"
+#include <stdio.h>
+#include <string.h>
+
+int is_vector_info(TypeInfo* type) {
+    return type->vector_width > 0 && type->pointer_level == 0 && !type->is_array;
+}
+
+// user functions with the same name shadow the builtins
+int is_vector_builtin(CodegenVisitor* visitor, const char* name) {
+    if (strcmp(name, "shuffle") != 0 && strcmp(name, "vload") != 0 && strcmp(name, "vstore") != 0)
+        return 0;
+
+    return LLVMGetNamedFunction(visitor->ctx->module, name) == NULL;
+}
+
+int get_vector_builtin_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out) {
+    FuncCallNode func_call = node->as.func_call;
+    if (!is_vector_builtin(visitor, func_call.name) || func_call.arg_count < 2)
+        return 0;
+
+    if (strcmp(func_call.name, "vload") == 0 && func_call.args[0]->type == AST_TYPE) {
+        *out = *get_type_info(func_call.args[0]->as.type_arg.type);
+        return 1;
+    }
+
+    if (strcmp(func_call.name, "shuffle") == 0 && get_declared_type_info(visitor, func_call.args[0], out)) {
+        int source_count = func_call.args[1]->type == AST_INT_LITERAL ? 1 : 2;
+        out->vector_width = func_call.arg_count - source_count;
+        return 1;
+    }
+
+    return 0;
+}
+
+static unsigned scalar_bits(LLVMTypeRef type) {
+    switch (LLVMGetTypeKind(type)) {
+        case LLVMIntegerTypeKind: return LLVMGetIntTypeWidth(type);
+        case LLVMFloatTypeKind:   return 32;
+        case LLVMDoubleTypeKind:  return 64;
+        default:                  return 8;
+    }
+}
+
+// natural alignment of the whole vector, reduced to a power of two for odd lane counts
+unsigned vector_alignment(LLVMTypeRef vector_type) {
+    unsigned bytes = LLVMGetVectorSize(vector_type) * scalar_bits(LLVMGetElementType(vector_type)) / 8;
+    if (bytes == 0)
+        return 1;
+
+    return bytes & -bytes;
+}
+
+LLVMValueRef build_splat(CodegenVisitor* visitor, LLVMValueRef scalar, LLVMTypeRef vector_type, int from_unsigned) {
+    LLVMBuilderRef builder = visitor->ctx->builder;
+    LLVMTypeRef i32_type = LLVMInt32TypeInContext(visitor->ctx->context);
+    LLVMTypeRef elem_type = LLVMGetElementType(vector_type);
+
+    LLVMTypeRef scalar_type = LLVMTypeOf(scalar);
+    if (scalar_type != elem_type) {
+        if (!are_types_compatible(scalar_type, elem_type) || LLVMGetTypeKind(scalar_type) == LLVMPointerTypeKind)
+            return NULL;
+
+        scalar = generate_cast_instruction(visitor, scalar, scalar_type, elem_type, from_unsigned, 0, "splat_cast");
+        if (scalar == NULL)
+            return NULL;
+    }
+
+    LLVMValueRef undef = LLVMGetUndef(vector_type);
+    LLVMValueRef inserted = LLVMBuildInsertElement(builder, undef, scalar, LLVMConstInt(i32_type, 0, 0), "splat_insert");
+    LLVMValueRef mask = LLVMConstNull(LLVMVectorType(i32_type, LLVMGetVectorSize(vector_type)));
+    return LLVMBuildShuffleVector(builder, inserted, undef, mask, "splat");
+}
+
+// v * 2.0f: a scalar operand is broadcast to the vector operand's type
+void splat_scalar_operand(CodegenVisitor* visitor, LLVMValueRef* left, int left_unsigned, LLVMValueRef* right, int right_unsigned) {
+    LLVMTypeRef left_type = LLVMTypeOf(*left);
+    LLVMTypeRef right_type = LLVMTypeOf(*right);
+
+    int left_vector = LLVMGetTypeKind(left_type) == LLVMVectorTypeKind;
+    int right_vector = LLVMGetTypeKind(right_type) == LLVMVectorTypeKind;
+
+    if (left_vector && !right_vector) {
+        LLVMValueRef splat = build_splat(visitor, *right, left_type, right_unsigned);
+        if (splat != NULL)
+            *right = splat;
+    }
+    else if (right_vector && !left_vector) {
+        LLVMValueRef splat = build_splat(visitor, *left, right_type, left_unsigned);
+        if (splat != NULL)
+            *left = splat;
+    }
+}
+
+static LLVMValueRef get_vector_storage_ptr(CodegenVisitor* visitor, ASTNode* target, LLVMTypeRef* out_vector_type) {
+    if (target->type == AST_IDENTIFIER) {
+        SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, target->as.identifier.name);
+        if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+            return NULL;
+
+        *out_vector_type = get_llvm_type(visitor->ctx, entry->symbol_data.as.variable.type);
+        return entry->symbol_data.as.variable.alloc;
+    }
+
+    if (target->type == AST_ARRAY_ACCESS) {
+        LLVMValueRef index_val = visit_expression(visitor, target->as.array_access.index);
+        if (index_val == NULL)
+            return NULL;
+
+        return get_array_element_ptr(visitor, target->as.array_access.target, index_val, target->as.array_access.index, out_vector_type);
+    }
+
+    return NULL;
+}
+
+// v[i] reads a single lane
+LLVMValueRef visit_lane_access(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val) {
+    LLVMValueRef vector = visit_expression(visitor, target);
+    if (vector == NULL || LLVMGetTypeKind(LLVMTypeOf(vector)) != LLVMVectorTypeKind)
+        return NULL;
+
+    return LLVMBuildExtractElement(visitor->ctx->builder, vector, index_val, "lane");
+}
+
+// v[i] = x replaces a single lane and stores the whole vector back
+void assign_to_lane(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, LLVMValueRef value, int from_unsigned) {
+    LLVMBuilderRef builder = visitor->ctx->builder;
+
+    LLVMTypeRef vector_type = NULL;
+    LLVMValueRef vector_ptr = get_vector_storage_ptr(visitor, target, &vector_type);
+    if (vector_ptr == NULL || vector_type == NULL || LLVMGetTypeKind(vector_type) != LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: Invalid vector lane assignment\n");
+        return;
+    }
+
+    value = coerce_value(visitor, value, LLVMGetElementType(vector_type), from_unsigned);
+    LLVMValueRef vector = LLVMBuildLoad2(builder, vector_type, vector_ptr, "vector_load");
+    LLVMValueRef updated = LLVMBuildInsertElement(builder, vector, value, index_val, "lane_insert");
+    LLVMBuildStore(builder, updated, vector_ptr);
+}
+
+// v[i] += x reads and writes the lane through one load of the vector
+void compound_assign_to_lane(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, BinaryOp op, ASTNode* value_node) {
+    LLVMBuilderRef builder = visitor->ctx->builder;
+
+    LLVMTypeRef vector_type = NULL;
+    LLVMValueRef vector_ptr = get_vector_storage_ptr(visitor, target, &vector_type);
+    if (vector_ptr == NULL || vector_type == NULL || LLVMGetTypeKind(vector_type) != LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: Invalid vector lane assignment\n");
+        return;
+    }
+
+    LLVMValueRef vector = LLVMBuildLoad2(builder, vector_type, vector_ptr, "vector_load");
+    LLVMValueRef lane = LLVMBuildExtractElement(builder, vector, index_val, "lane");
+
+    LLVMValueRef value = visit_expression(visitor, value_node);
+    if (value == NULL)
+        return;
+
+    int lane_unsigned = is_unsigned_expr(visitor, target);
+    int value_unsigned = is_unsigned_expr(visitor, value_node);
+    LLVMValueRef result = build_binary_values(visitor, op, lane, lane_unsigned, value, value_unsigned);
+    if (result == NULL)
+        return;
+
+    result = coerce_value(visitor, result, LLVMGetElementType(vector_type), lane_unsigned || value_unsigned);
+    LLVMValueRef updated = LLVMBuildInsertElement(builder, vector, result, index_val, "lane_insert");
+    LLVMBuildStore(builder, updated, vector_ptr);
+}
+
+// shuffle(a, 3, 2, 1, 0) or shuffle(a, b, 0, 4, 1, 5), lane indices must be integer literals
+static LLVMValueRef visit_shuffle(CodegenVisitor* visitor, FuncCallNode func_call) {
+    if (func_call.arg_count < 2) {
+        report_diagnostic("Codegen: shuffle expects a vector and lane indices\n");
+        return NULL;
+    }
+
+    LLVMValueRef first = visit_expression(visitor, func_call.args[0]);
+    if (first == NULL || LLVMGetTypeKind(LLVMTypeOf(first)) != LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: shuffle expects a vector operand\n");
+        return NULL;
+    }
+
+    LLVMTypeRef vector_type = LLVMTypeOf(first);
+    LLVMValueRef second = LLVMGetUndef(vector_type);
+    int source_count = 1;
+
+    if (func_call.args[1]->type != AST_INT_LITERAL) {
+        second = visit_expression(visitor, func_call.args[1]);
+        if (second == NULL || LLVMTypeOf(second) != vector_type) {
+            report_diagnostic("Codegen: shuffle operands must have the same vector type\n");
+            return NULL;
+        }
+        source_count = 2;
+    }
+
+    int mask_count = func_call.arg_count - source_count;
+    if (mask_count < 1 || mask_count > MAX_VECTOR_LANES) {
+        report_diagnostic("Codegen: shuffle expects between 1 and %d lane indices\n", MAX_VECTOR_LANES);
+        return NULL;
+    }
+
+    long long lane_limit = (long long)LLVMGetVectorSize(vector_type) * source_count;
+    LLVMTypeRef i32_type = LLVMInt32TypeInContext(visitor->ctx->context);
+    LLVMValueRef mask[mask_count];
+
+    for (int i = 0; i < mask_count; i++) {
+        ASTNode* lane = func_call.args[source_count + i];
+        if (lane->type != AST_INT_LITERAL || lane->as.int_literal.value < 0 || lane->as.int_literal.value >= lane_limit) {
+            report_diagnostic("Codegen: shuffle lane %d must be an integer literal below %lld\n", i, lane_limit);
+            return NULL;
+        }
+        mask[i] = LLVMConstInt(i32_type, lane->as.int_literal.value, 0);
+    }
+
+    return LLVMBuildShuffleVector(visitor->ctx->builder, first, second, LLVMConstVector(mask, mask_count), "shuffle");
+}
+
+// element alignment unless the access provably starts a lane group of an array we aligned ourselves:
+// a local or global array indexed by a constant multiple of the lane count
+static unsigned vector_access_alignment(CodegenVisitor* visitor, ASTNode* array, ASTNode* index, LLVMTypeRef vector_type) {
+    unsigned alignment = LLVMABIAlignmentOfType(visitor->ctx->target_data, LLVMGetElementType(vector_type));
+    if (array->type != AST_IDENTIFIER || index->type != AST_INT_LITERAL)
+        return alignment;
+
+    SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, array->as.identifier.name);
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE)
+        return alignment;
+
+    const TypeInfo* info = get_type_info(entry->symbol_data.as.variable.type);
+    if (!info->is_array || info->is_decayed || info->array_dim_count != 1)
+        return alignment;
+    if (index->as.int_literal.value % LLVMGetVectorSize(vector_type) != 0)
+        return alignment;
+
+    unsigned group_alignment = vector_alignment(vector_type);
+    if (group_alignment > VECTOR_ARRAY_ALIGNMENT)
+        group_alignment = VECTOR_ARRAY_ALIGNMENT;
+    return group_alignment > alignment ? group_alignment : alignment;
+}
+
+static LLVMValueRef get_vector_element_ptr(CodegenVisitor* visitor, ASTNode* array, ASTNode* index, LLVMTypeRef vector_type, unsigned* alignment) {
+    LLVMValueRef index_val = visit_expression(visitor, index);
+    if (index_val == NULL)
+        return NULL;
+
+    LLVMTypeRef elem_type = NULL;
+    LLVMValueRef elem_ptr = get_array_element_ptr(visitor, array, index_val, index, &elem_type);
+    if (elem_ptr == NULL || elem_type != LLVMGetElementType(vector_type)) {
+        report_diagnostic("Codegen: Vector element type does not match the array element type\n");
+        return NULL;
+    }
+
+    *alignment = vector_access_alignment(visitor, array, index, vector_type);
+    return LLVMBuildBitCast(visitor->ctx->builder, elem_ptr, LLVMPointerType(vector_type, 0), "vector_ptr");
+}
+
+// vload(float4, arr, i) reads arr[i .. i+3], any i is allowed
+static LLVMValueRef visit_vload(CodegenVisitor* visitor, FuncCallNode func_call) {
+    if (func_call.arg_count != 3 || func_call.args[0]->type != AST_TYPE) {
+        report_diagnostic("Codegen: vload expects (vector type, array, index)\n");
+        return NULL;
+    }
+
+    TypeInfo vector_info = *get_type_info(func_call.args[0]->as.type_arg.type);
+    if (!is_vector_info(&vector_info)) {
+        report_diagnostic("Codegen: vload expects a vector type\n");
+        return NULL;
+    }
+
+    LLVMTypeRef vector_type = build_type_from_info(visitor->ctx, &vector_info);
+    unsigned alignment = 1;
+    LLVMValueRef vector_ptr = get_vector_element_ptr(visitor, func_call.args[1], func_call.args[2], vector_type, &alignment);
+    if (vector_ptr == NULL)
+        return NULL;
+
+    LLVMValueRef load = LLVMBuildLoad2(visitor->ctx->builder, vector_type, vector_ptr, "vload");
+    LLVMSetAlignment(load, alignment);
+    tag_restrict_access(visitor, load, func_call.args[1]);
+    return load;
+}
+
+// vstore(arr, i, v) writes the lanes of v to arr[i ..], with the same alignment rule as vload
+static LLVMValueRef visit_vstore(CodegenVisitor* visitor, FuncCallNode func_call) {
+    if (func_call.arg_count != 3) {
+        report_diagnostic("Codegen: vstore expects (array, index, vector)\n");
+        return NULL;
+    }
+
+    LLVMValueRef vector = visit_expression(visitor, func_call.args[2]);
+    if (vector == NULL || LLVMGetTypeKind(LLVMTypeOf(vector)) != LLVMVectorTypeKind) {
+        report_diagnostic("Codegen: vstore expects a vector value\n");
+        return NULL;
+    }
+
+    LLVMTypeRef vector_type = LLVMTypeOf(vector);
+    unsigned alignment = 1;
+    LLVMValueRef vector_ptr = get_vector_element_ptr(visitor, func_call.args[0], func_call.args[1], vector_type, &alignment);
+    if (vector_ptr == NULL)
+        return NULL;
+
+    LLVMValueRef store = LLVMBuildStore(visitor->ctx->builder, vector, vector_ptr);
+    LLVMSetAlignment(store, alignment);
+    tag_restrict_access(visitor, store, func_call.args[0]);
+    return store;
+}
+
+LLVMValueRef visit_vector_builtin(CodegenVisitor* visitor, ASTNode* node) {
+    FuncCallNode func_call = node->as.func_call;
+
+    if (strcmp(func_call.name, "shuffle") == 0)
+        return visit_shuffle(visitor, func_call);
+    if (strcmp(func_call.name, "vload") == 0)
+        return visit_vload(visitor, func_call);
+    if (strcmp(func_call.name, "vstore") == 0)
+        return visit_vstore(visitor, func_call);
+
+    return NULL;
+}
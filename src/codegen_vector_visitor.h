@@ -0,0 +1,22 @@
+#ifndef CODEGEN_VECTOR_VISITOR_H
+#define CODEGEN_VECTOR_VISITOR_H
+
+#include "codegen_visitor.h"
+
+// local and global arrays get this alignment, vload/vstore only rely on it for constant lane-aligned indices
+#define VECTOR_ARRAY_ALIGNMENT 32
+
+int is_vector_info(TypeInfo* type);
+int is_vector_builtin(CodegenVisitor* visitor, const char* name);
+int get_vector_builtin_type_info(CodegenVisitor* visitor, ASTNode* node, TypeInfo* out);
+unsigned vector_alignment(LLVMTypeRef vector_type);
+
+LLVMValueRef build_splat(CodegenVisitor* visitor, LLVMValueRef scalar, LLVMTypeRef vector_type, int from_unsigned);
+void splat_scalar_operand(CodegenVisitor* visitor, LLVMValueRef* left, int left_unsigned, LLVMValueRef* right, int right_unsigned);
+
+LLVMValueRef visit_lane_access(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val);
+void assign_to_lane(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, LLVMValueRef value, int from_unsigned);
+void compound_assign_to_lane(CodegenVisitor* visitor, ASTNode* target, LLVMValueRef index_val, BinaryOp op, ASTNode* value_node);
+LLVMValueRef visit_vector_builtin(CodegenVisitor* visitor, ASTNode* node);
+
+#endif
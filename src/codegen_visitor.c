@@ -2,28 +2,120 @@
 #include "codegen_expr_visitor.h"
 #include "codegen_stmt_visitor.h"
 #include "codegen_decl_visitor.h"
+#include "codegen_arena_visitor.h"
+#include "codegen_bounds_visitor.h"
+#include "bounds_analysis.h"
+#include "stats.h"
 #include "parser.h"
+#include "diagnostics.h"
 #include <llvm-c/Analysis.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/DebugInfo.h>
 #include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-void init_codegen_context(CodegenContext* ctx, const char* module_name)
+// host target details are looked up once per process, the data layout needs a throwaway target machine
+typedef struct NativeTarget {
+    LLVMTargetRef target;
+    char* triple;
+    char* cpu;
+    char* features;
+    char* data_layout;
+} NativeTarget;
+
+static NativeTarget native_target;
+static pthread_once_t native_target_once = PTHREAD_ONCE_INIT;
+
+static void init_native_target(void)
 {
     LLVMInitializeNativeTarget();
     LLVMInitializeNativeAsmPrinter();
     LLVMInitializeNativeAsmParser();
 
-    ctx->context = LLVMContextCreate();
+    native_target.triple = LLVMGetDefaultTargetTriple();
+
+    char* error = NULL;
+    if (LLVMGetTargetFromTriple(native_target.triple, &native_target.target, &error) != 0) {
+        report_diagnostic("Codegen: No native target for '%s': %s\n", native_target.triple, error);
+        LLVMDisposeMessage(error);
+        native_target.target = NULL;
+        return;
+    }
+
+    native_target.cpu = LLVMGetHostCPUName();
+    native_target.features = LLVMGetHostCPUFeatures();
+
+    LLVMTargetMachineRef machine = create_native_target_machine();
+    LLVMTargetDataRef layout = LLVMCreateTargetDataLayout(machine);
+    native_target.data_layout = LLVMCopyStringRepOfTargetData(layout);
+
+    LLVMDisposeTargetData(layout);
+    LLVMDisposeTargetMachine(machine);
+}
+
+LLVMTargetMachineRef create_native_target_machine(void)
+{
+    if (native_target.target == NULL)
+        return NULL;
+
+    return LLVMCreateTargetMachine(native_target.target, native_target.triple, native_target.cpu, native_target.features,
+        LLVMCodeGenLevelDefault, LLVMRelocPIC, LLVMCodeModelDefault);
+}
+
+// without a triple and data layout the optimizer assumes no vector registers and generic type sizes
+static void set_native_target(CodegenContext* ctx)
+{
+    LLVMSetTarget(ctx->module, native_target.triple);
+    if (native_target.data_layout != NULL)
+        LLVMSetDataLayout(ctx->module, native_target.data_layout);
+}
+
+void prepare_native_target(void)
+{
+    pthread_once(&native_target_once, init_native_target);
+}
+
+void init_codegen_context(CodegenContext* ctx, const char* module_name, LLVMContextRef context)
+{
+    prepare_native_target();
+
+    ctx->owns_context = context == NULL;
+    ctx->context = context != NULL ? context : LLVMContextCreate();
     ctx->module = LLVMModuleCreateWithNameInContext(module_name, ctx->context);
     ctx->builder = LLVMCreateBuilderInContext(ctx->context);
     ctx->symbol_table = init_symbol_table();
     ctx->current_function = NULL;
+    ctx->lines = NULL;
+
+    set_native_target(ctx);
+    ctx->target_data = LLVMCreateTargetData(LLVMGetDataLayoutStr(ctx->module));
+    ctx->type_layouts = NULL;
+    ctx->type_layout_capacity = 0;
+
+    ctx->alias_domain = NULL;
+    ctx->alias_scope_count = 0;
+    ctx->loop_depth = 0;
+
+    ctx->options = (CodegenOptions) { 0 };
+    ctx->bounds_trap_block = NULL;
+    ctx->induction_depth = 0;
+    ctx->error_count = 0;
+    ctx->bounds_checks_kept = 0;
+    ctx->bounds_checks_removed = 0;
+    ctx->bounds_checks_hoisted = 0;
 }
 
 void cleanup_codegen_context(CodegenContext* ctx)
 {
+    if (ctx->target_data != NULL) {
+        LLVMDisposeTargetData(ctx->target_data);
+        ctx->target_data = NULL;
+    }
+
     if (ctx->builder != NULL) {
         LLVMDisposeBuilder(ctx->builder);
         ctx->builder = NULL;
@@ -34,13 +126,21 @@ void cleanup_codegen_context(CodegenContext* ctx)
         ctx->module = NULL;
     }
 
-    if (ctx->context != NULL) {
-        LLVMContextDispose(ctx->context);
-        ctx->context = NULL;
+    if (ctx->symbol_table != NULL) {
+        free_symbol_table(ctx->symbol_table);
+        ctx->symbol_table = NULL;
     }
+
+    free(ctx->type_layouts);
+    ctx->type_layouts = NULL;
+    ctx->type_layout_capacity = 0;
+
+    if (ctx->context != NULL && ctx->owns_context)
+        LLVMContextDispose(ctx->context);
+    ctx->context = NULL;
 }
 
-CodegenVisitor* create_codegen_visitor(const char* module_name) {
+CodegenVisitor* create_codegen_visitor(const char* module_name, LLVMContextRef context) {
     CodegenVisitor* visitor = (CodegenVisitor*)malloc(sizeof(CodegenVisitor));
     if (visitor == NULL) 
         return NULL;
@@ -51,7 +151,7 @@ CodegenVisitor* create_codegen_visitor(const char* module_name) {
         return NULL;
     }
 
-    init_codegen_context(visitor->ctx, module_name);
+    init_codegen_context(visitor->ctx, module_name, context);
 
     visitor->visit_int_literal = visit_int_literal_expr;
     visitor->visit_float_literal = visit_float_literal_expr;
@@ -63,6 +163,7 @@ CodegenVisitor* create_codegen_visitor(const char* module_name) {
     visitor->visit_unary_op = visit_unary_op_expr;
     visitor->visit_func_call = visit_func_call_expr;
     visitor->visit_cast = visit_cast_expr;
+    visitor->visit_ternary = visit_ternary_expr;
     visitor->visit_member_access = visit_member_access_expr;
     visitor->visit_array_access = visit_array_access_expr;
 
@@ -79,6 +180,8 @@ CodegenVisitor* create_codegen_visitor(const char* module_name) {
     visitor->visit_struct_decl = visit_struct_decl_decl;
     visitor->visit_program = visit_program_decl;
     visitor->visit_print = visit_print_stmt;
+    visitor->visit_break = visit_break_stmt;
+    visitor->visit_continue = visit_continue_stmt;
 
     return visitor;
 }
@@ -108,11 +211,12 @@ LLVMValueRef visit_expression(CodegenVisitor* visitor, ASTNode* node) {
         case AST_IDENTIFIER:        return visitor->visit_identifier(visitor, node);
         case AST_FUNC_CALL:         return visitor->visit_func_call(visitor, node);
         case AST_CAST:              return visitor->visit_cast(visitor, node);
+        case AST_TERNARY:           return visitor->visit_ternary(visitor, node);
         case AST_UNARY_OP:          return visitor->visit_unary_op(visitor, node);
         case AST_BINARY_OP:         return visitor->visit_binary_op(visitor, node);
         case AST_MEMBER_ACCESS:     return visitor->visit_member_access(visitor, node);
         case AST_ARRAY_ACCESS:      return visitor->visit_array_access(visitor, node);
-        default:                    printf("Unhandled expression type: %d\n", node->type); return NULL;
+        default:                    report_diagnostic("Unhandled expression type: %d\n", node->type); return NULL;
     }
 }
 
@@ -129,6 +233,8 @@ void visit_statement(CodegenVisitor* visitor, ASTNode* node) {
         case AST_WHILE:     visitor->visit_while(visitor, node); break;
         case AST_BLOCK:     visitor->visit_block(visitor, node); break;
         case AST_PRINT:     visitor->visit_print(visitor, node); break;
+        case AST_BREAK:     visitor->visit_break(visitor, node); break;
+        case AST_CONTINUE:  visitor->visit_continue(visitor, node); break;
         default:            visit_expression(visitor, node); break;
     }
 }
@@ -141,7 +247,7 @@ void visit_declaration(CodegenVisitor* visitor, ASTNode* node) {
         case AST_VAR_DECL: visitor->visit_var_decl(visitor, node); break;
         case AST_STRUCT_DECL: visitor->visit_struct_decl(visitor, node); break;
         case AST_PROGRAM: visitor->visit_program(visitor, node); break;
-        default: printf("Unhandled declaration type: %d\n", node->type); break;
+        default: report_diagnostic("Unhandled declaration type: %d\n", node->type); break;
     }
 }
 
@@ -156,11 +262,12 @@ LLVMTypeRef token_type_to_llvm_type(CodegenContext* ctx, TokenType type) {
         case TOK_CHAR:    return LLVMInt8TypeInContext(ctx->context);
         case TOK_UCHAR:   return LLVMInt8TypeInContext(ctx->context);
         case TOK_VOID:    return LLVMVoidTypeInContext(ctx->context);
+        case TOK_ARENA:   return get_arena_type(ctx);
         default:          return LLVMInt32TypeInContext(ctx->context);
     }
 }
 
-LLVMTypeRef build_type_from_info(CodegenContext* ctx, TypeInfo* type_info)
+LLVMTypeRef build_type_from_info(CodegenContext* ctx, const TypeInfo* type_info)
 {
     LLVMTypeRef base_type;
     if (type_info->base_type == TOK_IDENTIFIER)
@@ -171,28 +278,92 @@ LLVMTypeRef build_type_from_info(CodegenContext* ctx, TypeInfo* type_info)
         }
         base_type = struct_entry->symbol_data.as.struct_def.struct_type;
     } 
+    else if (type_info->bit_width > 0) {
+        base_type = LLVMIntTypeInContext(ctx->context, type_info->bit_width);
+    }
+    else if (type_info->base_type == TOK_VOID && type_info->pointer_level > 0) {
+        base_type = LLVMInt8TypeInContext(ctx->context);
+    }
     else {
         base_type = token_type_to_llvm_type(ctx, type_info->base_type);
     }
 
+    if (type_info->vector_width > 0) {
+        base_type = LLVMVectorType(base_type, type_info->vector_width);
+    }
+
     for (int i = 0; i < type_info->pointer_level; i++) {
         base_type = LLVMPointerType(base_type, 0);
     }
 
     if (type_info->is_array) {
-        for (int i = type_info->array_dim_count - 1; i >= 0; i--) {
+        int first_dim = type_info->is_decayed ? 1 : 0;
+        for (int i = type_info->array_dim_count - 1; i >= first_dim; i--) {
             base_type = LLVMArrayType(base_type, type_info->array_sizes[i]);
         }
+
+        if (type_info->is_decayed)
+            base_type = LLVMPointerType(base_type, 0);
     }
 
     return base_type;
 }
 
-LLVMTypeRef get_element_type_from_info(CodegenVisitor* visitor, TypeInfo type_info) {
+static TypeLayout* get_type_layout(CodegenContext* ctx, TypeId id)
+{
+    if (id == TYPE_ID_NONE)
+        return NULL;
+
+    if ((int)id >= ctx->type_layout_capacity) {
+        int capacity = ctx->type_layout_capacity == 0 ? 64 : ctx->type_layout_capacity;
+        while (capacity <= (int)id)
+            capacity *= 2;
+
+        TypeLayout* layouts = realloc(ctx->type_layouts, sizeof(TypeLayout) * capacity);
+        if (layouts == NULL)
+            return NULL;
+
+        memset(layouts + ctx->type_layout_capacity, 0, sizeof(TypeLayout) * (capacity - ctx->type_layout_capacity));
+        ctx->type_layouts = layouts;
+        ctx->type_layout_capacity = capacity;
+    }
+
+    // a struct that is not declared yet is not cached, a later lookup may find it
+    TypeLayout* layout = &ctx->type_layouts[id];
+    if (layout->type == NULL) {
+        layout->type = build_type_from_info(ctx, get_type_info(id));
+        if (layout->type != NULL && LLVMTypeIsSized(layout->type)) {
+            layout->size = LLVMABISizeOfType(ctx->target_data, layout->type);
+            layout->alignment = LLVMABIAlignmentOfType(ctx->target_data, layout->type);
+        }
+    }
+    return layout;
+}
+
+LLVMTypeRef get_llvm_type(CodegenContext* ctx, TypeId id)
+{
+    TypeLayout* layout = get_type_layout(ctx, id);
+    return layout != NULL ? layout->type : NULL;
+}
+
+unsigned long long get_type_size(CodegenContext* ctx, TypeId id)
+{
+    TypeLayout* layout = get_type_layout(ctx, id);
+    return layout != NULL ? layout->size : 0;
+}
+
+unsigned get_type_alignment(CodegenContext* ctx, TypeId id)
+{
+    TypeLayout* layout = get_type_layout(ctx, id);
+    return layout != NULL ? layout->alignment : 0;
+}
+
+TypeInfo get_element_info(TypeInfo type_info) {
     TypeInfo elem_info = type_info;
 
     if (elem_info.is_array)
     {
+        elem_info.is_decayed = 0;
         if (elem_info.array_dim_count > 1) {
             for (int i = 0; i < elem_info.array_dim_count - 1; i++) {
                 elem_info.array_sizes[i] = elem_info.array_sizes[i + 1];
@@ -207,47 +378,229 @@ LLVMTypeRef get_element_type_from_info(CodegenVisitor* visitor, TypeInfo type_in
     else if (elem_info.pointer_level > 0) {
         elem_info.pointer_level--;
     }
+    else if (elem_info.vector_width > 0) {
+        elem_info.vector_width = 0;
+    }
+    return elem_info;
+}
+
+LLVMTypeRef get_element_type_from_info(CodegenVisitor* visitor, TypeInfo type_info) {
+    TypeInfo elem_info = get_element_info(type_info);
     return build_type_from_info(visitor->ctx, &elem_info);
 }
 
-void generate_llvm_ir_visitor(ASTNode* ast, const char* module_name, const char* output_filename)
+// per-function IR sizes and module-level globals for --stats
+static void record_module_stats(CodegenContext* ctx)
 {
-    if (ast == NULL)
-        return;
+    for (LLVMValueRef function = LLVMGetFirstFunction(ctx->module); function != NULL; function = LLVMGetNextFunction(function)) {
+        if (LLVMCountBasicBlocks(function) == 0)
+            continue;
+
+        int instructions = 0;
+        int allocas = 0;
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block != NULL; block = LLVMGetNextBasicBlock(block)) {
+            for (LLVMValueRef inst = LLVMGetFirstInstruction(block); inst != NULL; inst = LLVMGetNextInstruction(inst)) {
+                instructions++;
+                if (LLVMGetInstructionOpcode(inst) == LLVMAlloca)
+                    allocas++;
+            }
+        }
+        record_function_stats(LLVMGetValueName(function), instructions, LLVMCountBasicBlocks(function), allocas);
+    }
 
-    CodegenVisitor* visitor = create_codegen_visitor(module_name);
-    if (visitor == NULL) {
-        printf("Failed to create codegen visitor\n");
-        return;
+    for (LLVMValueRef global = LLVMGetFirstGlobal(ctx->module); global != NULL; global = LLVMGetNextGlobal(global)) {
+        compile_stats.global_count++;
+        if (LLVMIsGlobalConstant(global))
+            compile_stats.constant_count++;
+    }
+}
+
+int generate_module(ASTNode* ast, const char* module_name, const CodegenOptions* options, LLVMContextRef context, CodegenVisitor** out_visitor, char** out_error)
+{
+    *out_visitor = create_codegen_visitor(module_name, context);
+    if (*out_visitor == NULL) {
+        report_diagnostic("Failed to create codegen visitor\n");
+        return 0;
     }
 
+    CodegenVisitor* visitor = *out_visitor;
+    if (options != NULL)
+        visitor->ctx->options = *options;
+
+    if (visitor->ctx->options.bounds_check)
+        analyze_counted_loops(ast);
+
     visit_declaration(visitor, ast);
+    record_module_stats(visitor->ctx);
+
+    if (visitor->ctx->options.bounds_check)
+        print_bounds_check_report(visitor->ctx);
+
+    if (visitor->ctx->error_count > 0) {
+        char message[64];
+        snprintf(message, sizeof(message), "code generation failed with %d error(s)", visitor->ctx->error_count);
+        if (out_error != NULL)
+            *out_error = LLVMCreateMessage(message);
+        else
+            report_diagnostic("%s\n", message);
+        return 0;
+    }
 
     char* error = NULL;
-    if (LLVMVerifyModule(visitor->ctx->module, LLVMPrintMessageAction, &error)) {
-        printf("Module verification failed: %s\n", error);
-        LLVMDisposeMessage(error);
+    if (LLVMVerifyModule(visitor->ctx->module, LLVMReturnStatusAction, &error)) {
+        if (out_error != NULL)
+            *out_error = error;
+        else {
+            report_diagnostic("Module verification failed: %s\n", error);
+            LLVMDisposeMessage(error);
+        }
+        return 0;
     }
 
+    LLVMDisposeMessage(error);
+    return 1;
+}
+
+// the module is still written when verification fails so the broken IR can be inspected
+int generate_llvm_ir_visitor(ASTNode* ast, const char* module_name, const char* output_filename, const CodegenOptions* options)
+{
+    if (ast == NULL)
+        return 0;
+
+    CodegenVisitor* visitor;
+    int verified = generate_module(ast, module_name, options, NULL, &visitor, NULL);
+    if (visitor == NULL)
+        return 0;
+
+    char* error = NULL;
     if (output_filename != NULL) {
         if (LLVMPrintModuleToFile(visitor->ctx->module, output_filename, &error)) {
             printf("Error writing to file: %s\n", error);
             LLVMDisposeMessage(error);
+            verified = 0;
         }
     }
 
     destroy_codegen_visitor(visitor);
+    return verified;
 }
 
-LLVMValueRef get_printf_func(CodegenContext* ctx) {
-    LLVMValueRef printf_func = LLVMGetNamedFunction(ctx->module, "printf");
+LLVMMemoryBufferRef emit_module_to_memory(LLVMModuleRef module, EmitKind kind, LLVMTargetMachineRef machine, char** out_error)
+{
+    switch (kind) {
+        case EMIT_IR: {
+            char* text = LLVMPrintModuleToString(module);
+            LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRangeCopy(text, strlen(text), "ir");
+            LLVMDisposeMessage(text);
+            return buffer;
+        }
+
+        case EMIT_BITCODE:
+            return LLVMWriteBitcodeToMemoryBuffer(module);
+
+        case EMIT_OBJECT: {
+            LLVMMemoryBufferRef buffer = NULL;
+            if (machine == NULL) {
+                *out_error = strdup("no native target machine");
+                return NULL;
+            }
 
-    if (printf_func != NULL)
-        return printf_func;
+            char* error = NULL;
+            if (LLVMTargetMachineEmitToMemoryBuffer(machine, module, LLVMObjectFile, &error, &buffer)) {
+                *out_error = strdup(error != NULL ? error : "object emission failed");
+                LLVMDisposeMessage(error);
+                return NULL;
+            }
+            return buffer;
+        }
+    }
 
-    LLVMTypeRef args[] = { LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0) };    
-    LLVMTypeRef func_type = LLVMFunctionType(LLVMInt32TypeInContext(ctx->context), args, 1, 1);
+    *out_error = strdup("unknown output kind");
+    return NULL;
+}
+
+// !prof weights, taken is the weight of the first successor
+void set_branch_weights(CodegenVisitor* visitor, LLVMValueRef branch, unsigned taken, unsigned not_taken) {
+    LLVMContextRef context = visitor->ctx->context;
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(context);
+
+    LLVMMetadataRef operands[3];
+    operands[0] = LLVMMDStringInContext2(context, "branch_weights", strlen("branch_weights"));
+    operands[1] = LLVMValueAsMetadata(LLVMConstInt(i32, taken, 0));
+    operands[2] = LLVMValueAsMetadata(LLVMConstInt(i32, not_taken, 0));
+
+    unsigned kind = LLVMGetMDKindIDInContext(context, "prof", strlen("prof"));
+    LLVMSetMetadata(branch, kind, LLVMMetadataAsValue(context, LLVMMDNodeInContext2(context, operands, 3)));
+}
+
+LLVMValueRef get_runtime_func(CodegenContext* ctx, const char* name, LLVMTypeRef return_type, LLVMTypeRef* param_types, int param_count) {
+    LLVMValueRef func = LLVMGetNamedFunction(ctx->module, name);
+
+    if (func != NULL)
+        return func;
+
+    LLVMTypeRef func_type = LLVMFunctionType(return_type, param_types, param_count, 0);
     
-    printf_func = LLVMAddFunction(ctx->module, "printf", func_type);
-    return printf_func;
-}
\ No newline at end of file
+    func = LLVMAddFunction(ctx->module, name, func_type);
+    return func;
+}
+// operands[0] is replaced by a reference to the node itself, as llvm.loop and alias scopes require
+LLVMMetadataRef build_distinct_metadata_node(CodegenContext* ctx, LLVMMetadataRef* operands, int operand_count)
+{
+    LLVMMetadataRef self = LLVMTemporaryMDNode(ctx->context, NULL, 0);
+    operands[0] = self;
+
+    LLVMMetadataRef node = LLVMMDNodeInContext2(ctx->context, operands, operand_count);
+    LLVMMetadataReplaceAllUsesWith(self, node);
+    return node;
+}
+
+LLVMMetadataRef create_alias_scope(CodegenContext* ctx, const char* name)
+{
+    if (ctx->alias_scope_count >= MAX_ALIAS_SCOPES)
+        return NULL;
+
+    if (ctx->alias_domain == NULL) {
+        const char* function_name = LLVMGetValueName(ctx->current_function);
+        LLVMMetadataRef domain_operands[2];
+        domain_operands[1] = LLVMMDStringInContext2(ctx->context, function_name, strlen(function_name));
+        ctx->alias_domain = build_distinct_metadata_node(ctx, domain_operands, 2);
+    }
+
+    LLVMMetadataRef scope_operands[3];
+    scope_operands[1] = ctx->alias_domain;
+    scope_operands[2] = LLVMMDStringInContext2(ctx->context, name, strlen(name));
+
+    LLVMMetadataRef scope = build_distinct_metadata_node(ctx, scope_operands, 3);
+    ctx->alias_scopes[ctx->alias_scope_count++] = scope;
+    return scope;
+}
+
+// loads and stores through a restrict local belong to its scope and do not alias the other restrict locals
+void tag_restrict_access(CodegenVisitor* visitor, LLVMValueRef access, ASTNode* base)
+{
+    if (access == NULL || base == NULL || base->type != AST_IDENTIFIER)
+        return;
+
+    SymbolEntry* entry = lookup_symbol(visitor->ctx->symbol_table, base->as.identifier.name);
+    if (entry == NULL || entry->symbol_data.kind != SYMBOL_VARIABLE || entry->symbol_data.as.variable.alias_scope == NULL)
+        return;
+
+    CodegenContext* ctx = visitor->ctx;
+    LLVMMetadataRef scope = entry->symbol_data.as.variable.alias_scope;
+
+    LLVMMetadataRef others[MAX_ALIAS_SCOPES];
+    int other_count = 0;
+    for (int i = 0; i < ctx->alias_scope_count; i++) {
+        if (ctx->alias_scopes[i] != scope)
+            others[other_count++] = ctx->alias_scopes[i];
+    }
+
+    unsigned scope_kind = LLVMGetMDKindIDInContext(ctx->context, "alias.scope", strlen("alias.scope"));
+    LLVMSetMetadata(access, scope_kind, LLVMMetadataAsValue(ctx->context, LLVMMDNodeInContext2(ctx->context, &scope, 1)));
+
+    if (other_count > 0) {
+        unsigned noalias_kind = LLVMGetMDKindIDInContext(ctx->context, "noalias", strlen("noalias"));
+        LLVMSetMetadata(access, noalias_kind, LLVMMetadataAsValue(ctx->context, LLVMMDNodeInContext2(ctx->context, others, other_count)));
+    }
+}
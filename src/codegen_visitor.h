@@ -4,18 +4,82 @@
 #include "ast_layout.h"
 #include "lookup_table.h"
 #include <llvm-c/Core.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
 #include <llvm-c/Types.h>
 
+#define MAX_ALIAS_SCOPES 64
+#define MAX_LOOP_DEPTH 64
+
 typedef struct CodegenVisitor CodegenVisitor;
 typedef struct CodegenContext CodegenContext;
 
+// break jumps to break_block, continue to continue_block
+typedef struct LoopTargets {
+    LLVMBasicBlockRef break_block;
+    LLVMBasicBlockRef continue_block;
+} LoopTargets;
+
+// a counted for loop whose induction variable is known to stay in [range->start, limit)
+typedef struct ActiveInduction {
+    const InductionRange* range;
+    long long limit;
+} ActiveInduction;
+
+// what a TypeId lowers to in one codegen context, type is NULL until first use
+typedef struct TypeLayout {
+    LLVMTypeRef type;
+    unsigned long long size;
+    unsigned alignment;
+} TypeLayout;
+
+typedef struct CodegenOptions {
+    int bounds_check;
+} CodegenOptions;
+
+typedef enum {
+    EMIT_IR,
+    EMIT_BITCODE,
+    EMIT_OBJECT
+} EmitKind;
+
 typedef struct CodegenContext {
     LLVMContextRef context;
+    // a context handed in by the caller (the compile server's pool) outlives the module
+    int owns_context;
     LLVMModuleRef module;
     LLVMBuilderRef builder;
 
     SymbolTable* symbol_table;
     LLVMValueRef current_function;
+    // source line starts of the program being compiled, for diagnostics only
+    const LineTable* lines;
+    LLVMTargetDataRef target_data;
+
+    // indexed by TypeId, LLVM types belong to this context and struct types to this module
+    TypeLayout* type_layouts;
+    int type_layout_capacity;
+
+    // one alias domain per function, one scope per restrict local
+    LLVMMetadataRef alias_domain;
+    LLVMMetadataRef alias_scopes[MAX_ALIAS_SCOPES];
+    int alias_scope_count;
+
+    // innermost loop last
+    LoopTargets loop_targets[MAX_LOOP_DEPTH];
+    int loop_depth;
+
+    CodegenOptions options;
+    // declarations that could not be lowered, the module is rejected even if it verifies
+    int error_count;
+
+    // --bounds-check: failed checks of a function share one trap block
+    LLVMBasicBlockRef bounds_trap_block;
+    ActiveInduction inductions[MAX_LOOP_DEPTH];
+    int induction_depth;
+    int bounds_checks_kept;
+    int bounds_checks_removed;
+    int bounds_checks_hoisted;
 } CodegenContext;
 
 typedef LLVMValueRef (*ExprVisitorFn)(CodegenVisitor*, ASTNode*);
@@ -35,6 +99,7 @@ typedef struct CodegenVisitor {
     ExprVisitorFn visit_unary_op;
     ExprVisitorFn visit_func_call;
     ExprVisitorFn visit_cast;
+    ExprVisitorFn visit_ternary;
     ExprVisitorFn visit_member_access;
     ExprVisitorFn visit_array_access;
 
@@ -45,6 +110,8 @@ typedef struct CodegenVisitor {
     StmtVisitorFn visit_block;
     StmtVisitorFn visit_assign;
     StmtVisitorFn visit_print;
+    StmtVisitorFn visit_break;
+    StmtVisitorFn visit_continue;
 
     DeclVisitorFn visit_var_decl;
     DeclVisitorFn visit_function;
@@ -52,10 +119,10 @@ typedef struct CodegenVisitor {
     DeclVisitorFn visit_program;
 } CodegenVisitor;
 
-void init_codegen_context(CodegenContext* ctx, const char* module_name);
+void init_codegen_context(CodegenContext* ctx, const char* module_name, LLVMContextRef context);
 void cleanup_codegen_context(CodegenContext* ctx);
 
-CodegenVisitor* create_codegen_visitor(const char* module_name);
+CodegenVisitor* create_codegen_visitor(const char* module_name, LLVMContextRef context);
 void destroy_codegen_visitor(CodegenVisitor* visitor);
 
 LLVMValueRef visit_expression(CodegenVisitor* visitor, ASTNode* node);
@@ -63,13 +130,31 @@ void visit_statement(CodegenVisitor* visitor, ASTNode* node);
 void visit_declaration(CodegenVisitor* visitor, ASTNode* node);
 
 LLVMTypeRef token_type_to_llvm_type(CodegenContext* ctx, TokenType type);
-LLVMTypeRef build_type_from_info(CodegenContext* ctx, TypeInfo* type_info);
+LLVMTypeRef build_type_from_info(CodegenContext* ctx, const TypeInfo* type_info);
+// cached per context, NULL for TYPE_ID_NONE and unknown struct names
+LLVMTypeRef get_llvm_type(CodegenContext* ctx, TypeId id);
+unsigned long long get_type_size(CodegenContext* ctx, TypeId id);
+unsigned get_type_alignment(CodegenContext* ctx, TypeId id);
+TypeInfo get_element_info(TypeInfo type_info);
 LLVMTypeRef get_element_type_from_info(CodegenVisitor* visitor, TypeInfo type_info);
 
-LLVMValueRef get_printf_func(CodegenContext* ctx);
+LLVMMetadataRef build_distinct_metadata_node(CodegenContext* ctx, LLVMMetadataRef* operands, int operand_count);
+LLVMMetadataRef create_alias_scope(CodegenContext* ctx, const char* name);
+void tag_restrict_access(CodegenVisitor* visitor, LLVMValueRef access, ASTNode* base);
+
+void set_branch_weights(CodegenVisitor* visitor, LLVMValueRef branch, unsigned taken, unsigned not_taken);
+LLVMValueRef get_runtime_func(CodegenContext* ctx, const char* name, LLVMTypeRef return_type, LLVMTypeRef* param_types, int param_count);
 void visit_print_stmt(CodegenVisitor* visitor, ASTNode* node);
 
-void generate_llvm_ir_visitor(ASTNode* ast, const char* module_name, const char* output_filename);
-LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, const char* name);
+// LLVM target initialization happens once per process, the first context does it unless called earlier
+void prepare_native_target(void);
+LLVMTargetMachineRef create_native_target_machine(void);
+
+// options may be NULL for the defaults, context NULL gives the module a context of its own;
+// returns 0 when verification fails, the visitor is still handed out and the message goes to out_error (printed when NULL)
+int generate_module(ASTNode* ast, const char* module_name, const CodegenOptions* options, LLVMContextRef context, CodegenVisitor** out_visitor, char** out_error);
+LLVMMemoryBufferRef emit_module_to_memory(LLVMModuleRef module, EmitKind kind, LLVMTargetMachineRef machine, char** out_error);
+int generate_llvm_ir_visitor(ASTNode* ast, const char* module_name, const char* output_filename, const CodegenOptions* options);
+LLVMValueRef generate_cast_instruction(CodegenVisitor* visitor, LLVMValueRef value, LLVMTypeRef from_type, LLVMTypeRef to_type, int from_unsigned, int to_unsigned, const char* name);
 
 #endif
\ No newline at end of file
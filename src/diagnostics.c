@@ -0,0 +1,60 @@
+#include "diagnostics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static _Thread_local Diagnostics* diagnostic_sink = NULL;
+
+static void append_diagnostic(Diagnostics* sink, const char* format, va_list args)
+{
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    if (length < 0)
+        return;
+
+    size_t needed = sink->length + (size_t)length + 1;
+    if (needed > sink->capacity) {
+        size_t capacity = sink->capacity > 0 ? sink->capacity : 256;
+        while (capacity < needed)
+            capacity *= 2;
+
+        char* text = realloc(sink->text, capacity);
+        if (text == NULL)
+            return;
+
+        sink->text = text;
+        sink->capacity = capacity;
+    }
+
+    vsnprintf(sink->text + sink->length, (size_t)length + 1, format, args);
+    sink->length += (size_t)length;
+    sink->count++;
+}
+
+void report_diagnostic(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if (diagnostic_sink != NULL)
+        append_diagnostic(diagnostic_sink, format, args);
+    else
+        vprintf(format, args);
+
+    va_end(args);
+}
+
+Diagnostics* set_diagnostic_sink(Diagnostics* sink)
+{
+    Diagnostics* previous = diagnostic_sink;
+    diagnostic_sink = sink;
+    return previous;
+}
+
+void free_diagnostics(Diagnostics* diagnostics)
+{
+    free(diagnostics->text);
+    *diagnostics = (Diagnostics) { 0 };
+}
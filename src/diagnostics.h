@@ -0,0 +1,21 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stddef.h>
+
+// parse and codegen messages go to stdout unless the current thread has a sink installed
+
+typedef struct Diagnostics {
+    char* text;
+    size_t length;
+    size_t capacity;
+    int count;
+} Diagnostics;
+
+void report_diagnostic(const char* format, ...);
+
+// returns the previously installed sink, NULL restores stdout
+Diagnostics* set_diagnostic_sink(Diagnostics* sink);
+void free_diagnostics(Diagnostics* diagnostics);
+
+#endif
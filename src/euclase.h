@@ -0,0 +1,42 @@
+#ifndef EUCLASE_H
+#define EUCLASE_H
+
+#include <llvm-c/Core.h>
+#include <stddef.h>
+
+// embedding API, compiles sources held in memory without touching the file system
+
+// defined in codegen_visitor.h, hosts that only pass NULL for the defaults never need its layout
+typedef struct CodegenOptions CodegenOptions;
+
+typedef enum {
+    EUCLASE_OUTPUT_MODULE,
+    EUCLASE_OUTPUT_IR,
+    EUCLASE_OUTPUT_BITCODE,
+    EUCLASE_OUTPUT_OBJECT
+} EuclaseOutputKind;
+
+typedef struct EuclaseSession EuclaseSession;
+
+typedef struct EuclaseResult {
+    int ok;
+    // EUCLASE_OUTPUT_MODULE: the module and the context that owns it, both released by euclase_result_free
+    LLVMModuleRef module;
+    LLVMContextRef context;
+    // every other output kind
+    LLVMMemoryBufferRef output;
+    // everything the lexer, parser and codegen reported, never NULL
+    char* diagnostics;
+    int diagnostic_count;
+} EuclaseResult;
+
+// a session is not thread safe, hosts compiling in parallel use one session per thread
+EuclaseSession* euclase_session_create(const CodegenOptions* options);
+void euclase_session_destroy(EuclaseSession* session);
+// options applied to every following compile, may be changed between compiles
+CodegenOptions* euclase_session_options(EuclaseSession* session);
+
+EuclaseResult* euclase_compile(EuclaseSession* session, const char* module_name, const char* source, size_t length, EuclaseOutputKind kind);
+void euclase_result_free(EuclaseResult* result);
+
+#endif
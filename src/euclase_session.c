@@ -0,0 +1,161 @@
+#include "euclase.h"
+#include "codegen_visitor.h"
+#include "diagnostics.h"
+#include "lexer_parallel.h"
+#include "parser_parallel.h"
+#include "stats.h"
+#include "type_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct EuclaseSession {
+    CodegenOptions options;
+    LLVMTargetMachineRef machine;
+};
+
+EuclaseSession* euclase_session_create(const CodegenOptions* options)
+{
+    EuclaseSession* session = calloc(1, sizeof(EuclaseSession));
+    if (session == NULL)
+        return NULL;
+
+    if (options != NULL)
+        session->options = *options;
+
+    prepare_lexer_tables();
+    prepare_native_target();
+    return session;
+}
+
+void euclase_session_destroy(EuclaseSession* session)
+{
+    if (session == NULL)
+        return;
+
+    if (session->machine != NULL)
+        LLVMDisposeTargetMachine(session->machine);
+
+    free(session);
+}
+
+CodegenOptions* euclase_session_options(EuclaseSession* session)
+{
+    return &session->options;
+}
+
+static EmitKind get_emit_kind(EuclaseOutputKind kind)
+{
+    switch (kind) {
+        case EUCLASE_OUTPUT_BITCODE: return EMIT_BITCODE;
+        case EUCLASE_OUTPUT_OBJECT: return EMIT_OBJECT;
+        default: return EMIT_IR;
+    }
+}
+
+static void compile_into_result(EuclaseSession* session, EuclaseResult* result, const char* module_name, const char* source, EuclaseOutputKind kind)
+{
+    Tokens* tokens = tokenize_parallel(source, 0, 0);
+    if (tokens == NULL)
+        return;
+
+    Parser parser;
+    init_parser(&parser, tokens);
+    ASTNode* program = parse_program_parallel(&parser, 0);
+
+    if (program == NULL || parser.error_count > 0) {
+        report_diagnostic("Parse failed with %d error(s)\n", parser.error_count > 0 ? parser.error_count : 1);
+        free_ast(program);
+        free_tokens(tokens);
+        return;
+    }
+
+    // every compile gets a fresh context, named struct types left in a used one would pick up suffixes
+    LLVMContextRef context = LLVMContextCreate();
+    CodegenVisitor* visitor = NULL;
+
+    if (generate_module(program, module_name, &session->options, context, &visitor, NULL)) {
+        if (kind == EUCLASE_OUTPUT_MODULE) {
+            // the module leaves with its context, the visitor must not dispose it
+            result->module = visitor->ctx->module;
+            result->context = context;
+            visitor->ctx->module = NULL;
+            context = NULL;
+            result->ok = 1;
+        }
+        else {
+            if (kind == EUCLASE_OUTPUT_OBJECT && session->machine == NULL)
+                session->machine = create_native_target_machine();
+
+            char* error = NULL;
+            result->output = emit_module_to_memory(visitor->ctx->module, get_emit_kind(kind), session->machine, &error);
+            if (result->output != NULL)
+                result->ok = 1;
+            else {
+                report_diagnostic("Codegen: %s\n", error != NULL ? error : "emission failed");
+                free(error);
+            }
+        }
+    }
+
+    destroy_codegen_visitor(visitor);
+    if (context != NULL)
+        LLVMContextDispose(context);
+
+    free_ast(program);
+    free_tokens(tokens);
+}
+
+EuclaseResult* euclase_compile(EuclaseSession* session, const char* module_name, const char* source, size_t length, EuclaseOutputKind kind)
+{
+    EuclaseResult* result = calloc(1, sizeof(EuclaseResult));
+    if (result == NULL)
+        return NULL;
+
+    // the lexer reads up to a terminating NUL, buffers from the host are not required to have one
+    char* code = malloc(length + 1);
+    if (code == NULL) {
+        result->diagnostics = strdup("");
+        return result;
+    }
+    memcpy(code, source, length);
+    code[length] = '\0';
+
+    Diagnostics diagnostics = { 0 };
+    Diagnostics* previous_sink = set_diagnostic_sink(&diagnostics);
+
+    // the types of one compile are freed with it, a long lived host would otherwise fill the table
+    TypeTable* types = create_type_table();
+    if (types != NULL) {
+        TypeTable* previous_types = set_current_type_table(types);
+        reset_compile_stats();
+        compile_into_result(session, result, module_name != NULL ? module_name : "main", code, kind);
+        set_current_type_table(previous_types);
+        free_type_table(types);
+    }
+    else
+        report_diagnostic("Out of memory creating the type table\n");
+
+    set_diagnostic_sink(previous_sink);
+
+    result->diagnostics = diagnostics.text != NULL ? diagnostics.text : strdup("");
+    result->diagnostic_count = diagnostics.count;
+
+    free(code);
+    return result;
+}
+
+void euclase_result_free(EuclaseResult* result)
+{
+    if (result == NULL)
+        return;
+
+    if (result->module != NULL)
+        LLVMDisposeModule(result->module);
+    if (result->context != NULL)
+        LLVMContextDispose(result->context);
+    if (result->output != NULL)
+        LLVMDisposeMemoryBuffer(result->output);
+
+    free(result->diagnostics);
+    free(result);
+}
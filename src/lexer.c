@@ -1,22 +1,68 @@
 #include "lexer.h"
 #include "string_view.h"
 #include "token.h"
+#include "stats.h"
+#include "diagnostics.h"
 #include <ctype.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-Token make_token(TokenType type, StringView lexeme, int line, int column) {
+_Static_assert(TOK_COUNT <= 256, "token types must fit the 8 bit Token.type field");
+
+// a lexeme that does not fit the 24 bit length becomes an error token with length 0, see describe_lex_error
+Token make_token(TokenType type, uint32_t offset, size_t length) {
     Token t;
-    memset(&t, 0, sizeof(t));
-    
+    t.offset = offset;
+    if (length > MAX_TOKEN_LENGTH) {
+        t.type = TOK_ERROR;
+        t.length = 0;
+        return t;
+    }
+
     t.type = type;
-    t.lexeme = lexeme;
-    t.line = line;
-    t.column = column;
+    t.length = (uint32_t)length;
     return t;
 }
 
+StringView token_lexeme(const Tokens* tokens, const Token* token) {
+    return sv_from_parts(tokens->source + token->offset, token->length);
+}
+
+static int add_line_start(LineTable* lines, uint32_t offset) {
+    if (lines->count >= lines->capacity) {
+        int new_capacity = lines->capacity > 0 ? lines->capacity * 2 : INITIAL_CAPACITY;
+        uint32_t* new_starts = realloc(lines->starts, new_capacity * sizeof(uint32_t));
+        if (new_starts == NULL)
+            return 0;
+
+        lines->starts = new_starts;
+        lines->capacity = new_capacity;
+    }
+
+    lines->starts[lines->count++] = offset;
+    return 1;
+}
+
+// binary search for the last line starting at or before offset
+SourceLocation locate_offset(const LineTable* lines, uint32_t offset) {
+    if (lines == NULL || lines->count == 0)
+        return (SourceLocation) { 1, (int)offset + 1 };
+
+    int low = 0;
+    int high = lines->count - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (lines->starts[mid] <= offset)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    return (SourceLocation) { low + 1, (int)(offset - lines->starts[low]) + 1 };
+}
+
 Tokens* create_tokens() 
 {
     Tokens* tokens = malloc(sizeof(Tokens));
@@ -31,6 +77,13 @@ Tokens* create_tokens()
     
     tokens->token_count = 0;
     tokens->capacity = INITIAL_CAPACITY;
+    tokens->source = NULL;
+    tokens->lines = (LineTable) { 0 };
+    if (!add_line_start(&tokens->lines, 0)) {
+        free(tokens->tokens);
+        free(tokens);
+        return NULL;
+    }
     return tokens;
 }
 
@@ -58,45 +111,58 @@ void free_tokens(Tokens* tokens) {
     if (tokens == NULL)
         return;
     
+    free(tokens->lines.starts);
     free(tokens->tokens);
     free(tokens);
 }
 
+// the tries are read-only once built, every lexer in the process shares one copy
+static TrieNode* shared_keyword_trie = NULL;
+static TrieNode* shared_operator_trie = NULL;
+static pthread_once_t lexer_tables_once = PTHREAD_ONCE_INIT;
+
+static void build_lexer_tables(void) {
+    shared_keyword_trie = create_trie_node();
+    shared_operator_trie = create_trie_node();
+    build_operator_trie(shared_operator_trie);
+    build_keyword_trie(shared_keyword_trie);
+}
+
+void prepare_lexer_tables(void) {
+    pthread_once(&lexer_tables_once, build_lexer_tables);
+}
+
 void init_lexer(Lexer* lexer, const char* source) {
     lexer->source = source;
     lexer->position = 0;
-    lexer->line = 1;
-    lexer->column = 1;
+    lexer->lines = NULL;
+    lexer->lines_failed = 0;
 
-    lexer->keywords_trie = create_trie_node();
-    lexer->operator_trie = create_trie_node();
-    build_operator_trie(lexer->operator_trie);
-    build_keyword_trie(lexer->keywords_trie);
+    prepare_lexer_tables();
+    lexer->keywords_trie = shared_keyword_trie;
+    lexer->operator_trie = shared_operator_trie;
 }
 
 void cleanup_lexer(Lexer* lexer) {
-    if (lexer->keywords_trie)
-    {
-        free_trie(lexer->keywords_trie);
-        lexer->keywords_trie = NULL;
-    }
+    lexer->keywords_trie = NULL;
+    lexer->operator_trie = NULL;
+}
 
-    if (lexer->operator_trie)
-    {
-        free_trie(lexer->operator_trie);
-        lexer->operator_trie = NULL;
-    }
+// newlines are only recorded where they can occur, whitespace, block comments and literals
+static void note_newline(Lexer* lexer) {
+    if (lexer->lines != NULL && !add_line_start(lexer->lines, (uint32_t)lexer->position))
+        lexer->lines_failed = 1;
 }
 
 void skip_whitespaces(Lexer* lexer) {
     while (peek(lexer) == ' ' || peek(lexer) == '\t' || peek(lexer) == '\n' || peek(lexer) == '\r') {
-        get(lexer);
+        if (get(lexer) == '\n')
+            note_newline(lexer);
     }
 }
 
 Token lex_number(Lexer* lexer) {
-    const int line = lexer->line;
-    const int col = lexer->column;
+    const int start_position = lexer->position;
     const char* start = &lexer->source[lexer->position];
 
     int has_dot = 0;
@@ -114,9 +180,11 @@ Token lex_number(Lexer* lexer) {
     if (next == 'f' || next == 'F' || next == 'd' || next == 'D') {
         suffix = get(lexer);
     }
+    else if (!has_dot && (next == 'u' || next == 'U')) {
+        get(lexer);
+    }
     
     size_t length = (size_t)(&lexer->source[lexer->position] - start);
-    StringView lexeme = sv_from_parts(start, length);
 
     TokenType type = TOK_NUMBER_INT;
     if (has_dot || suffix != '\0') {
@@ -126,47 +194,46 @@ Token lex_number(Lexer* lexer) {
             type = TOK_NUMBER_DOUBLE;
     }
 
-    return make_token(type, lexeme, line, col);
+    return make_token(type, start_position, length);
 }
 
 Token lex_string_literal(Lexer* lexer) {
-    const int line = lexer->line;
-    const int col = lexer->column;
+    const int start_position = lexer->position;
     
     get(lexer);
-    const char* start = &lexer->source[lexer->position];
     
     while (peek(lexer) != '"' && peek(lexer) != '\0') {
-        get(lexer);
+        if (get(lexer) == '\n')
+            note_newline(lexer);
     }
     
+    // the lexeme excludes the quotes
     if (peek(lexer) == '"') {
-        StringView lexeme = sv_from_parts(start, &lexer->source[lexer->position] - start);
+        Token token = make_token(TOK_STRING_LITERAL, start_position + 1, lexer->position - start_position - 1);
         get(lexer);
-        return make_token(TOK_STRING_LITERAL, lexeme, line, col);
+        return token;
     }
 
-    return make_token(TOK_ERROR, sv_from_cstr("invalid string literal"), line, col);
+    return make_token(TOK_ERROR, start_position, lexer->position - start_position);
 }
 
 Token lex_char_literal(Lexer* lexer) {
-    const int line = lexer->line;
-    const int col = lexer->column;
+    const int start_position = lexer->position;
     
     get(lexer);
-    const char* start = &lexer->source[lexer->position];
     
     if (peek(lexer) != '\'' && peek(lexer) != '\0') {
-        get(lexer);
+        if (get(lexer) == '\n')
+            note_newline(lexer);
     }
     
     if (peek(lexer) == '\'') {
-        StringView lexeme = sv_from_parts(start, &lexer->source[lexer->position] - start);
+        Token token = make_token(TOK_CHAR_LITERAL, start_position + 1, lexer->position - start_position - 1);
         get(lexer);
-        return make_token(TOK_CHAR_LITERAL, lexeme, line, col);
+        return token;
     }
 
-    return make_token(TOK_ERROR, sv_from_cstr("invalid char literal"), line, col);
+    return make_token(TOK_ERROR, start_position, lexer->position - start_position);
 }
 
 TrieMatch trie_match(TrieNode* root, Lexer* lexer)
@@ -202,28 +269,70 @@ TrieMatch trie_match(TrieNode* root, Lexer* lexer)
 }
 
 Token lex_operator_trie(Lexer* lexer, TrieNode* trie_root) {
-    const int line = lexer->line;
-    const int col = lexer->column;
-    const char* start = &lexer->source[lexer->position];
-    
+    const int start_position = lexer->position;
     TrieMatch match = trie_match(trie_root, lexer);
     
     if (match.type == TOK_NONE || match.length == 0) {
         get(lexer);
-        return make_token(TOK_ERROR, sv_from_parts(start, 1), line, col);
+        return make_token(TOK_ERROR, start_position, 1);
     }
 
-    for (int i = 0; i < match.length; i++) {
-        get(lexer);
+    lexer->position += match.length;
+    return make_token(match.type, start_position, match.length);
+}
+
+// int<N> / uint<N> are sized integer types, the width is read back from the lexeme by the parser
+int is_sized_int_type(StringView lexeme) {
+    size_t i = 0;
+    if (lexeme.length > 0 && lexeme.data[0] == 'u')
+        i = 1;
+
+    if (lexeme.length < i + 4 || strncmp(lexeme.data + i, "int", 3) != 0)
+        return 0;
+
+    for (i += 3; i < lexeme.length; i++) {
+        if (!isdigit((unsigned char)lexeme.data[i]))
+            return 0;
     }
-    
-    StringView lexeme = sv_from_parts(start, match.length);
-    return make_token(match.type, lexeme, line, col);
+    return 1;
+}
+
+static int is_digit_run(StringView lexeme, size_t start, size_t end) {
+    if (start >= end)
+        return 0;
+
+    for (size_t i = start; i < end; i++) {
+        if (!isdigit((unsigned char)lexeme.data[i]))
+            return 0;
+    }
+    return 1;
+}
+
+// float<N>, double<N> and [u]int<W>x<N> name vector types, returns the element token or TOK_NONE
+TokenType vector_type_base(StringView lexeme) {
+    if (lexeme.length > 5 && strncmp(lexeme.data, "float", 5) == 0 && is_digit_run(lexeme, 5, lexeme.length))
+        return TOK_FLOAT;
+
+    if (lexeme.length > 6 && strncmp(lexeme.data, "double", 6) == 0 && is_digit_run(lexeme, 6, lexeme.length))
+        return TOK_DOUBLE;
+
+    size_t start = (lexeme.length > 0 && lexeme.data[0] == 'u') ? 1 : 0;
+    if (lexeme.length < start + 3 || strncmp(lexeme.data + start, "int", 3) != 0)
+        return TOK_NONE;
+
+    const char* x = memchr(lexeme.data, 'x', lexeme.length);
+    if (x == NULL)
+        return TOK_NONE;
+
+    size_t x_pos = (size_t)(x - lexeme.data);
+    if (!is_digit_run(lexeme, start + 3, x_pos) || !is_digit_run(lexeme, x_pos + 1, lexeme.length))
+        return TOK_NONE;
+
+    return start == 1 ? TOK_UINT : TOK_INT;
 }
 
 Token lex_identifier_or_keyword(Lexer* lexer, TrieNode* keyword_trie) {
-    const int line = lexer->line;
-    const int col = lexer->column;
+    const int start_position = lexer->position;
     const char* start = &lexer->source[lexer->position];
 
     while (isalnum(peek(lexer)) || peek(lexer) == '_') {
@@ -246,22 +355,28 @@ Token lex_identifier_or_keyword(Lexer* lexer, TrieNode* keyword_trie) {
     }
     
     if (matched_length == lexeme.length && current->is_terminal) {
-        return make_token(current->token_type, lexeme, line, col);
+        return make_token(current->token_type, start_position, lexeme.length);
+    }
+
+    if (is_sized_int_type(lexeme)) {
+        return make_token(lexeme.data[0] == 'u' ? TOK_UINT : TOK_INT, start_position, lexeme.length);
+    }
+
+    TokenType vector_base = vector_type_base(lexeme);
+    if (vector_base != TOK_NONE) {
+        return make_token(vector_base, start_position, lexeme.length);
     }
     
-    return make_token(TOK_IDENTIFIER, lexeme, line, col);
+    return make_token(TOK_IDENTIFIER, start_position, lexeme.length);
 }
 
 Token lex_next_token(Lexer* lexer) {
     skip_whitespace_and_comments(lexer);
-    const int line = lexer->line;
-    const int col = lexer->column;
+    const int start_position = lexer->position;
     char c = peek(lexer);
     
-    if (c == '\0') {
-        StringView empty = sv_from_parts(NULL, 0);
-        return make_token(TOK_EOF, empty, line, col);
-    }
+    if (c == '\0')
+        return make_token(TOK_EOF, start_position, 0);
 
     if (c == '"')
         return lex_string_literal(lexer);
@@ -298,7 +413,8 @@ void skip_block_comment(Lexer* lexer)
                 get(lexer); get(lexer);
                 return;
             }
-            get(lexer);
+            if (get(lexer) == '\n')
+                note_newline(lexer);
         }
     }
 }
@@ -318,28 +434,67 @@ void skip_whitespace_and_comments(Lexer* lexer) {
     } while (changed);
 }
 
+void print_token(const char* source, Token token)
+{
+    printf("lexer: current token: %s", token_type_name(token.type));
+    if (token.length > 0) {
+        printf("  (lexeme: %.*s)", (int)token.length, source + token.offset);
+    }
+    printf("\n");
+}
+
+static void describe_lex_error(const Tokens* tokens, Token token)
+{
+    SourceLocation location = locate_offset(&tokens->lines, token.offset);
+    char first = tokens->source[token.offset];
+
+    if (token.length == 0)
+        report_diagnostic("Lex error: token at line %d is longer than %u bytes\n", location.line, MAX_TOKEN_LENGTH);
+    else if (first == '"')
+        report_diagnostic("Lex error: unterminated string literal at line %d\n", location.line);
+    else if (first == '\'')
+        report_diagnostic("Lex error: unterminated character literal at line %d\n", location.line);
+    else
+        report_diagnostic("Lex error: unexpected character '%c' at line %d\n", first, location.line);
+}
+
+// returns NULL for sources past MAX_SOURCE_LENGTH and when the line table cannot grow
 Tokens* tokenize(Lexer* lexer, const char* source, int debug)
 {
     init_lexer(lexer, source);
 
+    size_t length = strlen(source);
+    if (length > MAX_SOURCE_LENGTH) {
+        report_diagnostic("Lex error: source is %zu bytes, at most %zu are supported\n", length, MAX_SOURCE_LENGTH);
+        return NULL;
+    }
+
     Tokens* tokens = create_tokens();
     if (tokens == NULL) 
         return NULL;
 
+    tokens->source = source;
+    lexer->lines = &tokens->lines;
+
     int generate_tokens = 1;
     while (generate_tokens)
     {
         Token token = lex_next_token(lexer);
-        if(debug)
-        {
-            printf("lexer: current token: %s", token_type_name(token.type));
-            if (token.lexeme.data != NULL && token.lexeme.length > 0) {
-                printf("  (lexeme: %.*s)", (int)token.lexeme.length, token.lexeme.data);
-            }
-            printf("\n");
+        if (lexer->lines_failed) {
+            report_diagnostic("Lex error: out of memory recording line starts\n");
+            free_tokens(tokens);
+            return NULL;
         }
+        if(debug)
+            print_token(source, token);
 
         add_token(tokens, token);
+        compile_stats.tokens[token.type]++;
+        // lexing stops at the error, the parser still needs the stream to end in EOF to stop recovering
+        if (token.type == TOK_ERROR) {
+            describe_lex_error(tokens, token);
+            add_token(tokens, make_token(TOK_EOF, (uint32_t)length, 0));
+        }
         if (token.type == TOK_EOF || token.type == TOK_ERROR)
             generate_tokens = 0;
     }    
@@ -358,15 +513,7 @@ char peek(Lexer* lexer)
 
 char get(Lexer* lexer)
 {
-    const char c = lexer->source[lexer->position++];
-    if (c == '\n') {
-        lexer->line++;
-        lexer->column = 1;
-    }
-    else
-        lexer->column++;
-
-    return c;
+    return lexer->source[lexer->position++];
 }
 
 const char* token_type_name(TokenType type) {
@@ -375,12 +522,17 @@ const char* token_type_name(TokenType type) {
         case TOK_RBRACE:        return "RBRACE";
         case TOK_LPAREN:        return "LPAREN";
         case TOK_RPAREN:        return "RPAREN";
+        case TOK_LBRACKET:      return "LBRACKET";
+        case TOK_RBRACKET:      return "RBRACKET";
         case TOK_COMMA:         return "COMMA";
         case TOK_DOT:           return "DOT";
+        case TOK_ARROW:         return "ARROW";
         case TOK_SEMICOLON:     return "SEMICOLON";
         case TOK_ASSIGNMENT:    return "ASSIGNMENT";
         case TOK_LESS:          return "LESS";
         case TOK_GREATER:       return "GREATER";
+        case TOK_LESS_EQUALS:   return "LESS_EQUALS";
+        case TOK_GREATER_EQUALS:return "GREATER_EQUALS";
         case TOK_AMPERSAND:     return "AMPERSAND";
         case TOK_INCREMENT:     return "INCREMENT";
         case TOK_DECREMENT:     return "DECREMENT";
@@ -392,6 +544,11 @@ const char* token_type_name(TokenType type) {
         case TOK_MODULO:        return "MODULO";
         case TOK_EQUAL:         return "EQUAL";
         case TOK_NOT_EQUAL:     return "NOT_EQUAL";
+        case TOK_AND:           return "AND";
+        case TOK_OR:            return "OR";
+        case TOK_NOT:           return "NOT";
+        case TOK_QUESTION:      return "QUESTION";
+        case TOK_COLON:         return "COLON";
 
         case TOK_ASSIGNMENT_ADDITION:         return "ASSIGNMENT_ADDITION";
         case TOK_ASSIGNMENT_SUBTRACTION:      return "ASSIGNMENT_SUBTRACTION";
@@ -411,12 +568,18 @@ const char* token_type_name(TokenType type) {
         case TOK_UDOUBLE:       return "UDOUBLE";
         case TOK_CHAR:          return "CHAR";
         case TOK_UCHAR:         return "UCHAR";
+        case TOK_ARENA:         return "ARENA";
         case TOK_IF:            return "IF";
         case TOK_ELSE:          return "ELSE";
         case TOK_FOR:           return "FOR";
         case TOK_WHILE:         return "WHILE";
         case TOK_STRUCT:        return "STRUCT";
+        case TOK_BREAK:         return "BREAK";
+        case TOK_CONTINUE:      return "CONTINUE";
         case TOK_PRINT:         return "PRINT";
+        case TOK_CONST:         return "CONST";
+        case TOK_RESTRICT:      return "RESTRICT";
+        case TOK_EXPORT:        return "EXPORT";
 
         case TOK_IDENTIFIER:    return "IDENTIFIER";
         case TOK_NUMBER_INT:    return "NUMBER_INT";
@@ -427,6 +590,7 @@ const char* token_type_name(TokenType type) {
         case TOK_RETURN:        return "RETURN";
         
         case TOK_EOF:           return "EOF";
+        case TOK_NONE:          return "NONE";
         case TOK_ERROR:         return "ERROR";
 
         default:                return "UNKNOWN";
@@ -4,34 +4,45 @@
 #include "token.h"
 #include "lexer_trie.h"
 #include "string_view.h"
+#include <stddef.h>
 
 #define INITIAL_CAPACITY 32
+// Lexer.position is an int and tokens keep 32 bit offsets, longer sources are rejected before lexing
+#define MAX_SOURCE_LENGTH ((size_t)INT32_MAX)
 
 typedef struct Lexer {
     const char* source;
     int position;
-    int line;
-    int column;
+    // newline offsets go straight into the Tokens being produced
+    LineTable* lines;
+    // set when a line start could not be recorded, later locations would be wrong
+    int lines_failed;
 
     TrieNode* keywords_trie;
     TrieNode* operator_trie;
 } Lexer;
 
-Token make_token(TokenType type, StringView lexeme, int line, int column);
+Token make_token(TokenType type, uint32_t offset, size_t length);
+StringView token_lexeme(const Tokens* tokens, const Token* token);
+SourceLocation locate_offset(const LineTable* lines, uint32_t offset);
 
 Tokens* create_tokens();
 void add_token(Tokens* tokens, Token token);
 void free_tokens(Tokens* tokens);
 
+void prepare_lexer_tables(void);
 void init_lexer(Lexer* lexer, const char* source);
 void cleanup_lexer(Lexer* lexer);
 Tokens* tokenize(Lexer* lexer, const char* source, int debug);
+void print_token(const char* source, Token token);
 
 Token lex_number(Lexer* lexer);
 Token lex_string_literal(Lexer* lexer);
 Token lex_char_literal(Lexer* lexer);
 Token lex_next_token(Lexer* lexer);
 Token lex_identifier_or_keyword(Lexer* lexer, TrieNode* keyword_trie);
+int is_sized_int_type(StringView lexeme);
+TokenType vector_type_base(StringView lexeme);
 Token lex_operator_trie(Lexer* lexer, TrieNode* trie_root);
 TrieMatch trie_match(TrieNode* root, Lexer* lexer);
 void skip_whitespaces(Lexer* lexer);
@@ -0,0 +1,244 @@
+#include "lexer_parallel.h"
+#include "stats.h"
+#include "diagnostics.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct LexChunk {
+    const char* source;
+    uint32_t start;
+    uint32_t end;
+    int is_last;
+
+    Tokens* tokens;
+    long long token_counts[TOK_COUNT];
+    // an error token stops the serial lexer, the whole source is then lexed serially to match it
+    int has_error;
+} LexChunk;
+
+// mirrors where the lexer treats comments and literals, a newline reached here is always between tokens
+// returns how many chunk starts were found, starts[0] is 0
+static int find_chunk_starts(const char* source, size_t length, int chunk_count, uint32_t* starts)
+{
+    int found = 1;
+    starts[0] = 0;
+
+    size_t i = 0;
+    while (i < length && found < chunk_count) {
+        char c = source[i];
+
+        if (c == '\n') {
+            i++;
+            if (i >= length / chunk_count * found && i < length)
+                starts[found++] = (uint32_t)i;
+        }
+        else if (c == '/' && source[i + 1] == '/') {
+            const char* line_end = memchr(source + i, '\n', length - i);
+            i = line_end != NULL ? (size_t)(line_end - source) : length;
+        }
+        else if (c == '/' && source[i + 1] == '*') {
+            i += 2;
+            while (i < length && !(source[i] == '*' && source[i + 1] == '/'))
+                i++;
+            i = i < length ? i + 2 : length;
+        }
+        else if (c == '"') {
+            const char* closing = memchr(source + i + 1, '"', length - i - 1);
+            i = closing != NULL ? (size_t)(closing - source) + 1 : length;
+        }
+        // 'x' is one character, a malformed literal ends in an error token and a serial lex
+        else if (c == '\'') {
+            i++;
+            if (i < length && source[i] != '\'')
+                i++;
+            if (i < length && source[i] == '\'')
+                i++;
+        }
+        else
+            i += 1 + strcspn(source + i + 1, "\n/\"'");
+    }
+
+    return found;
+}
+
+// the lexer may look past end while skipping whitespace, what it finds there belongs to the next chunk
+static void* lex_chunk(void* data)
+{
+    LexChunk* chunk = data;
+    chunk->tokens = create_tokens();
+    if (chunk->tokens == NULL) {
+        chunk->has_error = 1;
+        return NULL;
+    }
+    chunk->tokens->lines.count = 0;
+
+    Lexer lexer;
+    init_lexer(&lexer, chunk->source);
+    lexer.position = (int)chunk->start;
+    lexer.lines = &chunk->tokens->lines;
+
+    while (1) {
+        Token token = lex_next_token(&lexer);
+        if (!chunk->is_last && token.offset >= chunk->end)
+            break;
+
+        // the serial fallback reports the failure once, on the caller's diagnostic sink
+        if (lexer.lines_failed) {
+            chunk->has_error = 1;
+            break;
+        }
+
+        add_token(chunk->tokens, token);
+        chunk->token_counts[token.type]++;
+
+        if (token.type == TOK_ERROR) {
+            chunk->has_error = 1;
+            break;
+        }
+        if (token.type == TOK_EOF)
+            break;
+    }
+
+    LineTable* lines = &chunk->tokens->lines;
+    while (!chunk->is_last && lines->count > 0 && lines->starts[lines->count - 1] > chunk->end)
+        lines->count--;
+
+    cleanup_lexer(&lexer);
+    return NULL;
+}
+
+static int pick_thread_count(size_t length)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t by_size = length / PARALLEL_LEX_MIN_CHUNK;
+
+    int count = cores > 0 ? (int)cores : 1;
+    if ((size_t)count > by_size)
+        count = (int)by_size;
+    if (count > PARALLEL_LEX_MAX_THREADS)
+        count = PARALLEL_LEX_MAX_THREADS;
+    return count;
+}
+
+// token offsets and line starts are absolute, so joining the chunks needs no renumbering
+static Tokens* merge_chunks(const char* source, LexChunk* chunks, int chunk_count)
+{
+    Tokens* tokens = create_tokens();
+    if (tokens == NULL)
+        return NULL;
+
+    int token_count = 0;
+    int line_count = tokens->lines.count;
+    for (int i = 0; i < chunk_count; i++) {
+        token_count += chunks[i].tokens->token_count;
+        line_count += chunks[i].tokens->lines.count;
+    }
+
+    Token* merged_tokens = realloc(tokens->tokens, sizeof(Token) * token_count);
+    uint32_t* merged_lines = realloc(tokens->lines.starts, sizeof(uint32_t) * line_count);
+    if (merged_tokens != NULL)
+        tokens->tokens = merged_tokens;
+    if (merged_lines != NULL)
+        tokens->lines.starts = merged_lines;
+    if (merged_tokens == NULL || merged_lines == NULL) {
+        free_tokens(tokens);
+        return NULL;
+    }
+
+    tokens->capacity = token_count;
+    tokens->lines.capacity = line_count;
+    tokens->source = source;
+
+    for (int i = 0; i < chunk_count; i++) {
+        Tokens* part = chunks[i].tokens;
+        memcpy(tokens->tokens + tokens->token_count, part->tokens, sizeof(Token) * part->token_count);
+        tokens->token_count += part->token_count;
+
+        memcpy(tokens->lines.starts + tokens->lines.count, part->lines.starts, sizeof(uint32_t) * part->lines.count);
+        tokens->lines.count += part->lines.count;
+    }
+
+    return tokens;
+}
+
+static Tokens* tokenize_serial(const char* source, int debug)
+{
+    Lexer lexer;
+    Tokens* tokens = tokenize(&lexer, source, debug);
+    cleanup_lexer(&lexer);
+    return tokens;
+}
+
+Tokens* tokenize_parallel(const char* source, int thread_count, int debug)
+{
+    size_t length = strlen(source);
+    if (length > MAX_SOURCE_LENGTH) {
+        report_diagnostic("Lex error: source is %zu bytes, at most %zu are supported\n", length, MAX_SOURCE_LENGTH);
+        return NULL;
+    }
+
+    if (thread_count <= 0)
+        thread_count = pick_thread_count(length);
+    if (thread_count <= 1)
+        return tokenize_serial(source, debug);
+
+    prepare_lexer_tables();
+
+    uint32_t* starts = malloc(sizeof(uint32_t) * thread_count);
+    LexChunk* chunks = calloc(thread_count, sizeof(LexChunk));
+    pthread_t* threads = malloc(sizeof(pthread_t) * thread_count);
+    if (starts == NULL || chunks == NULL || threads == NULL) {
+        free(starts);
+        free(chunks);
+        free(threads);
+        return tokenize_serial(source, debug);
+    }
+
+    int chunk_count = find_chunk_starts(source, length, thread_count, starts);
+    for (int i = 0; i < chunk_count; i++) {
+        chunks[i].source = source;
+        chunks[i].start = starts[i];
+        chunks[i].is_last = i == chunk_count - 1;
+        chunks[i].end = chunks[i].is_last ? (uint32_t)length : starts[i + 1];
+    }
+
+    // chunk 0 is lexed on the calling thread
+    int started = 1;
+    for (int i = 1; i < chunk_count; i++) {
+        if (pthread_create(&threads[i], NULL, lex_chunk, &chunks[i]) != 0)
+            break;
+        started++;
+    }
+    lex_chunk(&chunks[0]);
+    for (int i = started; i < chunk_count; i++)
+        lex_chunk(&chunks[i]);
+    for (int i = 1; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    int has_error = 0;
+    for (int i = 0; i < chunk_count; i++)
+        has_error |= chunks[i].has_error;
+
+    Tokens* tokens = has_error ? NULL : merge_chunks(source, chunks, chunk_count);
+    if (tokens != NULL) {
+        for (int i = 0; i < chunk_count; i++) {
+            for (int type = 0; type < TOK_COUNT; type++)
+                compile_stats.tokens[type] += chunks[i].token_counts[type];
+        }
+
+        if (debug) {
+            for (int i = 0; i < tokens->token_count; i++)
+                print_token(source, tokens->tokens[i]);
+        }
+    }
+
+    for (int i = 0; i < chunk_count; i++)
+        free_tokens(chunks[i].tokens);
+    free(starts);
+    free(chunks);
+    free(threads);
+
+    return tokens != NULL ? tokens : tokenize_serial(source, debug);
+}
@@ -0,0 +1,15 @@
+#ifndef LEXER_PARALLEL_H
+#define LEXER_PARALLEL_H
+
+#include "lexer.h"
+
+// a chunk is at least this large when the thread count is picked automatically
+#define PARALLEL_LEX_MIN_CHUNK (1 << 20)
+#define PARALLEL_LEX_MAX_THREADS 16
+
+// splits source at newlines that are outside comments and literals and lexes the pieces on
+// worker threads, the result is the same Tokens tokenize would produce
+// thread_count 0 picks one from the source size and the cores, 1 or a small source lexes serially
+Tokens* tokenize_parallel(const char* source, int thread_count, int debug);
+
+#endif
@@ -47,6 +47,9 @@ TrieNode* build_operator_trie(TrieNode* root) {
     trie_insert(root, ",", TOK_COMMA);
     trie_insert(root, ".", TOK_DOT);
     trie_insert(root, ";", TOK_SEMICOLON);
+    trie_insert(root, "!", TOK_NOT);
+    trie_insert(root, "?", TOK_QUESTION);
+    trie_insert(root, ":", TOK_COLON);
 
     trie_insert(root, "==", TOK_EQUAL);
     trie_insert(root, "!=", TOK_NOT_EQUAL);
@@ -59,6 +62,9 @@ TrieNode* build_operator_trie(TrieNode* root) {
     trie_insert(root, "%=", TOK_ASSIGNMENT_MODULO);
     trie_insert(root, "++", TOK_INCREMENT);
     trie_insert(root, "--", TOK_DECREMENT);
+    trie_insert(root, "->", TOK_ARROW);
+    trie_insert(root, "&&", TOK_AND);
+    trie_insert(root, "||", TOK_OR);
     
     return root;
 }
@@ -70,19 +76,28 @@ TrieNode* build_keyword_trie(TrieNode* root)
     trie_insert(root, "for", TOK_FOR);
     trie_insert(root, "while", TOK_WHILE);
     trie_insert(root, "return", TOK_RETURN);
+    trie_insert(root, "break", TOK_BREAK);
+    trie_insert(root, "continue", TOK_CONTINUE);
 
     trie_insert(root, "void", TOK_VOID);
     trie_insert(root, "int", TOK_INT);
     trie_insert(root, "uint", TOK_UINT);
+    trie_insert(root, "long", TOK_INT);
+    trie_insert(root, "ulong", TOK_UINT);
     trie_insert(root, "float", TOK_FLOAT);
     trie_insert(root, "ufloat", TOK_UFLOAT);
     trie_insert(root, "double", TOK_DOUBLE);
     trie_insert(root, "udouble", TOK_UDOUBLE);
     trie_insert(root, "char", TOK_CHAR);
     trie_insert(root, "uchar", TOK_UCHAR);
+    trie_insert(root, "arena", TOK_ARENA);
     
     trie_insert(root, "print", TOK_PRINT);
 
+    trie_insert(root, "const", TOK_CONST);
+    trie_insert(root, "restrict", TOK_RESTRICT);
+    trie_insert(root, "export", TOK_EXPORT);
+
     trie_insert(root, "struct", TOK_STRUCT);
     trie_insert(root, "namespace", TOK_NAMESPACE);
 
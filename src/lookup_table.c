@@ -1,4 +1,6 @@
 #include "lookup_table.h"
+#include "stats.h"
+#include "diagnostics.h"
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,7 +42,18 @@ void free_symbol_entry(SymbolEntry* entry) {
     if (entry == NULL)
         return;
 
-    free(entry->symbol_data.name);
+    SymbolData* data = &entry->symbol_data;
+    if (data->kind == SYMBOL_FUNCTION)
+        free(data->as.function.param_types);
+
+    if (data->kind == SYMBOL_STRUCT) {
+        for (int i = 0; i < data->as.struct_def.member_count; i++)
+            free(data->as.struct_def.member_names[i]);
+        free(data->as.struct_def.member_names);
+        free(data->as.struct_def.member_types);
+    }
+
+    free(data->name);
     free(entry);
 }
 
@@ -67,7 +80,7 @@ void push_scope(SymbolTable* st)
         return;
 
     if (st->scope_count >= MAX_SCOPE_DEPTH) {
-        printf("Error: Maximum scope depth exceeded\n");
+        report_diagnostic("Error: Maximum scope depth exceeded\n");
         return;
     }
 
@@ -77,6 +90,9 @@ void push_scope(SymbolTable* st)
 
     st->scopes[st->scope_count++] = new_scope;
     st->current_scope = new_scope;
+
+    if (st->scope_count > compile_stats.max_scope_depth)
+        compile_stats.max_scope_depth = st->scope_count;
 }
 
 void pop_scope(SymbolTable* st) {
@@ -104,20 +120,44 @@ void pop_scope(SymbolTable* st) {
     st->current_scope = st->scopes[st->scope_count - 1];
 }
 
-int add_variable_symbol(SymbolTable* st, const char* name, TypeInfo type, LLVMValueRef alloc, int is_global) {
+// pops every scope including the global one
+void free_symbol_table(SymbolTable* st) {
+    if (st == NULL)
+        return;
+
+    while (st->scope_count > 1)
+        pop_scope(st);
+
+    if (st->scope_count == 1) {
+        Scope* global = st->scopes[0];
+        for (int i = 0; i < HASH_TABLE_SIZE; i++) {
+            SymbolEntry* entry = global->table->buckets[i];
+            while (entry != NULL) {
+                SymbolEntry* next = entry->next;
+                free_symbol_entry(entry);
+                entry = next;
+            }
+        }
+        free_scope(global);
+    }
+    free(st);
+}
+
+int add_variable_symbol(SymbolTable* st, const char* name, TypeId type, LLVMValueRef alloc, int is_global) {
     SymbolData data = {
         .name = (char*)name,
         .kind = SYMBOL_VARIABLE,
         .as.variable = {
             .type = type,
             .alloc = alloc,
-            .is_global = is_global
+            .is_global = is_global,
+            .alias_scope = NULL
         }
     };
     return add_symbol(st, data);
 }
 
-int add_struct_symbol(SymbolTable* st, const char* name, LLVMTypeRef struct_type, int member_count, char** member_names, TypeInfo* member_types) {
+int add_struct_symbol(SymbolTable* st, const char* name, LLVMTypeRef struct_type, int member_count, char** member_names, TypeId* member_types) {
     SymbolData data = {
         .name = (char*)name,
         .kind = SYMBOL_STRUCT,
@@ -131,7 +171,7 @@ int add_struct_symbol(SymbolTable* st, const char* name, LLVMTypeRef struct_type
     return add_symbol(st, data);
 }
 
-int add_function_symbol(SymbolTable* st, const char* name, TypeInfo return_type, int param_count, TypeInfo* param_types, LLVMValueRef function) {
+int add_function_symbol(SymbolTable* st, const char* name, TypeId return_type, int param_count, TypeId* param_types, LLVMValueRef function) {
     SymbolData data = {
         .name = (char*)name,
         .kind = SYMBOL_FUNCTION,
@@ -152,17 +192,23 @@ int add_symbol(SymbolTable* st, SymbolData symbol_data) {
     size_t index = hash_string(symbol_data.name);
     HashTable* table = st->current_scope->table;
     
+    int chain_length = 1;
     SymbolEntry* entry = table->buckets[index];
     while (entry != NULL) {
         if (strcmp(entry->symbol_data.name, symbol_data.name) == 0) {
             return 0;
         }
         entry = entry->next;
+        chain_length++;
     }
     
     SymbolEntry* new_entry = create_symbol_entry(symbol_data);
     new_entry->next = table->buckets[index];
     table->buckets[index] = new_entry;
+
+    compile_stats.symbol_inserts++;
+    if (chain_length > compile_stats.max_chain_length)
+        compile_stats.max_chain_length = chain_length;
     return 1;
 }
 
@@ -172,8 +218,10 @@ SymbolEntry* lookup_symbol_current_scope(SymbolTable* st, const char* name) {
 
     size_t index = hash_string(name);
     SymbolEntry* entry = st->current_scope->table->buckets[index];
+    compile_stats.symbol_lookups++;
 
     while (entry != NULL) {
+        compile_stats.symbol_probes++;
         if (strcmp(entry->symbol_data.name, name) == 0)
             return entry;
         entry = entry->next;
@@ -186,12 +234,14 @@ SymbolEntry* lookup_symbol(SymbolTable* st, const char* name) {
         return NULL;
 
     Scope* scope = st->current_scope;
+    compile_stats.symbol_lookups++;
 
     while (scope != NULL) {
         size_t index = hash_string(name);
         SymbolEntry* entry = scope->table->buckets[index];
         
         while (entry != NULL) {
+            compile_stats.symbol_probes++;
             if (strcmp(entry->symbol_data.name, name) == 0)
                 return entry;
             entry = entry->next;
@@ -223,14 +273,14 @@ int get_struct_member_index(SymbolTable* st, const char* struct_name, const char
     return -1;
 }
 
-TypeInfo* get_struct_member_type(SymbolTable* st, const char* struct_name, const char* member_name) {
+TypeId get_struct_member_type(SymbolTable* st, const char* struct_name, const char* member_name) {
     SymbolEntry* entry = lookup_symbol(st, struct_name);
     if (entry == NULL || entry->symbol_data.kind != SYMBOL_STRUCT)
-        return NULL;
+        return TYPE_ID_NONE;
 
     int index = get_struct_member_index(st, struct_name, member_name);
     if (index < 0)
-        return NULL;
+        return TYPE_ID_NONE;
 
-    return &entry->symbol_data.as.struct_def.member_types[index];
+    return entry->symbol_data.as.struct_def.member_types[index];
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "lexer.h"
 #include "parser.h"
+#include "type_table.h"
 #include <llvm-c/Types.h>
 
 #define HASH_TABLE_SIZE 32
@@ -15,15 +16,16 @@ typedef enum {
 } SymbolKind;
 
 typedef struct {
-    TypeInfo type;
+    TypeId type;
     LLVMValueRef alloc;
     int is_global;
+    LLVMMetadataRef alias_scope;
 } VariableSymbolData;
 
 typedef struct {
-    TypeInfo return_type;
+    TypeId return_type;
     int param_count;
-    TypeInfo* param_types;
+    TypeId* param_types;
     LLVMValueRef function;
 } FunctionSymbolData;
 
@@ -31,7 +33,7 @@ typedef struct {
     LLVMTypeRef struct_type;
     int member_count;
     char** member_names;
-    TypeInfo* member_types;
+    TypeId* member_types;
 } StructSymbolData;
 
 typedef struct SymbolData {
@@ -70,6 +72,7 @@ typedef struct SymbolTable {
 size_t hash_string(const char* str);
 
 SymbolTable* init_symbol_table();
+void free_symbol_table(SymbolTable* st);
 HashTable* create_hash_table();
 Scope* create_scope(Scope* parent, int depth);
 SymbolEntry* create_symbol_entry(SymbolData data);
@@ -79,16 +82,16 @@ void free_symbol_entry(SymbolEntry* entry);
 void push_scope(SymbolTable* st);
 void pop_scope(SymbolTable* st);
 
-int add_variable_symbol(SymbolTable* st, const char* name, TypeInfo type, LLVMValueRef alloc, int is_global);
-int add_struct_symbol(SymbolTable* st, const char* name, LLVMTypeRef struct_type, int member_count, char** member_names, TypeInfo* member_types);
-int add_function_symbol(SymbolTable* st, const char* name, TypeInfo return_type, int param_count, TypeInfo* param_types, LLVMValueRef function);
+int add_variable_symbol(SymbolTable* st, const char* name, TypeId type, LLVMValueRef alloc, int is_global);
+int add_struct_symbol(SymbolTable* st, const char* name, LLVMTypeRef struct_type, int member_count, char** member_names, TypeId* member_types);
+int add_function_symbol(SymbolTable* st, const char* name, TypeId return_type, int param_count, TypeId* param_types, LLVMValueRef function);
 
 int add_symbol(SymbolTable* st, SymbolData symbol_data);
 SymbolEntry* lookup_symbol_current_scope(SymbolTable* st, const char* name);
 SymbolEntry* lookup_symbol(SymbolTable* st, const char* name);
 LLVMTypeRef lookup_struct_type(SymbolTable* st, const char* name);
 int get_struct_member_index(SymbolTable* st, const char* struct_name, const char* member_name);
-TypeInfo* get_struct_member_type(SymbolTable* st, const char* struct_name, const char* member_name);
+TypeId get_struct_member_type(SymbolTable* st, const char* struct_name, const char* member_name);
 
 size_t hash_string(const char* str);
 
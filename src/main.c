@@ -1,6 +1,9 @@
 #include "codegen_visitor.h"
-#include "lexer.h"
-#include "parser.h"
+#include "lexer_parallel.h"
+#include "parser_lazy.h"
+#include "parser_parallel.h"
+#include "server.h"
+#include "stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,12 +20,89 @@ int has_ecl_extension(const char* filename) {
     return strcmp(filename + len - len_ext, ".ecl") == 0;
 }
 
+typedef struct CommandLine {
+    CodegenOptions options;
+    const char* filename;
+    const char* stats_filename;
+    const char* server_socket;
+    int worker_count;
+    // 0 lets parse_program_parallel pick from the cores and the number of functions
+    int parse_thread_count;
+    // only bodies main and exported functions can reach are parsed and compiled
+    int lazy_parse;
+} CommandLine;
+
 void print_usage() {
-    fprintf(stderr, "Usage: <source_file.ecl>\n");
+    fprintf(stderr, "Usage: [--bounds-check] [--stats=<file.json>] [--parse-threads=<count>] [--lazy-parse] <source_file.ecl>\n");
+    fprintf(stderr, "       --server=<socket> [--workers=<count>]\n");
+}
+
+static const char* get_option_value(const char* arg, const char* option) {
+    size_t len = strlen(option);
+    if (strncmp(arg, option, len) != 0 || arg[len] == '\0')
+        return NULL;
+    return arg + len;
 }
 
-int check_argument_count(int argc, int desired_count) {
-    if (argc != desired_count) {
+// options may appear before or after the single source file, server mode takes no source file
+int parse_arguments(int argc, char** argv, CommandLine* command_line) {
+    *command_line = (CommandLine) { 0 };
+    const char* value;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bounds-check") == 0) {
+            command_line->options.bounds_check = 1;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--lazy-parse") == 0) {
+            command_line->lazy_parse = 1;
+            continue;
+        }
+
+        if ((value = get_option_value(argv[i], "--stats=")) != NULL) {
+            command_line->stats_filename = value;
+            continue;
+        }
+
+        if ((value = get_option_value(argv[i], "--server=")) != NULL) {
+            command_line->server_socket = value;
+            continue;
+        }
+
+        if ((value = get_option_value(argv[i], "--workers=")) != NULL) {
+            command_line->worker_count = atoi(value);
+            if (command_line->worker_count <= 0) {
+                fprintf(stderr, "Error: Invalid worker count '%s'.\n", value);
+                return 0;
+            }
+            continue;
+        }
+
+        if ((value = get_option_value(argv[i], "--parse-threads=")) != NULL) {
+            command_line->parse_thread_count = atoi(value);
+            if (command_line->parse_thread_count <= 0) {
+                fprintf(stderr, "Error: Invalid parse thread count '%s'.\n", value);
+                return 0;
+            }
+            continue;
+        }
+
+        if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: Unknown option '%s'.\n", argv[i]);
+            print_usage();
+            return 0;
+        }
+
+        if (command_line->filename != NULL) {
+            fprintf(stderr, "Error: Invalid number of arguments.\n");
+            print_usage();
+            return 0;
+        }
+        command_line->filename = argv[i];
+    }
+
+    if ((command_line->filename == NULL) == (command_line->server_socket == NULL)) {
         fprintf(stderr, "Error: Invalid number of arguments.\n");
         print_usage();
         return 0;
@@ -72,11 +152,7 @@ char* get_output_filename(const char* module_name)
     return output;
 }
 
-char* get_source_from_file(int argc, char** argv) {
-    if(!check_argument_count(argc, 2))
-        return NULL;
-
-    const char* filename = argv[1];    
+char* get_source_from_file(const char* filename) {
     if (!has_ecl_extension(filename)) {
         print_usage();
         return NULL;
@@ -97,6 +173,11 @@ char* get_source_from_file(int argc, char** argv) {
         fclose(fptr);
         return NULL;
     }
+    if ((unsigned long)fsize > MAX_SOURCE_LENGTH) {
+        fprintf(stderr, "Error: '%s' is larger than %zu bytes.\n", filename, MAX_SOURCE_LENGTH);
+        fclose(fptr);
+        return NULL;
+    }
 
     fseek(fptr, 0, SEEK_SET);
 
@@ -118,41 +199,76 @@ char* get_source_from_file(int argc, char** argv) {
     return code;
 }
 
-void compile_source_file(int argc, char** argv)
+int compile_source_file(const CommandLine* command_line)
 {
-    char* code = get_source_from_file(argc, argv);
+    char* code = get_source_from_file(command_line->filename);
     if (code == NULL)
-        return;
+        return 1;
 
-    char* module_name = get_module_name(argv[1]);
+    char* module_name = get_module_name(command_line->filename);
     if (module_name == NULL) {
         free(code);
-        return;
+        return 1;
     }
 
     char* output_filename = get_output_filename(module_name);
     if (output_filename == NULL) {
         free(module_name);
         free(code);
-        return;
+        return 1;
     }
 
-    Lexer lexer;
-    Tokens* tokens = tokenize(&lexer, code, 1);
-    cleanup_lexer(&lexer);
+    reset_compile_stats();
+    double phase_start = stats_now_ms();
+
+    Tokens* tokens = tokenize_parallel(code, 0, 1);
+    compile_stats.phase_ms[PHASE_LEX] = stats_now_ms() - phase_start;
+    if (tokens == NULL) {
+        free(output_filename);
+        free(module_name);
+        free(code);
+        return 1;
+    }
 
+    phase_start = stats_now_ms();
     Parser parser;
     init_parser(&parser, tokens);
-    ASTNode* program = parse_program(&parser);
+    ASTNode* program = NULL;
+    if (command_line->lazy_parse)
+        program = parse_program_reachable(&parser);
+    else
+        program = parse_program_parallel(&parser, command_line->parse_thread_count);
+    compile_stats.phase_ms[PHASE_PARSE] = stats_now_ms() - phase_start;
 
-    generate_llvm_ir_visitor(program, module_name, output_filename);
-    
+    if (command_line->lazy_parse && program != NULL)
+        printf("parser: skipped %d unreachable functions\n", compile_stats.skipped_functions);
+
+    // parse errors are reported as they are found, code generation only runs on a clean tree
+    int status = 1;
+    if (program != NULL && parser.error_count == 0) {
+        phase_start = stats_now_ms();
+        status = generate_llvm_ir_visitor(program, module_name, output_filename, &command_line->options) ? 0 : 1;
+        compile_stats.phase_ms[PHASE_CODEGEN] = stats_now_ms() - phase_start;
+    }
+
+    if (command_line->stats_filename != NULL)
+        write_compile_stats_json(command_line->stats_filename);
+
+    free_ast(program);
+    free_tokens(tokens);
     free(output_filename);
     free(module_name);
     free(code);
+    return status;
 }
 
 int main(int argc, char** argv) {
-    compile_source_file(argc, argv);
-    return 0;
+    CommandLine command_line;
+    if (!parse_arguments(argc, argv, &command_line))
+        return 1;
+
+    if (command_line.server_socket != NULL)
+        return run_compile_server(command_line.server_socket, command_line.worker_count);
+
+    return compile_source_file(&command_line);
 }
\ No newline at end of file
@@ -1,125 +1,121 @@
 #include "parser.h"
+#include "stats.h"
 #include "ast_layout.h"
 #include "token.h"
+#include "diagnostics.h"
+#include "type_table.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void free_node_array(ASTNode** array, int count) {
-    if (array == NULL)
+// nodes, child arrays and names live in the program's arena and go away with it
+void free_ast(ASTNode* node) {
+    if (node == NULL || node->type != AST_PROGRAM)
         return;
-    
-    for (int i = 0; i < count; i++) {
-        free_ast(array[i]);
-    }
 
-    free(array);
+    free_ast_arena(node->as.program.arena);
 }
 
-void free_ast(ASTNode* node) {
+static void visit_node_array(ASTNode** nodes, int count, AstChildFn fn, void* data) {
+    for (int i = 0; i < count; i++)
+        fn(nodes[i], data);
+}
+
+// calls fn on every direct child, analyses recurse through it without a switch of their own
+void visit_ast_children(ASTNode* node, AstChildFn fn, void* data) {
     if (node == NULL)
         return;
-    
+
     switch (node->type) {
         case AST_PROGRAM:
-            free(node->as.program.name);
-            free_node_array(node->as.program.functions, node->as.program.function_count);
-            free_node_array(node->as.program.structs, node->as.program.struct_count);
-            free_node_array(node->as.program.globals, node->as.program.global_count);
+            visit_node_array(node->as.program.structs, node->as.program.struct_count, fn, data);
+            visit_node_array(node->as.program.globals, node->as.program.global_count, fn, data);
+            visit_node_array(node->as.program.functions, node->as.program.function_count, fn, data);
             break;
-            
+
+        case AST_STRUCT_DECL:
+            visit_node_array(node->as.struct_decl.members, node->as.struct_decl.member_count, fn, data);
+            break;
+
         case AST_FUNCTION:
-            free(node->as.function.name);
-            free_node_array(node->as.function.params, node->as.function.param_count);
-            free_ast(node->as.function.body);
+            visit_node_array(node->as.function.params, node->as.function.param_count, fn, data);
+            fn(node->as.function.body, data);
             break;
-            
+
         case AST_BLOCK:
-            free_node_array(node->as.block.statements, node->as.block.statement_count);
+            visit_node_array(node->as.block.statements, node->as.block.statement_count, fn, data);
             break;
-            
-        case AST_PARAM_LIST:
-            free(node->as.param.name);
-            break;
-            
+
         case AST_RETURN:
-            free_ast(node->as.return_stmt.value);
+            fn(node->as.return_stmt.value, data);
             break;
-            
+
         case AST_VAR_DECL:
-            free(node->as.var_decl.name);
-            free_ast(node->as.var_decl.initializer);
+            fn(node->as.var_decl.initializer, data);
             break;
-            
+
         case AST_ASSIGN:
-            free_ast(node->as.assign.target);
-            free_ast(node->as.assign.value);
+            fn(node->as.assign.target, data);
+            fn(node->as.assign.value, data);
             break;
-            
+
         case AST_IF:
-            free_ast(node->as.if_stmt.condition);
-            free_ast(node->as.if_stmt.then_branch);
-            free_ast(node->as.if_stmt.else_branch);
+            fn(node->as.if_stmt.condition, data);
+            fn(node->as.if_stmt.then_branch, data);
+            fn(node->as.if_stmt.else_branch, data);
             break;
-            
+
         case AST_FOR:
-            free_ast(node->as.for_stmt.init);
-            free_ast(node->as.for_stmt.condition);
-            free_ast(node->as.for_stmt.update);
-            free_ast(node->as.for_stmt.body);
+            fn(node->as.for_stmt.init, data);
+            fn(node->as.for_stmt.condition, data);
+            fn(node->as.for_stmt.update, data);
+            fn(node->as.for_stmt.body, data);
             break;
-            
+
         case AST_WHILE:
-            free_ast(node->as.while_stmt.condition);
-            free_ast(node->as.while_stmt.body);
+            fn(node->as.while_stmt.condition, data);
+            fn(node->as.while_stmt.body, data);
             break;
-            
-        case AST_IDENTIFIER:
-            free(node->as.identifier.name);
-            break;
-            
-        case AST_STRING_LITERAL:
-            free(node->as.string_literal.value);
-            break;
-            
+
         case AST_FUNC_CALL:
-            free(node->as.func_call.name);
-            free_node_array(node->as.func_call.args, node->as.func_call.arg_count);
+            visit_node_array(node->as.func_call.args, node->as.func_call.arg_count, fn, data);
             break;
-            
+
         case AST_UNARY_OP:
-            free_ast(node->as.unary_op.operand);
+            fn(node->as.unary_op.operand, data);
             break;
-            
+
         case AST_BINARY_OP:
-            free_ast(node->as.binary_op.left);
-            free_ast(node->as.binary_op.right);
+            fn(node->as.binary_op.left, data);
+            fn(node->as.binary_op.right, data);
             break;
-            
+
+        case AST_TERNARY:
+            fn(node->as.ternary.condition, data);
+            fn(node->as.ternary.then_expr, data);
+            fn(node->as.ternary.else_expr, data);
+            break;
+
         case AST_CAST:
-            free_ast(node->as.cast.expr);
+            fn(node->as.cast.expr, data);
             break;
-            
+
         case AST_MEMBER_ACCESS:
-            free_ast(node->as.member_access.object);
-            free(node->as.member_access.member);
-            break;
-            
-        case AST_STRUCT_DECL:
-            free(node->as.struct_decl.type);
-            free_node_array(node->as.struct_decl.members, node->as.struct_decl.member_count);
+            fn(node->as.member_access.object, data);
             break;
 
         case AST_ARRAY_ACCESS:
-            free_ast(node->as.array_access.target);
-            free_ast(node->as.array_access.index);
+            fn(node->as.array_access.target, data);
+            fn(node->as.array_access.index, data);
             break;
-            
+
+        case AST_PRINT:
+            visit_node_array(node->as.print.expressions, node->as.print.expression_count, fn, data);
+            break;
+
         default:
             break;
     }
-    
-    free(node);
 }
 
 void init_parser(Parser* parser, Tokens* tokens) {
@@ -128,6 +124,81 @@ void init_parser(Parser* parser, Tokens* tokens) {
 
     parser->tokens = tokens;
     parser->current_token = 0;
+    parser->error_count = 0;
+    parser->loop_depth = 0;
+    parser->scratch = NULL;
+    parser->scratch_count = 0;
+    parser->scratch_capacity = 0;
+    parser->defer_bodies = 0;
+    parser->deferred = NULL;
+    parser->deferred_count = 0;
+    parser->deferred_capacity = 0;
+}
+
+void cleanup_parser(Parser* parser) {
+    if (parser == NULL)
+        return;
+
+    free(parser->scratch);
+    parser->scratch = NULL;
+    parser->scratch_count = 0;
+    parser->scratch_capacity = 0;
+
+    free(parser->deferred);
+    parser->deferred = NULL;
+    parser->deferred_count = 0;
+    parser->deferred_capacity = 0;
+}
+
+// lists nest (a call inside a block) and an inner list sits above its parent on the stack,
+// one abandoned after a parse error is simply overwritten by the parent's next append
+static NodeListBuilder begin_node_list(Parser* parser) {
+    return (NodeListBuilder) { .base = parser->scratch_count, .count = 0 };
+}
+
+static int append_node_list(Parser* parser, NodeListBuilder* list, ASTNode* node) {
+    int index = list->base + list->count;
+    if (index >= parser->scratch_capacity) {
+        int capacity = parser->scratch_capacity == 0 ? 64 : parser->scratch_capacity * 2;
+        ASTNode** scratch = realloc(parser->scratch, sizeof(ASTNode*) * capacity);
+        if (scratch == NULL)
+            return 0;
+
+        parser->scratch = scratch;
+        parser->scratch_capacity = capacity;
+    }
+
+    parser->scratch[index] = node;
+    list->count++;
+    parser->scratch_count = index + 1;
+    return 1;
+}
+
+static ASTNode** finish_node_list(Parser* parser, NodeListBuilder* list, ASTNodeType owner) {
+    parser->scratch_count = list->base;
+    if (list->count == 0)
+        return NULL;
+
+    size_t size = sizeof(ASTNode*) * list->count;
+    ASTNode** nodes = ast_arena_alloc(get_current_ast_arena(), size);
+    if (nodes == NULL)
+        return NULL;
+
+    memcpy(nodes, parser->scratch + list->base, size);
+    compile_stats.ast_bytes[owner] += size;
+    return nodes;
+}
+
+static char* copy_lexeme(Parser* parser) {
+    return ast_arena_copy_string(get_current_ast_arena(), current_lexeme(parser));
+}
+
+// a construct that failed to parse is dropped, the parser always moves on so a bad token cannot stall a loop
+static void recover_from_error(Parser* parser, int start_token)
+{
+    parser->error_count++;
+    if (parser->current_token == start_token)
+        advance(parser);
 }
 
 void advance(Parser* parser) {
@@ -146,6 +217,11 @@ Token* current_token(Parser* parser)
     return &parser->tokens->tokens[parser->current_token];
 }
 
+StringView current_lexeme(Parser* parser)
+{
+    return token_lexeme(parser->tokens, current_token(parser));
+}
+
 Token* peek_token(Parser* parser, int offset)
 {
     int pos = parser->current_token + offset;
@@ -168,13 +244,14 @@ int check(Parser* parser, TokenType type) {
 }
 
 int is_type(Parser* parser, TokenType t) {
-    if (t == TOK_IDENTIFIER && peek_token(parser, 1)->type == TOK_IDENTIFIER)
+    // struct types are plain identifiers, only a following name (Point p, Point* p) marks them as a type
+    if (t == TOK_IDENTIFIER && peek_token(parser, 1 + check_pointer_level(parser, 1))->type == TOK_IDENTIFIER)
         return 1;
 
     switch(t) {
         case TOK_INT: case TOK_UINT: case TOK_FLOAT: case TOK_UFLOAT:
         case TOK_DOUBLE: case TOK_UDOUBLE: case TOK_CHAR: case TOK_UCHAR:
-        case TOK_VOID: return 1;
+        case TOK_VOID: case TOK_ARENA: return 1;
         default: return 0;
     }
 }
@@ -195,22 +272,34 @@ ASTNode* parse_print(Parser* parser) {
         return NULL;
     }
 
-    ASTNode* expr = parse_expression(parser);
-    if (expr == NULL) {
+    ASTNode* print = create_print_node(current_token(parser)->offset);
+    if (print == NULL)
         return NULL;
-    }
+
+    // print(a, b, c); emits one record
+    NodeListBuilder expressions = begin_node_list(parser);
+    do {
+        ASTNode* expr = parse_expression(parser);
+        if (expr == NULL || !append_node_list(parser, &expressions, expr)) {
+            finish_node_list(parser, &expressions, AST_PRINT);
+            return NULL;
+        }
+    } while (match(parser, TOK_COMMA));
+
+    print->as.print.expressions = finish_node_list(parser, &expressions, AST_PRINT);
+    print->as.print.expression_count = expressions.count;
 
     if (!match(parser, TOK_RPAREN)) {
-        free_ast(expr);
+        free_ast(print);
         return NULL;
     }
 
     if (!match(parser, TOK_SEMICOLON)) {
-        free_ast(expr);
+        free_ast(print);
         return NULL;
     }
 
-    return create_print_node(expr, current_token(parser)->line, current_token(parser)->column);
+    return print;
 }
 
 ASTNode* parse_compound_operators(Parser* parser) {
@@ -250,7 +339,7 @@ ASTNode* parse_compound_operators(Parser* parser) {
     
     ASTNode* lhs_copy = NULL;
     if (lhs->type == AST_IDENTIFIER) {
-        lhs_copy = create_identifier_node(strdup(lhs->as.identifier.name), current_token(parser)->line, current_token(parser)->column);
+        lhs_copy = create_identifier_node(strdup(lhs->as.identifier.name), current_token(parser)->offset);
     }
     
     if (lhs_copy == NULL) {
@@ -259,169 +348,151 @@ ASTNode* parse_compound_operators(Parser* parser) {
         return NULL;
     }
     
-    ASTNode* binary_node = create_binary_op_node(op, lhs_copy, rhs, current_token(parser)->line, current_token(parser)->column);
-    ASTNode* assign_node = create_assign_node(lhs, binary_node, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* binary_node = create_binary_op_node(op, lhs_copy, rhs, current_token(parser)->offset);
+    ASTNode* assign_node = create_assign_node(lhs, binary_node, current_token(parser)->offset);
     return assign_node;
 }
 
-ASTNode* parse_expression(Parser* parser) 
-{
-    return parse_assignment(parser);
+// binding power of each infix token, higher binds tighter, 0 means the token ends an expression
+typedef enum {
+    PREC_NONE,
+    PREC_ASSIGNMENT,
+    PREC_TERNARY,
+    PREC_LOGICAL_OR,
+    PREC_LOGICAL_AND,
+    PREC_COMPARISON,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE
+} Precedence;
+
+typedef enum {
+    INFIX_BINARY,
+    INFIX_ASSIGN,
+    INFIX_TERNARY
+} InfixKind;
+
+typedef struct {
+    Precedence precedence;
+    InfixKind kind;
+    // the arithmetic of a compound assignment, unused for '=' and '?'
+    BinaryOp op;
+} InfixOperator;
+
+// adding an operator is one entry here, the loop in parse_precedence does not change
+static const InfixOperator infix_operators[TOK_COUNT] = {
+    [TOK_ASSIGNMENT]                = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_ADD },
+    [TOK_ASSIGNMENT_ADDITION]       = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_ADD },
+    [TOK_ASSIGNMENT_SUBTRACTION]    = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_SUB },
+    [TOK_ASSIGNMENT_MULTIPLICATION] = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_MUL },
+    [TOK_ASSIGNMENT_DIVISION]       = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_DIV },
+    [TOK_ASSIGNMENT_MODULO]         = { PREC_ASSIGNMENT, INFIX_ASSIGN, OP_MOD },
+
+    [TOK_QUESTION]                  = { PREC_TERNARY, INFIX_TERNARY, OP_ADD },
+
+    [TOK_OR]                        = { PREC_LOGICAL_OR, INFIX_BINARY, OP_OR },
+    [TOK_AND]                       = { PREC_LOGICAL_AND, INFIX_BINARY, OP_AND },
+
+    [TOK_EQUAL]                     = { PREC_COMPARISON, INFIX_BINARY, OP_EQ },
+    [TOK_NOT_EQUAL]                 = { PREC_COMPARISON, INFIX_BINARY, OP_NE },
+    [TOK_LESS]                      = { PREC_COMPARISON, INFIX_BINARY, OP_LT },
+    [TOK_GREATER]                   = { PREC_COMPARISON, INFIX_BINARY, OP_GT },
+    [TOK_LESS_EQUALS]               = { PREC_COMPARISON, INFIX_BINARY, OP_LE },
+    [TOK_GREATER_EQUALS]            = { PREC_COMPARISON, INFIX_BINARY, OP_GE },
+
+    [TOK_ADDITION]                  = { PREC_ADDITIVE, INFIX_BINARY, OP_ADD },
+    [TOK_SUBTRACTION]               = { PREC_ADDITIVE, INFIX_BINARY, OP_SUB },
+
+    [TOK_MULTIPLICATION]            = { PREC_MULTIPLICATIVE, INFIX_BINARY, OP_MUL },
+    [TOK_DIVISION]                  = { PREC_MULTIPLICATIVE, INFIX_BINARY, OP_DIV },
+    [TOK_MODULO]                    = { PREC_MULTIPLICATIVE, INFIX_BINARY, OP_MOD }
+};
+
+static int is_assignable(ASTNode* node) {
+    return node->type == AST_IDENTIFIER || node->type == AST_MEMBER_ACCESS || node->type == AST_ARRAY_ACCESS
+        || (node->type == AST_UNARY_OP && node->as.unary_op.op == OP_DEREF);
 }
 
-ASTNode* parse_assignment(Parser* parser)
-{
-    ASTNode* left = parse_equality(parser);
-    if (left == NULL) 
+// a = b = c nests to the right, a += b stays one node so codegen evaluates the target once
+static ASTNode* parse_assignment_operator(Parser* parser, ASTNode* target, TokenType op_tok, const InfixOperator* infix) {
+    if (!is_assignable(target))
         return NULL;
-    
-    while (check(parser, TOK_ASSIGNMENT) || is_compound_token(current_token(parser)->type))
-    {
-        if (left->type != AST_IDENTIFIER && left->type != AST_MEMBER_ACCESS 
-            && (left->type != AST_UNARY_OP || left->as.unary_op.op != OP_DEREF) 
-            && left->type != AST_ARRAY_ACCESS) {
-            free_ast(left);
-            return NULL;
-        }
 
-        TokenType op_tok = current_token(parser)->type;
-        advance(parser);
-        
-        ASTNode* right = parse_assignment(parser);
-        if (right == NULL) {
-            free_ast(left);
-            return NULL;
-        }
+    ASTNode* value = parse_precedence(parser, PREC_ASSIGNMENT);
+    if (value == NULL)
+        return NULL;
 
-        BinaryOp op;
-        switch(op_tok) {
-            case TOK_ASSIGNMENT_ADDITION:       op = OP_ADD; break;
-            case TOK_ASSIGNMENT_SUBTRACTION:    op = OP_SUB; break;
-            case TOK_ASSIGNMENT_MULTIPLICATION: op = OP_MUL; break;
-            case TOK_ASSIGNMENT_DIVISION:       op = OP_DIV; break;
-            case TOK_ASSIGNMENT_MODULO:         op = OP_MOD; break;
-            case TOK_ASSIGNMENT:                return create_assign_node(left, right, current_token(parser)->line, current_token(parser)->column);
-            default: free_ast(left); free_ast(right); return NULL;
-        }
-        
-        if (left->type != AST_IDENTIFIER && left->type != AST_MEMBER_ACCESS && (left->type != AST_UNARY_OP || left->as.unary_op.op != OP_DEREF)) {
-            free_ast(left);
-            return NULL;
-        }
+    if (op_tok == TOK_ASSIGNMENT)
+        return create_assign_node(target, value, current_token(parser)->offset);
 
-        ASTNode* left_copy = create_identifier_node(strdup(left->as.identifier.name), current_token(parser)->line, current_token(parser)->column);
-        if (left_copy == NULL) {
-            free_ast(left);
-            free_ast(right);
-            return NULL;
-        }
-        
-        ASTNode* binary_node = create_binary_op_node(op, left_copy, right, current_token(parser)->line, current_token(parser)->column);
-        return create_assign_node(left, binary_node, current_token(parser)->line, current_token(parser)->column);
-    }
-    
-    return left;
+    return create_compound_assign_node(infix->op, target, value, current_token(parser)->offset);
 }
 
-ASTNode* parse_equality(Parser* parser)
-{
-    ASTNode* left = parse_additive(parser);
-    if (left == NULL) 
+// cond ? a : b, right associative so a ? b : c ? d : e nests in the else arm
+static ASTNode* parse_ternary_operator(Parser* parser, ASTNode* condition, uint32_t offset) {
+    ASTNode* then_expr = parse_expression(parser);
+    if (then_expr == NULL)
         return NULL;
 
-    while (check(parser, TOK_EQUAL) || check(parser, TOK_NOT_EQUAL) 
-        || check(parser, TOK_LESS) || check(parser, TOK_GREATER) 
-        || check(parser, TOK_LESS_EQUALS) || check(parser, TOK_GREATER_EQUALS))
-    {
-        TokenType op = current_token(parser)->type;
-        advance(parser);
-
-        ASTNode* right = parse_additive(parser);
-        if (right == NULL) {
-            free_ast(left);
-            return NULL;
-        }
-
-        BinaryOp binary_op;
-        switch(op) {
-            case TOK_EQUAL:          binary_op = OP_EQ; break;
-            case TOK_NOT_EQUAL:      binary_op = OP_NE; break;
-            case TOK_LESS:           binary_op = OP_LT; break;
-            case TOK_GREATER:        binary_op = OP_GT; break;
-            case TOK_LESS_EQUALS:    binary_op = OP_LE; break;
-            case TOK_GREATER_EQUALS: binary_op = OP_GE; break;
-            default:                 binary_op = OP_EQ; break;
-        }
-        
-        left = create_binary_op_node(binary_op, left, right, current_token(parser)->line, current_token(parser)->column);
+    if (!match(parser, TOK_COLON)) {
+        report_diagnostic("Parse error: Expected ':' in conditional expression\n");
+        return NULL;
     }
-    
-    return left;
-}
 
-ASTNode* parse_additive(Parser* parser)
-{
-    ASTNode* left = parse_multiplicative(parser);
-    if (left == NULL) 
+    ASTNode* else_expr = parse_precedence(parser, PREC_TERNARY);
+    if (else_expr == NULL)
         return NULL;
 
-    while (check(parser, TOK_ADDITION) || check(parser, TOK_SUBTRACTION))
-    {
-        TokenType op = current_token(parser)->type;
-        advance(parser);
-        
-        ASTNode* right = parse_multiplicative(parser);
-        if (right == NULL) {
-            free_ast(left);
-            return NULL;
-        }
-
-        BinaryOp binary_op;
-        switch(op) 
-        {
-            case TOK_ADDITION:      binary_op = OP_ADD; break;
-            case TOK_SUBTRACTION:   binary_op = OP_SUB; break;
-            default:                binary_op = OP_ADD; break;
-        }
-
-        left = create_binary_op_node(binary_op, left, right, current_token(parser)->line, current_token(parser)->column);
-    }
-    
-    return left;
+    return create_ternary_node(condition, then_expr, else_expr, offset);
 }
 
-ASTNode* parse_multiplicative(Parser* parser) 
+// precedence climbing: operands come from parse_unary, operators are looked up in infix_operators
+ASTNode* parse_precedence(Parser* parser, int min_precedence)
 {
     ASTNode* left = parse_unary(parser);
-    if (left == NULL) 
-        return NULL;
-    
-    while (check(parser, TOK_MULTIPLICATION) || check(parser, TOK_DIVISION) || check(parser, TOK_MODULO))
-    {
-        TokenType op = current_token(parser)->type;
+
+    while (left != NULL) {
+        Token* token = current_token(parser);
+        const InfixOperator* infix = &infix_operators[token->type];
+        if (infix->precedence == PREC_NONE || (int)infix->precedence < min_precedence)
+            break;
+
+        TokenType op_tok = token->type;
+        uint32_t offset = token->offset;
         advance(parser);
 
-        ASTNode* right = parse_unary(parser);
-        if (right == NULL) {
-            free_ast(left);
-            return NULL;
-        }
+        switch (infix->kind) {
+            case INFIX_ASSIGN:
+                return parse_assignment_operator(parser, left, op_tok, infix);
+
+            case INFIX_TERNARY:
+                left = parse_ternary_operator(parser, left, offset);
+                break;
+
+            case INFIX_BINARY: {
+                // left associative, the right operand only takes operators that bind tighter
+                ASTNode* right = parse_precedence(parser, infix->precedence + 1);
+                if (right == NULL)
+                    return NULL;
 
-        BinaryOp binary_op;
-        switch(op)
-        {
-            case TOK_MULTIPLICATION: binary_op = OP_MUL; break;
-            case TOK_DIVISION:       binary_op = OP_DIV; break;
-            case TOK_MODULO:         binary_op = OP_MOD; break;
-            default:                 binary_op = OP_MUL; break;
+                left = create_binary_op_node(infix->op, left, right, current_token(parser)->offset);
+                break;
+            }
         }
-        
-        left = create_binary_op_node(binary_op, left, right, current_token(parser)->line, current_token(parser)->column);
     }
 
     return left;
 }
 
+ASTNode* parse_expression(Parser* parser) 
+{
+    return parse_precedence(parser, PREC_ASSIGNMENT);
+}
+
+ASTNode* parse_assignment(Parser* parser)
+{
+    return parse_precedence(parser, PREC_ASSIGNMENT);
+}
+
 ASTNode* parse_negation(Parser* parser) {
     advance(parser);
     ASTNode* unary_expression = parse_unary(parser);
@@ -429,7 +500,7 @@ ASTNode* parse_negation(Parser* parser) {
         return NULL;
     }
 
-    ASTNode* unary_minus_node = create_unary_op_node(OP_NEG, unary_expression, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* unary_minus_node = create_unary_op_node(OP_NEG, unary_expression, current_token(parser)->offset);
     if (unary_minus_node == NULL) {
         free_ast(unary_expression);
         return NULL;
@@ -438,6 +509,21 @@ ASTNode* parse_negation(Parser* parser) {
     return unary_minus_node;
 }
 
+ASTNode* parse_logical_not(Parser* parser) {
+    advance(parser);
+    ASTNode* operand = parse_unary(parser);
+    if (operand == NULL)
+        return NULL;
+
+    ASTNode* not_node = create_unary_op_node(OP_NOT, operand, current_token(parser)->offset);
+    if (not_node == NULL) {
+        free_ast(operand);
+        return NULL;
+    }
+
+    return not_node;
+}
+
 ASTNode* parse_pre_decrement(Parser* parser) {
     if (!match(parser, TOK_DECREMENT))
         return NULL;
@@ -446,7 +532,7 @@ ASTNode* parse_pre_decrement(Parser* parser) {
     if (node == NULL)
         return NULL;
 
-    ASTNode* dec = create_unary_op_node(OP_PRE_DEC, node, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* dec = create_unary_op_node(OP_PRE_DEC, node, current_token(parser)->offset);
     if (dec == NULL)
         free_ast(node);
     
@@ -461,7 +547,7 @@ ASTNode* parse_pre_increment(Parser* parser) {
     if (node == NULL)
         return NULL;
 
-    ASTNode* inc = create_unary_op_node(OP_PRE_INC, node, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* inc = create_unary_op_node(OP_PRE_INC, node, current_token(parser)->offset);
     if (inc == NULL)
         free_ast(node);
     
@@ -472,7 +558,7 @@ ASTNode* parse_post_increment(Parser* parser, ASTNode* operand) {
     if (!match(parser, TOK_INCREMENT))
         return operand;
 
-    ASTNode* inc = create_unary_op_node(OP_POST_INC, operand, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* inc = create_unary_op_node(OP_POST_INC, operand, current_token(parser)->offset);
     if (inc == NULL) {
         free_ast(operand);
         return NULL;
@@ -485,7 +571,7 @@ ASTNode* parse_post_decrement(Parser* parser, ASTNode* operand) {
     if (!match(parser, TOK_DECREMENT))
         return operand;
 
-    ASTNode* dec = create_unary_op_node(OP_POST_DEC, operand, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* dec = create_unary_op_node(OP_POST_DEC, operand, current_token(parser)->offset);
     if (dec == NULL) {
         free_ast(operand);
         return NULL;
@@ -498,6 +584,7 @@ ASTNode* parse_unary(Parser* parser)
 {
     switch (current_token(parser)->type) {
         case TOK_SUBTRACTION:       return parse_negation(parser);
+        case TOK_NOT:               return parse_logical_not(parser);
         case TOK_MULTIPLICATION:    return parse_dereference(parser);
         case TOK_AMPERSAND:         return parse_address_of(parser);
         case TOK_INCREMENT:         return parse_pre_increment(parser);
@@ -521,14 +608,27 @@ ASTNode* parse_postfix(Parser* parser)
          node = parse_primary(parser);
 
     // arr[0].x[1]++ ??
-    while (check(parser, TOK_DOT) || check(parser, TOK_LBRACKET) || 
+    while (check(parser, TOK_DOT) || check(parser, TOK_ARROW) || check(parser, TOK_LBRACKET) || 
            check(parser, TOK_INCREMENT) || check(parser, TOK_DECREMENT)) 
     {
         if (match(parser, TOK_DOT)) {
             if (!check(parser, TOK_IDENTIFIER)) 
                 return NULL;
 
-            node = create_member_access_node(node, sv_to_owned_cstr(current_token(parser)->lexeme), 0, 0); // simplifed
+            node = create_member_access_node(node, copy_lexeme(parser), current_token(parser)->offset);
+            advance(parser);
+        }
+        // p->x is (*p).x
+        else if (match(parser, TOK_ARROW)) {
+            if (!check(parser, TOK_IDENTIFIER)) {
+                report_diagnostic("Parse error: expected member name after '->'\n");
+                free_ast(node);
+                return NULL;
+            }
+
+            Token* member = current_token(parser);
+            ASTNode* pointee = create_unary_op_node(OP_DEREF, node, member->offset);
+            node = create_member_access_node(pointee, ast_arena_copy_string(get_current_ast_arena(), token_lexeme(parser->tokens, member)), member->offset);
             advance(parser);
         }
         else if (match(parser, TOK_LBRACKET)) {
@@ -543,7 +643,7 @@ ASTNode* parse_postfix(Parser* parser)
                 free_ast(index);
                 return NULL;
             }
-            node = create_array_access_node(node, index, current_token(parser)->line, current_token(parser)->column);
+            node = create_array_access_node(node, index, current_token(parser)->offset);
         }
         else if (check(parser, TOK_INCREMENT))
             node = parse_post_increment(parser, node);
@@ -572,7 +672,7 @@ ASTNode* parse_parens(Parser* parser) {
         return NULL;
 
     if (!match(parser, TOK_RPAREN)) {
-        printf("Parse error: expected ')'\n");
+        report_diagnostic("Parse error: expected ')'\n");
         free_ast(node);
         return NULL;
     }
@@ -591,7 +691,7 @@ ASTNode* parse_primary_expression(Parser* parser) {
         case TOK_NUMBER_INT:
         case TOK_NUMBER_FLOAT:
         case TOK_NUMBER_DOUBLE:     return parse_number_literal(parser);
-        default: printf("Parse error: expected primary expression\n");
+        default: report_diagnostic("Parse error: expected primary expression\n");
     }
     return NULL;
 }
@@ -600,24 +700,27 @@ ASTNode* parse_number_literal(Parser* parser) {
     if (!(check(parser, TOK_NUMBER_INT) || check(parser, TOK_NUMBER_DOUBLE) || check(parser, TOK_NUMBER_FLOAT)))
         return NULL;
     
-    const char* number = sv_to_owned_cstr(current_token(parser)->lexeme);
+    const char* number = sv_to_owned_cstr(current_lexeme(parser));
 
     ASTNode* result = NULL;
     switch (current_token(parser)->type)
     {
         case TOK_NUMBER_INT: {
             long long int_val = atoll(number);
-            result = create_int_literal_node(int_val, current_token(parser)->line, current_token(parser)->column);
+            StringView lexeme = current_lexeme(parser);
+            char last = lexeme.data[lexeme.length - 1];
+            int is_unsigned = (last == 'u' || last == 'U');
+            result = create_int_literal_node(int_val, is_unsigned, current_token(parser)->offset);
             break;
         }
         case TOK_NUMBER_FLOAT: {
             float float_val = atof(number);
-            result = create_float_literal_node(float_val, current_token(parser)->line, current_token(parser)->column);
+            result = create_float_literal_node(float_val, current_token(parser)->offset);
             break;
         }
         case TOK_NUMBER_DOUBLE: {
             double double_val = atof(number);
-            result = create_double_literal_node(double_val, current_token(parser)->line, current_token(parser)->column);
+            result = create_double_literal_node(double_val, current_token(parser)->offset);
             break;
         }
 
@@ -633,25 +736,25 @@ ASTNode* parse_string_literal(Parser* parser) {
     if (!check(parser, TOK_STRING_LITERAL))
         return NULL;
 
-    char* string = sv_to_owned_cstr(current_token(parser)->lexeme);
+    char* string = copy_lexeme(parser);
     advance(parser);
 
-    return create_string_literal_node(string, current_token(parser)->line, current_token(parser)->column);;
+    return create_string_literal_node(string, current_token(parser)->offset);;
 }
 
 ASTNode* parse_char_literal(Parser* parser) {
     if (!check(parser, TOK_CHAR_LITERAL))
         return NULL;
 
-    char ch = current_token(parser)->lexeme.data[0];
+    char ch = current_lexeme(parser).data[0];
     advance(parser);
 
-    return create_char_literal_node(ch, current_token(parser)->line, current_token(parser)->column);
+    return create_char_literal_node(ch, current_token(parser)->offset);
 }
 
 ASTNode* parse_identifier_expression(Parser* parser)
 {
-    ASTNode* node = create_identifier_node(sv_to_owned_cstr(current_token(parser)->lexeme), current_token(parser)->line, current_token(parser)->column);
+    ASTNode* node = create_identifier_node(copy_lexeme(parser), current_token(parser)->offset);
     advance(parser);
     return node;
 }
@@ -667,7 +770,7 @@ ASTNode* parse_dereference(Parser* parser)
         return NULL;
     }
 
-    ASTNode* node = create_unary_op_node(OP_DEREF, expr, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* node = create_unary_op_node(OP_DEREF, expr, current_token(parser)->offset);
     if(node == NULL) {
         free_ast(expr);
         return NULL;
@@ -682,7 +785,7 @@ ASTNode* parse_address_of(Parser* parser) {
 
     advance(parser);
     ASTNode* expr = parse_unary(parser);
-    ASTNode* node = create_unary_op_node(OP_ADDR, expr, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* node = create_unary_op_node(OP_ADDR, expr, current_token(parser)->offset);
     if (node == NULL) {
         free_ast(expr);
         return NULL;
@@ -699,74 +802,96 @@ ASTNode* parse_function_call(Parser* parser)
         return NULL;
     }
 
-    char* name = sv_to_owned_cstr(current_token(parser)->lexeme);
+    char* name = copy_lexeme(parser);
     if (name == NULL)
         return NULL;
 
     advance(parser);
 
     if(!match(parser, TOK_LPAREN)) {
-        free(name);
         return NULL;
     }
 
-    ASTNode* func_call = create_func_call_node(name, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* func_call = create_func_call_node(name, current_token(parser)->offset);
     if (func_call == NULL) {
-        free(name);
         return NULL;
     }
 
+    NodeListBuilder args = begin_node_list(parser);
     while (!check(parser, TOK_RPAREN) && !check(parser, TOK_EOF))
     {
-        ASTNode* arg = parse_expression(parser);
+        ASTNode* arg = NULL;
+        if (!check(parser, TOK_IDENTIFIER) && is_type(parser, current_token(parser)->type))
+            arg = parse_type_argument(parser);
+        else
+            arg = parse_expression(parser);
+
         if(arg == NULL) {
-            printf("Parse error: expected expression in function argument\n");
+            report_diagnostic("Parse error: expected expression in function argument\n");
+            func_call->as.func_call.args = finish_node_list(parser, &args, AST_FUNC_CALL);
+            func_call->as.func_call.arg_count = args.count;
             return func_call;
         }
 
-        add_arg_to_func_call(func_call, arg);
+        append_node_list(parser, &args, arg);
 
         if (!match(parser, TOK_COMMA)) {
             break;
         }
     }
 
+    func_call->as.func_call.args = finish_node_list(parser, &args, AST_FUNC_CALL);
+    func_call->as.func_call.arg_count = args.count;
+
     if(!match(parser, TOK_RPAREN)) {
-        printf("Parse error: expected ')' after function arguments\n");
+        report_diagnostic("Parse error: expected ')' after function arguments\n");
         return func_call;
     }
 
     return func_call;
 }
 
+// builtins such as vload(float4, arr, i) take a type as an argument
+ASTNode* parse_type_argument(Parser* parser)
+{
+    uint32_t offset = current_token(parser)->offset;
+
+    TypeInfo type = parse_type(parser);
+    if (type.base_type == TOK_ERROR)
+        return NULL;
+    return create_type_node(type, offset);
+}
+
 // float pi = 3.14f;
 // int v = (int) pi;
 ASTNode* parse_casting(Parser* parser)
 {
     if(!match(parser, TOK_LPAREN)) {
-        printf("Parse error: expected: '('\n");
+        report_diagnostic("Parse error: expected: '('\n");
         return NULL;
     }
 
     if(!is_type(parser, current_token(parser)->type)) {
-        printf("Parse error: expected: 'TYPE'\n");
+        report_diagnostic("Parse error: expected: 'TYPE'\n");
         return NULL;
     }
 
     TypeInfo cast_type = parse_type(parser); 
+    if (cast_type.base_type == TOK_ERROR)
+        return NULL;
 
     if(!match(parser, TOK_RPAREN)) {
-        printf("Parse error: expected: ')'\n");
+        report_diagnostic("Parse error: expected: ')'\n");
         return NULL;
     }
 
     ASTNode* expr = parse_unary(parser);
     if(expr == NULL) {
-        printf("Parse error: expected expression after cast\n");
+        report_diagnostic("Parse error: expected expression after cast\n");
         return NULL;
     }
 
-    ASTNode* cast_node = create_cast_node(cast_type, expr, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* cast_node = create_cast_node(cast_type, expr, current_token(parser)->offset);
     if(cast_node == NULL) {
         free_ast(expr);
         printf("Memory allocation failed\n");
@@ -776,23 +901,99 @@ ASTNode* parse_casting(Parser* parser)
     return cast_node;
 }
 
+// 0 keeps the default width of the base type, -1 after reporting a width out of range
+int parse_int_bit_width(StringView lexeme)
+{
+    size_t start = (lexeme.length > 0 && lexeme.data[0] == 'u') ? 1 : 0;
+
+    if (lexeme.length - start == 4 && strncmp(lexeme.data + start, "long", 4) == 0)
+        return 64;
+
+    if (!is_sized_int_type(lexeme) && vector_type_base(lexeme) == TOK_NONE)
+        return 0;
+
+    int width = 0;
+    for (size_t i = start + 3; i < lexeme.length && lexeme.data[i] != 'x'; i++) {
+        width = width * 10 + (lexeme.data[i] - '0');
+        if (width > MAX_INT_BIT_WIDTH)
+            break;
+    }
+
+    if (width < 1 || width > MAX_INT_BIT_WIDTH) {
+        report_diagnostic("Parse error: integer width must be between 1 and %d bits\n", MAX_INT_BIT_WIDTH);
+        return -1;
+    }
+    return width;
+}
+
+// lane count of a vector type name (float4, int8x16), 0 for scalars and -1 after reporting a bad count
+int parse_vector_lanes(StringView lexeme)
+{
+    if (vector_type_base(lexeme) == TOK_NONE)
+        return 0;
+
+    size_t i = lexeme.length;
+    while (i > 0 && lexeme.data[i - 1] >= '0' && lexeme.data[i - 1] <= '9')
+        i--;
+
+    int lanes = 0;
+    for (; i < lexeme.length; i++) {
+        lanes = lanes * 10 + (lexeme.data[i] - '0');
+        if (lanes > MAX_VECTOR_LANES)
+            break;
+    }
+
+    if (lanes < 1 || lanes > MAX_VECTOR_LANES) {
+        report_diagnostic("Parse error: vector lane count must be between 1 and %d\n", MAX_VECTOR_LANES);
+        return -1;
+    }
+    return lanes;
+}
+
 TypeInfo parse_type(Parser* parser)
 {
+    int is_const = match(parser, TOK_CONST);
+
+    TypeInfo type_info;
+    memset(&type_info, 0, sizeof(type_info));
+
+    // callers check for TOK_ERROR, a bad type no longer ends the process
     if (!is_type(parser, current_token(parser)->type)) {
-        printf("Parse error: expected return type\n");
-        exit(1);
+        report_diagnostic("Parse error: expected type at line %d\n", locate_offset(&parser->tokens->lines, current_token(parser)->offset).line);
+        type_info.base_type = TOK_ERROR;
+        return type_info;
     }
 
-    TypeInfo type_info;
     type_info.is_array = 0;
     type_info.array_dim_count = 0;
+    type_info.is_decayed = 0;
+    type_info.has_static_extent = 0;
 
     type_info.base_type = current_token(parser)->type;
-    type_info.type = sv_to_owned_cstr(current_token(parser)->lexeme);
+    type_info.is_unsigned = (type_info.base_type == TOK_UINT || type_info.base_type == TOK_UCHAR);
+    type_info.bit_width = 0;
+    if (type_info.base_type == TOK_INT || type_info.base_type == TOK_UINT)
+        type_info.bit_width = parse_int_bit_width(current_lexeme(parser));
+    type_info.vector_width = parse_vector_lanes(current_lexeme(parser));
+    type_info.type = copy_lexeme(parser);
 
     advance(parser);
 
+    if (type_info.bit_width < 0 || type_info.vector_width < 0) {
+        type_info.base_type = TOK_ERROR;
+        return type_info;
+    }
+
     type_info.pointer_level = parse_pointer_level(parser);
+
+    // float* restrict out
+    type_info.is_restrict = match(parser, TOK_RESTRICT);
+    type_info.is_const = is_const;
+    if (type_info.is_restrict && type_info.pointer_level == 0) {
+        report_diagnostic("Parse error: restrict requires a pointer type\n");
+        type_info.base_type = TOK_ERROR;
+    }
+
     return type_info;
 }
 
@@ -817,6 +1018,9 @@ int check_pointer_level(Parser* parser, int offset)
     while(next_token->type == TOK_MULTIPLICATION) {
         next_token = peek_token(parser, ++offset);
     }
+
+    if (next_token->type == TOK_RESTRICT)
+        offset++;
     
     return offset - starting_offset;
 }
@@ -835,10 +1039,61 @@ int is_casting(Parser* parser) {
     return (rparen_token->type == TOK_RPAREN);
 }
 
+static int lexeme_equals(StringView lexeme, const char* text) {
+    size_t length = strlen(text);
+    return lexeme.length == length && strncmp(lexeme.data, text, length) == 0;
+}
+
+// for unroll(8) vectorize(16) interleave(2) (...), the hint names are not reserved words
+int parse_loop_hints(Parser* parser, LoopHints* hints)
+{
+    *hints = (LoopHints){0};
+
+    while (check(parser, TOK_IDENTIFIER) && peek_token(parser, 1)->type == TOK_LPAREN) {
+        StringView name = current_lexeme(parser);
+
+        int* target = NULL;
+        if (lexeme_equals(name, "unroll"))
+            target = &hints->unroll_count;
+        else if (lexeme_equals(name, "vectorize"))
+            target = &hints->vectorize_width;
+        else if (lexeme_equals(name, "interleave"))
+            target = &hints->interleave_count;
+        else
+            return 1;
+
+        advance(parser);
+        advance(parser);
+
+        if (!check(parser, TOK_NUMBER_INT)) {
+            report_diagnostic("Parse error: loop hint expects an integer count\n");
+            return 0;
+        }
+
+        char* count_str = sv_to_owned_cstr(current_lexeme(parser));
+        *target = atoi(count_str);
+        free(count_str);
+        advance(parser);
+
+        if (*target < 1) {
+            report_diagnostic("Parse error: loop hint count must be positive\n");
+            return 0;
+        }
+
+        if (!match(parser, TOK_RPAREN))
+            return 0;
+    }
+    return 1;
+}
+
 ASTNode* parse_while_loop(Parser* parser) {
     if (!match(parser, TOK_WHILE))
         return NULL;
 
+    LoopHints hints;
+    if (!parse_loop_hints(parser, &hints))
+        return NULL;
+
     if (!match(parser, TOK_LPAREN))
         return NULL;
 
@@ -853,19 +1108,25 @@ ASTNode* parse_while_loop(Parser* parser) {
         return NULL;
     }
 
+    parser->loop_depth++;
     ASTNode* body = parse_block(parser);
+    parser->loop_depth--;
     if(body == NULL) {
         free_ast(condition);
         return NULL;
     }
 
-    return create_while_node(condition, body, current_token(parser)->line, current_token(parser)->column);
+    return create_while_node(condition, body, hints, current_token(parser)->offset);
 }
 
 ASTNode* parse_for_loop(Parser* parser) {
     if (!match(parser, TOK_FOR))
         return NULL;
 
+    LoopHints hints;
+    if (!parse_loop_hints(parser, &hints))
+        return NULL;
+
     if (!match(parser, TOK_LPAREN))
         return NULL;
 
@@ -916,7 +1177,9 @@ ASTNode* parse_for_loop(Parser* parser) {
         return NULL;
     }
 
+    parser->loop_depth++;
     ASTNode* body = parse_block(parser);
+    parser->loop_depth--;
     if(body == NULL) {
         free_ast(init);
         free_ast(condition);
@@ -924,7 +1187,7 @@ ASTNode* parse_for_loop(Parser* parser) {
         return NULL;
     }
 
-    return create_for_node(init, condition, update, body, current_token(parser)->line, current_token(parser)->column);
+    return create_for_node(init, condition, update, body, hints, current_token(parser)->offset);
 }
 
 ASTNode* parse_loop_init(Parser* parser) {
@@ -972,7 +1235,7 @@ ASTNode* parse_loop_update(Parser* parser)
         return NULL;
     }
     
-    return create_assign_node(lhs, rhs, current_token(parser)->line, current_token(parser)->column);
+    return create_assign_node(lhs, rhs, current_token(parser)->offset);
 }
 
 ASTNode* parse_if(Parser* parser) {
@@ -998,7 +1261,7 @@ ASTNode* parse_if(Parser* parser) {
     }
     
     if (!check(parser, TOK_ELSE))
-        return create_if_node(condition, then_branch, NULL, current_token(parser)->line, current_token(parser)->column);
+        return create_if_node(condition, then_branch, NULL, current_token(parser)->offset);
 
     advance(parser);
 
@@ -1009,7 +1272,7 @@ ASTNode* parse_if(Parser* parser) {
         return NULL;
     }
     
-    return create_if_node(condition, then_branch, else_branch, current_token(parser)->line, current_token(parser)->column);
+    return create_if_node(condition, then_branch, else_branch, current_token(parser)->offset);
 }
 
 ASTNode* parse_else(Parser* parser) {
@@ -1033,42 +1296,60 @@ int is_compound_token(TokenType type) {
     return 0;
 }
 
-ASTNode* parse_variable_declaration(Parser* parser) {
-    TypeInfo type = parse_type(parser);
-    if (current_token(parser)->type != TOK_IDENTIFIER) {
-        printf("Parse error: expected variable name\n");
-        return NULL;
-    }
-    
-    char* name = sv_to_owned_cstr(current_token(parser)->lexeme);
-    if (name == NULL)
-        return NULL;
-
-    advance(parser);
-
+// [N][M]... after a declared name, a parameter may leave its first extent empty (float a[])
+// or make it a guarantee for the callee (float a[static N])
+int parse_array_dimensions(Parser* parser, TypeInfo* type, int allow_unsized_first)
+{
     while (match(parser, TOK_LBRACKET)) {
-        type.is_array = 1;
+        type->is_array = 1;
 
-        if (type.array_dim_count >= MAX_ARRAY_DIMS) {
-            free(name);
-            return NULL;
+        if (type->array_dim_count >= MAX_ARRAY_DIMS)
+            return 0;
+
+        if (allow_unsized_first && type->array_dim_count == 0 && check(parser, TOK_IDENTIFIER) && lexeme_equals(current_lexeme(parser), "static")) {
+            advance(parser);
+            if (!check(parser, TOK_NUMBER_INT))
+                return 0;
+            type->has_static_extent = 1;
         }
 
         if (check(parser, TOK_NUMBER_INT)) {
-            char* size_str = sv_to_owned_cstr(current_token(parser)->lexeme);
-            type.array_sizes[type.array_dim_count++] = atoi(size_str);            
+            char* size_str = sv_to_owned_cstr(current_lexeme(parser));
+            type->array_sizes[type->array_dim_count++] = atoi(size_str);            
             free(size_str);
             advance(parser);
         } 
+        else if (allow_unsized_first && type->array_dim_count == 0 && check(parser, TOK_RBRACKET)) {
+            type->array_sizes[type->array_dim_count++] = 0;
+        }
         else {
-            free(name);
-            return NULL;
+            return 0;
         }
 
-        if (!match(parser, TOK_RBRACKET)) {
-            free(name);
-            return NULL;
-        }
+        if (!match(parser, TOK_RBRACKET))
+            return 0;
+    }
+    return 1;
+}
+
+ASTNode* parse_variable_declaration(Parser* parser) {
+    TypeInfo type = parse_type(parser);
+    if (type.base_type == TOK_ERROR)
+        return NULL;
+
+    if (current_token(parser)->type != TOK_IDENTIFIER) {
+        report_diagnostic("Parse error: expected variable name\n");
+        return NULL;
+    }
+    
+    char* name = copy_lexeme(parser);
+    if (name == NULL)
+        return NULL;
+
+    advance(parser);
+
+    if (!parse_array_dimensions(parser, &type, 0)) {
+        return NULL;
     }
 
     ASTNode* expr = NULL;
@@ -1076,19 +1357,22 @@ ASTNode* parse_variable_declaration(Parser* parser) {
     {
         expr = parse_expression(parser);
         if(expr == NULL) {
-            free(name);
             return NULL;
         }
     }
     
     if (!match(parser, TOK_SEMICOLON)) {
-        printf("Parse error: expected ';'\n");
-        free(name);
+        report_diagnostic("Parse error: expected ';'\n");
         free_ast(expr);
         return NULL;
     }
 
-    return create_var_decl_node(name, type, expr, current_token(parser)->line, current_token(parser)->column);
+    if (type.is_const && expr == NULL) {
+        report_diagnostic("Parse error: const variable '%s' requires an initializer\n", name);
+        return NULL;
+    }
+
+    return create_var_decl_node(name, type, expr, current_token(parser)->offset);
 }
 
 ASTNode* parse_struct_member(Parser* parser) {
@@ -1102,7 +1386,7 @@ char* parse_struct_name(Parser* parser) {
     if (!check(parser, TOK_IDENTIFIER))
         return NULL;
     
-    char* name = sv_to_owned_cstr(current_token(parser)->lexeme);
+    char* name = copy_lexeme(parser);
     advance(parser);
 
     return name;
@@ -1115,28 +1399,33 @@ ASTNode* parse_struct_declaration(Parser* parser) {
     char* name = parse_struct_name(parser);
 
     if (!match(parser, TOK_LBRACE)) {
-        free(name);
         return NULL;
     }
     
-    ASTNode* struct_decl = create_struct_decl_node(name, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* struct_decl = create_struct_decl_node(name, current_token(parser)->offset);
     if (struct_decl == NULL) {
-        free(name);
         return NULL;
     }
     
+    NodeListBuilder members = begin_node_list(parser);
     while (!check(parser, TOK_RBRACE) && !check(parser, TOK_EOF))
     {
         if (is_type(parser, current_token(parser)->type)) {
+            int start_token = parser->current_token;
             ASTNode* member = parse_struct_member(parser);
-            if(member == NULL)
+            if(member == NULL) {
+                recover_from_error(parser, start_token);
                 continue;
+            }
 
-            add_member_to_struct(struct_decl, member);
+            append_node_list(parser, &members, member);
         }
         else
             advance(parser);
     }
+
+    struct_decl->as.struct_decl.members = finish_node_list(parser, &members, AST_STRUCT_DECL);
+    struct_decl->as.struct_decl.member_count = members.count;
     
     if (!match(parser, TOK_RBRACE)) {
         free_ast(struct_decl);
@@ -1153,7 +1442,7 @@ ASTNode* parse_struct_declaration(Parser* parser) {
 
 ASTNode* parse_return(Parser* parser) {
     if (!match(parser, TOK_RETURN)) {
-        printf("Parse error: expected 'return'\n");
+        report_diagnostic("Parse error: expected 'return'\n");
         return NULL;
     }
 
@@ -1166,11 +1455,33 @@ ASTNode* parse_return(Parser* parser) {
     }
 
     if (!match(parser, TOK_SEMICOLON)) {
-        printf("Parse error: expected ';' after return\n");
+        report_diagnostic("Parse error: expected ';' after return\n");
         free_ast(expr);
         return NULL;
     }
-    return create_return_node(expr, current_token(parser)->line, current_token(parser)->column);
+    return create_return_node(expr, current_token(parser)->offset);
+}
+
+// break; and continue; carry no operands, the loop they belong to is resolved during codegen
+ASTNode* parse_loop_jump(Parser* parser) {
+    Token* keyword = current_token(parser);
+    int is_break = keyword->type == TOK_BREAK;
+    advance(parser);
+
+    if (!match(parser, TOK_SEMICOLON)) {
+        report_diagnostic("Parse error: expected ';' after '%s'\n", is_break ? "break" : "continue");
+        return NULL;
+    }
+
+    if (parser->loop_depth == 0) {
+        report_diagnostic("Parse error: '%s' outside of a loop at line %d\n", is_break ? "break" : "continue",
+            locate_offset(&parser->tokens->lines, keyword->offset).line);
+        return NULL;
+    }
+
+    if (is_break)
+        return create_break_node(keyword->offset);
+    return create_continue_node(keyword->offset);
 }
 
 ASTNode* parse_statement(Parser* parser) {
@@ -1178,6 +1489,8 @@ ASTNode* parse_statement(Parser* parser) {
     switch (current_token(parser)->type)
     {
         case TOK_RETURN:            return parse_return(parser);
+        case TOK_BREAK:             return parse_loop_jump(parser);
+        case TOK_CONTINUE:          return parse_loop_jump(parser);
         case TOK_IF:                return parse_if(parser);
         case TOK_FOR:               return parse_for_loop(parser);
         case TOK_WHILE:             return parse_while_loop(parser);
@@ -1187,7 +1500,7 @@ ASTNode* parse_statement(Parser* parser) {
         default: break;
     }
 
-    if (is_type(parser, current_token(parser)->type))
+    if (check(parser, TOK_CONST) || is_type(parser, current_token(parser)->type))
         return parse_variable_declaration(parser);
 
     ASTNode* node = parse_expression(parser);
@@ -1195,121 +1508,241 @@ ASTNode* parse_statement(Parser* parser) {
         return NULL;
 
     if (!match(parser, TOK_SEMICOLON)) {
-        printf("Parse error: expected ';'\n");
+        report_diagnostic("Parse error: expected ';'\n");
         free_ast(node);
         return NULL;
     }
     return node;
 }
 
-void add_statement_to_block(ASTNode* block, ASTNode* stmt) {
-    if (block == NULL || stmt == NULL)
-        return;
-
-    block->as.block.statements = realloc(block->as.block.statements, sizeof(ASTNode*) * (block->as.block.statement_count + 1));
-    block->as.block.statements[block->as.block.statement_count++] = stmt;
-}
-
 ASTNode* parse_block(Parser* parser)
 {
     if (!match(parser, TOK_LBRACE)) {
-        printf("Parse error: expected '{'\n");
+        report_diagnostic("Parse error: expected '{'\n");
         return NULL;
     }
 
-    ASTNode* block = create_block_node(current_token(parser)->line, current_token(parser)->column);
+    ASTNode* block = create_block_node(current_token(parser)->offset);
     if (block == NULL)
         return NULL;
 
+    NodeListBuilder statements = begin_node_list(parser);
     while (!check(parser, TOK_RBRACE) && !check(parser, TOK_EOF)) {
+        int start_token = parser->current_token;
         ASTNode* stmt = parse_statement(parser);
-        if(stmt == NULL)
+        if(stmt == NULL) {
+            recover_from_error(parser, start_token);
             continue;
+        }
 
-        add_statement_to_block(block, stmt);
+        append_node_list(parser, &statements, stmt);
     }
 
+    block->as.block.statements = finish_node_list(parser, &statements, AST_BLOCK);
+    block->as.block.statement_count = statements.count;
+
     if (!match(parser, TOK_RBRACE)) {
-        printf("Parse error: expected '}'\n");
-        free(block);
+        report_diagnostic("Parse error: expected '}'\n");
         return NULL;
     }
     return block;
 }
 
+// export and const are keywords, inline noinline hot cold pure are only qualifiers here and stay usable as names
+static int function_qualifier_at(Parser* parser, int offset)
+{
+    Token* token = peek_token(parser, offset);
+    if (token->type == TOK_EXPORT)
+        return FUNC_QUAL_EXPORT;
+    if (token->type == TOK_CONST)
+        return FUNC_QUAL_CONST;
+    if (token->type != TOK_IDENTIFIER)
+        return FUNC_QUAL_NONE;
+
+    StringView name = token_lexeme(parser->tokens, token);
+    if (lexeme_equals(name, "inline"))
+        return FUNC_QUAL_INLINE;
+    if (lexeme_equals(name, "noinline"))
+        return FUNC_QUAL_NOINLINE;
+    if (lexeme_equals(name, "hot"))
+        return FUNC_QUAL_HOT;
+    if (lexeme_equals(name, "cold"))
+        return FUNC_QUAL_COLD;
+    if (lexeme_equals(name, "pure"))
+        return FUNC_QUAL_PURE;
+    return FUNC_QUAL_NONE;
+}
+
+// qualifiers in front of type name (, -1 when no function declaration starts here
+static int function_qualifier_count(Parser* parser)
+{
+    int count = 0;
+    while (function_qualifier_at(parser, count) != FUNC_QUAL_NONE)
+        count++;
+
+    if (!is_type(parser, peek_token(parser, count)->type))
+        return -1;
+    if (peek_token(parser, count + 1)->type != TOK_IDENTIFIER || peek_token(parser, count + 2)->type != TOK_LPAREN)
+        return -1;
+    return count;
+}
+
 int is_func_declaration(Parser* parser) {
-    if(!is_type(parser, current_token(parser)->type))
-        return 0;
+    return function_qualifier_count(parser) >= 0;
+}
 
-    Token* next_token = peek_token(parser, 1);
-    if (next_token->type != TOK_IDENTIFIER)
-        return 0;
+// export inline noinline hot cold pure const, in any order before the return type
+int parse_function_qualifiers(Parser* parser)
+{
+    int qualifiers = FUNC_QUAL_NONE;
 
-    Token* third_token = peek_token(parser, 2);
-    return (third_token->type == TOK_LPAREN);
+    int count = function_qualifier_count(parser);
+    for (int i = 0; i < count; i++) {
+        qualifiers |= function_qualifier_at(parser, 0);
+        advance(parser);
+    }
+
+    if ((qualifiers & FUNC_QUAL_INLINE) && (qualifiers & FUNC_QUAL_NOINLINE)) {
+        report_diagnostic("Parse error: function cannot be both inline and noinline\n");
+        return -1;
+    }
+
+    if ((qualifiers & FUNC_QUAL_HOT) && (qualifiers & FUNC_QUAL_COLD)) {
+        report_diagnostic("Parse error: function cannot be both hot and cold\n");
+        return -1;
+    }
+
+    return qualifiers;
 }
 
 ASTNode* parse_parameters(Parser* parser, ASTNode* func)
 {
     if (!match(parser, TOK_LPAREN)) {
-        printf("Parse error: expected '('\n");
+        report_diagnostic("Parse error: expected '('\n");
         return NULL;
     }
 
+    NodeListBuilder params = begin_node_list(parser);
     while (!check(parser, TOK_RPAREN) && !check(parser, TOK_EOF)) 
     {
-        if (!is_type(parser, current_token(parser)->type)) {
-            printf("Parse error: expected type in parameter list\n");
+        if (!check(parser, TOK_CONST) && !is_type(parser, current_token(parser)->type)) {
+            report_diagnostic("Parse error: expected type in parameter list\n");
             return NULL;
         }
 
         TypeInfo type = parse_type(parser);
+        if (type.base_type == TOK_ERROR)
+            return NULL;
+
         if (!check(parser, TOK_IDENTIFIER)) {
-            printf("Parse error: expected parameter name\n");
+            report_diagnostic("Parse error: expected parameter name\n");
             return NULL;
         }
 
-        char* param_name = sv_to_owned_cstr(current_token(parser)->lexeme);
+        char* param_name = copy_lexeme(parser);
         if(param_name == NULL)
             return NULL;
 
         advance(parser);
 
-        ASTNode* param = create_param_node(param_name, type, current_token(parser)->line, current_token(parser)->column);
+        if (!parse_array_dimensions(parser, &type, 1)) {
+            report_diagnostic("Parse error: invalid array extent for parameter '%s'\n", param_name);
+            return NULL;
+        }
+        type.is_decayed = type.is_array;
+
+        ASTNode* param = create_param_node(param_name, type, current_token(parser)->offset);
         if (param == NULL)
             return NULL;
 
-        add_param_to_function(func, param);
+        append_node_list(parser, &params, param);
 
         if (!match(parser, TOK_COMMA))
             break;
     }
 
+    func->as.function.params = finish_node_list(parser, &params, AST_FUNCTION);
+    func->as.function.param_count = params.count;
+
     if (!match(parser, TOK_RPAREN)) {
-        printf("Parse error: expected ')'\n");
+        report_diagnostic("Parse error: expected ')'\n");
         return NULL;
     }
 
     return func;
 }
 
+// steps over a body by brace matching, an unbalanced one is left for parse_block to report
+static int defer_function_body(Parser* parser, ASTNode* func)
+{
+    int body_start = parser->current_token;
+    int depth = 0;
+    int end = body_start;
+    for (; end < parser->tokens->token_count; end++) {
+        TokenType type = parser->tokens->tokens[end].type;
+        if (type == TOK_LBRACE)
+            depth++;
+        else if (type == TOK_RBRACE && --depth == 0)
+            break;
+        else if (type == TOK_EOF || type == TOK_ERROR)
+            return 0;
+    }
+    if (end >= parser->tokens->token_count)
+        return 0;
+
+    if (parser->deferred_count >= parser->deferred_capacity) {
+        int capacity = parser->deferred_capacity == 0 ? 64 : parser->deferred_capacity * 2;
+        DeferredBody* deferred = realloc(parser->deferred, sizeof(DeferredBody) * capacity);
+        if (deferred == NULL)
+            return 0;
+
+        parser->deferred = deferred;
+        parser->deferred_capacity = capacity;
+    }
+
+    parser->deferred[parser->deferred_count++] = (DeferredBody) { func, body_start, end + 1 };
+    parser->current_token = end + 1;
+    return 1;
+}
+
+// parses a body recorded by the skeleton scan into the current thread's arena, fails if it
+// reports anything or stops short of its closing brace
+int parse_deferred_body(Parser* parser, const DeferredBody* deferred)
+{
+    int error_count = parser->error_count;
+    parser->current_token = deferred->body_start;
+
+    ASTNode* body = parse_block(parser);
+    if (body == NULL || parser->error_count != error_count || parser->current_token != deferred->body_end)
+        return 0;
+
+    deferred->function->as.function.body = body;
+    return 1;
+}
+
 ASTNode* parse_function(Parser* parser)
 {
+    int qualifiers = parse_function_qualifiers(parser);
+    if (qualifiers < 0)
+        return NULL;
+
     TypeInfo return_type = parse_type(parser);
+    if (return_type.base_type == TOK_ERROR)
+        return NULL;
+
     if (!check(parser, TOK_IDENTIFIER)) {
-        printf("Parse error: expected function name\n");
+        report_diagnostic("Parse error: expected function name\n");
         return NULL;
     }
 
-    char* name = sv_to_owned_cstr(current_token(parser)->lexeme);
+    char* name = copy_lexeme(parser);
     if(name == NULL)
         return NULL;
 
     advance(parser);
 
-    ASTNode* func = create_function_node(name, return_type, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* func = create_function_node(name, return_type, qualifiers, current_token(parser)->offset);
     if (func == NULL) {
-        free(name);
         return NULL;
     }
     
@@ -1317,6 +1750,9 @@ ASTNode* parse_function(Parser* parser)
         free_ast(func);
         return NULL;
     }
+
+    if (parser->defer_bodies && check(parser, TOK_LBRACE) && defer_function_body(parser, func))
+        return func;
     
     ASTNode* body = parse_block(parser);
     if(body == NULL) {
@@ -1328,83 +1764,208 @@ ASTNode* parse_function(Parser* parser)
     return func;
 }
 
+// export const int limit = 10;
+ASTNode* parse_global_declaration(Parser* parser)
+{
+    int is_exported = match(parser, TOK_EXPORT);
+
+    ASTNode* var_decl = parse_variable_declaration(parser);
+    if (var_decl == NULL)
+        return NULL;
+
+    var_decl->as.var_decl.is_exported = is_exported;
+    return var_decl;
+}
+
 /* namespace main */
 char* parse_namespace_name(Parser* parser)
 {
     if (!match(parser, TOK_NAMESPACE)) {
-        printf("Parse error: expected 'namespace'\n");
+        report_diagnostic("Parse error: expected 'namespace'\n");
         return NULL;
     }
     
     if (!check(parser, TOK_IDENTIFIER)) {
-        printf("Parse error: expected namespace name\n");
+        report_diagnostic("Parse error: expected namespace name\n");
         return NULL;
     }
     
-    char* namespace_name = sv_to_owned_cstr(current_token(parser)->lexeme);
+    char* namespace_name = copy_lexeme(parser);
     advance(parser);
 
     return namespace_name;
 }
 
-ASTNode* parse_program(Parser* parser) {
+// top-level items are collected in source order and split by kind once the namespace is closed
+static ASTNode** collect_program_items(Parser* parser, NodeListBuilder* items, ASTNodeType type, int* count) {
+    NodeListBuilder list = begin_node_list(parser);
+    for (int i = 0; i < items->count; i++) {
+        ASTNode* item = parser->scratch[items->base + i];
+        if (item->type == type)
+            append_node_list(parser, &list, item);
+    }
+
+    *count = list.count;
+    return finish_node_list(parser, &list, AST_PROGRAM);
+}
+
+static ASTNode* parse_program_items(Parser* parser) {
     if(!check(parser, TOK_NAMESPACE))
         return NULL;
 
     char* namespace_name = parse_namespace_name(parser);
 
     if (!match(parser, TOK_LBRACE)) {
-        printf("Parse error: expected '{'\n");
-        free(namespace_name);
+        report_diagnostic("Parse error: expected '{'\n");
         return NULL;
     }
     
-    ASTNode* program = create_program_node(namespace_name, current_token(parser)->line, current_token(parser)->column);
+    ASTNode* program = create_program_node(namespace_name, current_token(parser)->offset);
     if (program == NULL) {
-        free(namespace_name);
         return NULL;
     }
+    program->as.program.lines = &parser->tokens->lines;
 
+    NodeListBuilder items = begin_node_list(parser);
     while (!check(parser, TOK_RBRACE) && !check(parser, TOK_EOF)) {
+        int start_token = parser->current_token;
 
+        ASTNode* item = NULL;
         if (is_func_declaration(parser))
-        {
-            ASTNode* func = parse_function(parser);
-            if(func == NULL)
-                continue;
+            item = parse_function(parser);
+        else if (check(parser, TOK_STRUCT))
+            item = parse_struct_declaration(parser);
+        else if (check(parser, TOK_EXPORT) || check(parser, TOK_CONST) || is_type(parser, current_token(parser)->type))
+            item = parse_global_declaration(parser);
+        else
+            report_diagnostic("Parse error: unexpected token in namespace\n");
 
-            add_function_to_program(program, func);
+        if(item == NULL) {
+            recover_from_error(parser, start_token);
+            continue;
         }
-        else if (check(parser, TOK_STRUCT)) {
-            ASTNode* struct_node = parse_struct_declaration(parser);
-            if(struct_node == NULL)
-                continue;
 
-            add_struct_to_program(program, struct_node);
-        }
-        else if (is_type(parser, current_token(parser)->type))
-        {
-            ASTNode* var_decl = parse_variable_declaration(parser);
-            if(var_decl == NULL)
-                continue;
-
-            add_global_to_program(program, var_decl);
-        }
-        else
-        {
-            printf("Parse error: unexpected token in namespace\n");
-            advance(parser);
-        }
+        append_node_list(parser, &items, item);
     }
 
     if (!match(parser, TOK_RBRACE)) {
-        printf("Parse error: expected '}'\n");
+        report_diagnostic("Parse error: expected '}'\n");
+        return NULL;
+    }
+
+    // the partitions are pushed above the items so reading them stays valid
+    ProgramNode* node = &program->as.program;
+    node->functions = collect_program_items(parser, &items, AST_FUNCTION, &node->function_count);
+    node->structs = collect_program_items(parser, &items, AST_STRUCT_DECL, &node->struct_count);
+    node->globals = collect_program_items(parser, &items, AST_VAR_DECL, &node->global_count);
+    parser->scratch_count = items.base;
+    return program;
+}
+
+static ASTNode* parse_program_in_arena(Parser* parser) {
+    AstArena* arena = create_ast_arena();
+    if (arena == NULL)
+        return NULL;
+
+    AstArena* previous = set_current_ast_arena(arena);
+    ASTNode* program = parse_program_items(parser);
+    set_current_ast_arena(previous);
+
+    free(parser->scratch);
+    parser->scratch = NULL;
+    parser->scratch_count = 0;
+    parser->scratch_capacity = 0;
+
+    if (program == NULL) {
+        free_ast_arena(arena);
         return NULL;
     }
 
+    program->as.program.arena = arena;
     return program;
 }
 
+ASTNode* parse_program(Parser* parser) {
+    ASTNode* program = parse_program_in_arena(parser);
+    if (program != NULL)
+        count_ast_nodes(program);
+    return program;
+}
+
+// signatures, structs and globals only, each balanced function body is left NULL and recorded in
+// parser->deferred for parse_deferred_body, nodes are not counted until the bodies are in
+ASTNode* parse_program_skeleton(Parser* parser) {
+    parser->deferred_count = 0;
+    parser->defer_bodies = 1;
+    ASTNode* program = parse_program_in_arena(parser);
+    parser->defer_bodies = 0;
+    return program;
+}
+
+static const char* binary_op_name(BinaryOp op) {
+    switch (op) {
+        case OP_ADD: return "Addition";
+        case OP_SUB: return "Subtraction";
+        case OP_MUL: return "Multiplication";
+        case OP_DIV: return "Division";
+        case OP_MOD: return "Modulo";
+        case OP_EQ:  return "Equal";
+        case OP_NE:  return "NotEqual";
+        case OP_LT:  return "Less";
+        case OP_GT:  return "Greater";
+        case OP_LE:  return "LessEqual";
+        case OP_GE:  return "GreaterEqual";
+        case OP_AND: return "And";
+        case OP_OR:  return "Or";
+        default:     return "Unknown";
+    }
+}
+
+static void print_loop_hints(LoopHints hints) {
+    if (hints.unroll_count > 0)
+        printf(" unroll(%d)", hints.unroll_count);
+    if (hints.vectorize_width > 0)
+        printf(" vectorize(%d)", hints.vectorize_width);
+    if (hints.interleave_count > 0)
+        printf(" interleave(%d)", hints.interleave_count);
+    printf("\n");
+}
+
+const char* ast_type_name(ASTNodeType type) {
+    switch (type) {
+        case AST_PROGRAM:        return "PROGRAM";
+        case AST_FUNCTION:       return "FUNCTION";
+        case AST_BLOCK:          return "BLOCK";
+        case AST_PARAM_LIST:     return "PARAM_LIST";
+        case AST_RETURN:         return "RETURN";
+        case AST_VAR_DECL:       return "VAR_DECL";
+        case AST_ASSIGN:         return "ASSIGN";
+        case AST_IF:             return "IF";
+        case AST_FOR:            return "FOR";
+        case AST_WHILE:          return "WHILE";
+        case AST_BREAK:          return "BREAK";
+        case AST_CONTINUE:       return "CONTINUE";
+        case AST_IDENTIFIER:     return "IDENTIFIER";
+        case AST_STRING_LITERAL: return "STRING_LITERAL";
+        case AST_CHAR_LITERAL:   return "CHAR_LITERAL";
+        case AST_INT_LITERAL:    return "INT_LITERAL";
+        case AST_FLOAT_LITERAL:  return "FLOAT_LITERAL";
+        case AST_DOUBLE_LITERAL: return "DOUBLE_LITERAL";
+        case AST_EXPRESSION:     return "EXPRESSION";
+        case AST_FUNC_CALL:      return "FUNC_CALL";
+        case AST_CAST:           return "CAST";
+        case AST_BINARY_OP:      return "BINARY_OP";
+        case AST_UNARY_OP:       return "UNARY_OP";
+        case AST_TERNARY:        return "TERNARY";
+        case AST_STRUCT_DECL:    return "STRUCT_DECL";
+        case AST_MEMBER_ACCESS:  return "MEMBER_ACCESS";
+        case AST_ARRAY_ACCESS:   return "ARRAY_ACCESS";
+        case AST_PRINT:          return "PRINT";
+        case AST_TYPE:           return "TYPE";
+        default:            return "UNKNOWN";
+    }
+}
+
 void print_ast(ASTNode* node, int level) 
 {
     if(node == NULL) return;
@@ -1425,7 +1986,7 @@ void print_ast(ASTNode* node, int level)
             
         case AST_FUNCTION:
             printf("Function (return type %s, name %s)\n", 
-                token_type_name(node->as.function.return_type.base_type), 
+                token_type_name(get_type_info(node->as.function.return_type)->base_type), 
                 node->as.function.name);
             for (int i = 0; i < node->as.function.param_count; i++)
                 print_ast(node->as.function.params[i], level + 1);
@@ -1435,9 +1996,9 @@ void print_ast(ASTNode* node, int level)
             
         case AST_PARAM_LIST:
             printf("Parameter (type %s, name %s, level %d)\n", 
-                token_type_name(node->as.param.type.base_type),
+                token_type_name(get_type_info(node->as.param.type)->base_type),
                 node->as.param.name,
-                node->as.param.type.pointer_level);
+                get_type_info(node->as.param.type)->pointer_level);
             break;
             
         case AST_BLOCK:
@@ -1446,6 +2007,14 @@ void print_ast(ASTNode* node, int level)
                 print_ast(node->as.block.statements[i], level + 1);
             break;
             
+        case AST_BREAK:
+            printf("Break\n");
+            break;
+
+        case AST_CONTINUE:
+            printf("Continue\n");
+            break;
+
         case AST_RETURN:
             printf("Return\n");
             if (node->as.return_stmt.value)
@@ -1453,7 +2022,10 @@ void print_ast(ASTNode* node, int level)
             break;
             
         case AST_ASSIGN:
-            printf("Assign\n");
+            if (node->as.assign.is_compound)
+                printf("CompoundAssign(%s)\n", binary_op_name(node->as.assign.op));
+            else
+                printf("Assign\n");
             if (node->as.assign.target)
                 print_ast(node->as.assign.target, level + 1);
             if (node->as.assign.value)
@@ -1461,10 +2033,10 @@ void print_ast(ASTNode* node, int level)
             break;
             
         case AST_VAR_DECL:
-            printf("VariableDecl(type: %s", node->as.var_decl.type.type);
-            if (node->as.var_decl.type.is_array) {
-                for(int i = 0; i < node->as.var_decl.type.array_dim_count; i++) {
-                    printf("[%d]", node->as.var_decl.type.array_sizes[i]);
+            printf("VariableDecl(type: %s", get_type_info(node->as.var_decl.type)->type);
+            if (get_type_info(node->as.var_decl.type)->is_array) {
+                for(int i = 0; i < get_type_info(node->as.var_decl.type)->array_dim_count; i++) {
+                    printf("[%d]", get_type_info(node->as.var_decl.type)->array_sizes[i]);
                 }
             }    
             printf(", name: %s)\n", node->as.var_decl.name);
@@ -1486,6 +2058,7 @@ void print_ast(ASTNode* node, int level)
                     case OP_POST_DEC:   op_name = "Post Decrement"; break;
                     case OP_PRE_INC:    op_name = "Pre Increment"; break;
                     case OP_PRE_DEC:    op_name = "Pre Decrement"; break;
+                    case OP_NOT:        op_name = "Not"; break;
                     default:            op_name = "Unknown"; break;
                 }
                 printf("UnaryOp(%s)\n", op_name);
@@ -1507,22 +2080,7 @@ void print_ast(ASTNode* node, int level)
             break;
             
         case AST_BINARY_OP: {
-            const char* op_name = NULL;
-            switch (node->as.binary_op.op) {
-                case OP_ADD: op_name = "Addition"; break;
-                case OP_SUB: op_name = "Subtraction"; break;
-                case OP_MUL: op_name = "Multiplication"; break;
-                case OP_DIV: op_name = "Division"; break;
-                case OP_MOD: op_name = "Modulo"; break;
-                case OP_EQ:  op_name = "Equal"; break;
-                case OP_NE:  op_name = "NotEqual"; break;
-                case OP_LT:  op_name = "Less"; break;
-                case OP_GT:  op_name = "Greater"; break;
-                case OP_LE:  op_name = "LessEqual"; break;
-                case OP_GE:  op_name = "GreaterEqual"; break;
-                default:     op_name = "Unknown"; break;
-            }
-            printf("BinaryOp(%s)\n", op_name);
+            printf("BinaryOp(%s)\n", binary_op_name(node->as.binary_op.op));
             if (node->as.binary_op.left)
                 print_ast(node->as.binary_op.left, level + 1);
             if (node->as.binary_op.right)
@@ -1550,7 +2108,8 @@ void print_ast(ASTNode* node, int level)
             break;
             
         case AST_FOR:
-            printf("For\n");
+            printf("For");
+            print_loop_hints(node->as.for_stmt.hints);
             if (node->as.for_stmt.init) {
                 for (int i = 0; i < level + 1; i++) printf("  ");
                 printf("Init:\n");
@@ -1574,12 +2133,12 @@ void print_ast(ASTNode* node, int level)
             break;
         case AST_PRINT:
             printf("PrintStatement\n");
-            if (node->as.print.expression) {
-                print_ast(node->as.print.expression, level + 1);
-            }
+            for (int i = 0; i < node->as.print.expression_count; i++)
+                print_ast(node->as.print.expressions[i], level + 1);
             break;
         case AST_WHILE:
-            printf("While\n");
+            printf("While");
+            print_loop_hints(node->as.while_stmt.hints);
             if (node->as.while_stmt.condition) {
                 for (int i = 0; i < level + 1; i++) printf("  ");
                 printf("Condition:\n");
@@ -1613,10 +2172,27 @@ void print_ast(ASTNode* node, int level)
                 printf("Index:\n");
             print_ast(node->as.array_access.index, level + 2);
             break;
+        case AST_TYPE:
+            printf("Type(%s)\n", get_type_info(node->as.type_arg.type)->type);
+            break;
+
+        case AST_TERNARY:
+            printf("Ternary\n");
+            for (int i = 0; i < level + 1; i++) printf("  ");
+            printf("Condition:\n");
+            print_ast(node->as.ternary.condition, level + 2);
+            for (int i = 0; i < level + 1; i++) printf("  ");
+            printf("Then:\n");
+            print_ast(node->as.ternary.then_expr, level + 2);
+            for (int i = 0; i < level + 1; i++) printf("  ");
+            printf("Else:\n");
+            print_ast(node->as.ternary.else_expr, level + 2);
+            break;
+
         case AST_CAST:
-            printf("Cast(to %s", token_type_name(node->as.cast.target_type.base_type));
-            if (node->as.cast.target_type.pointer_level > 0) {
-                for (int i = 0; i < node->as.cast.target_type.pointer_level; i++)
+            printf("Cast(to %s", token_type_name(get_type_info(node->as.cast.target_type)->base_type));
+            if (get_type_info(node->as.cast.target_type)->pointer_level > 0) {
+                for (int i = 0; i < get_type_info(node->as.cast.target_type)->pointer_level; i++)
                     printf("*");
             }
             printf(")\n");
@@ -1635,7 +2211,7 @@ void print_ast(ASTNode* node, int level)
             break;
             
         case AST_INT_LITERAL:
-            printf("IntLiteral(%lld)\n", node->as.int_literal.value);
+            printf("IntLiteral(%lld%s)\n", node->as.int_literal.value, node->as.int_literal.is_unsigned ? "u" : "");
             break;
             
         case AST_FLOAT_LITERAL:
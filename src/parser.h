@@ -16,6 +16,8 @@ typedef enum {
     AST_IF,
     AST_FOR,
     AST_WHILE,
+    AST_BREAK,
+    AST_CONTINUE,
     
     AST_IDENTIFIER,
     AST_STRING_LITERAL,
@@ -30,17 +32,21 @@ typedef enum {
 
     AST_BINARY_OP,
     AST_UNARY_OP,
+    AST_TERNARY,
     
     AST_STRUCT_DECL,
     AST_MEMBER_ACCESS,
     AST_ARRAY_ACCESS, 
-    AST_PRINT
+    AST_PRINT,
+    AST_TYPE,
+
+    AST_NODE_TYPE_COUNT
 } ASTNodeType;
 
 struct ASTNode {
     ASTNodeType type;
-    int line;
-    int column;
+    // byte offset of the first token, see locate_offset for line and column
+    uint32_t offset;
 
     union {
         ProgramNode program;
@@ -59,11 +65,13 @@ struct ASTNode {
         FuncCallNode func_call;
         UnaryOpNode unary_op;
         BinaryOpNode binary_op;
+        TernaryNode ternary;
         CastNode cast;
         MemberAccessNode member_access;
         IdentifierNode identifier;
         PrintNode print;
         ArrayAcess array_access;
+        TypeNode type_arg;
 
         IntLiteralNode int_literal;
         FloatLiteralNode float_literal;
@@ -73,18 +81,47 @@ struct ASTNode {
     } as;
 };
 
+// a function body the skeleton scan stepped over, body_start is its '{' and body_end the token after its '}'
+typedef struct DeferredBody {
+    ASTNode* function;
+    int body_start;
+    int body_end;
+} DeferredBody;
+
 typedef struct Parser {
     Tokens* tokens;
     int current_token;
+    // constructs dropped after a parse error, a program with errors is not compiled
+    int error_count;
+    // loops enclosing the statement being parsed, break and continue need at least one
+    int loop_depth;
+
+    // child lists are collected here and copied into the arena once their length is known
+    ASTNode** scratch;
+    int scratch_count;
+    int scratch_capacity;
+
+    // set by parse_program_skeleton, balanced function bodies are recorded instead of parsed
+    int defer_bodies;
+    DeferredBody* deferred;
+    int deferred_count;
+    int deferred_capacity;
 } Parser;
 
+typedef struct {
+    int base;
+    int count;
+} NodeListBuilder;
+
 void init_parser(Parser* parser, Tokens* tokens);
+void cleanup_parser(Parser* parser);
 
 void advance(Parser* parser);
 int match(Parser* parser, TokenType type);
 int check(Parser* parser, TokenType type);
 
 Token* current_token(Parser* parser);
+StringView current_lexeme(Parser* parser);
 Token* peek_token(Parser* parser, int offset);
 
 
@@ -97,9 +134,8 @@ ASTNode* parse_post_decrement(Parser* parser, ASTNode* operand);
 
 ASTNode* parse_compound_operators(Parser* parser);
 ASTNode* parse_expression(Parser* parser);
-ASTNode* parse_equality(Parser* parser);
-ASTNode* parse_additive(Parser* parser);
-ASTNode* parse_multiplicative(Parser* parser);
+ASTNode* parse_loop_jump(Parser* parser);
+ASTNode* parse_precedence(Parser* parser, int min_precedence);
 ASTNode* parse_unary(Parser* parser);
 ASTNode* parse_postfix(Parser* parser);
 ASTNode* parse_primary(Parser* parser);
@@ -112,8 +148,14 @@ ASTNode* parse_identifier_expression(Parser* parsern);
 ASTNode* parse_dereference(Parser* parser);
 ASTNode* parse_address_of(Parser* parser);
 ASTNode* parse_function_call(Parser* parser);
+ASTNode* parse_type_argument(Parser* parser);
+int parse_loop_hints(Parser* parser, LoopHints* hints);
+int parse_function_qualifiers(Parser* parser);
+ASTNode* parse_global_declaration(Parser* parser);
 ASTNode* parse_casting(Parser* parser);
 TypeInfo parse_type(Parser* parser);
+int parse_vector_lanes(StringView lexeme);
+int parse_int_bit_width(StringView lexeme);
 ASTNode* parse_while_loop(Parser* parser);
 ASTNode* parse_for_loop(Parser* parser);
 ASTNode* parse_loop_init(Parser* parser);
@@ -122,6 +164,7 @@ ASTNode* parse_loop_update(Parser* parser);
 ASTNode* parse_if(Parser* parser);
 ASTNode* parse_else(Parser* parser);
 ASTNode* parse_assignment(Parser* parser);
+int parse_array_dimensions(Parser* parser, TypeInfo* type, int allow_unsized_first);
 ASTNode* parse_variable_declaration(Parser* parser);
 char* parse_struct_name(Parser* parser);
 ASTNode* parse_struct_declaration(Parser* parser);
@@ -134,6 +177,8 @@ ASTNode* parse_parameters(Parser* parser, ASTNode* func);
 ASTNode* parse_function(Parser* parser);
 char* parse_namespace_name(Parser* parser);
 ASTNode* parse_program(Parser* parser);
+ASTNode* parse_program_skeleton(Parser* parser);
+int parse_deferred_body(Parser* parser, const DeferredBody* deferred);
 
 int is_func_call(Parser* parser);
 int is_casting(Parser* parser);
@@ -144,6 +189,12 @@ int is_compound_token(TokenType type);
 
 
 void free_ast(ASTNode* node);
+// bytes a node of this type takes in the arena, only its own union member is allocated
+size_t ast_node_size(ASTNodeType type);
+
+typedef void (*AstChildFn)(ASTNode* child, void* data);
+void visit_ast_children(ASTNode* node, AstChildFn fn, void* data);
 void print_ast(ASTNode* node, int indent);
+const char* ast_type_name(ASTNodeType type);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "parser_lazy.h"
+#include "ast_arena.h"
+#include "diagnostics.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Reachability {
+    const DeferredBody* bodies;
+    // the bodies ordered by function name, a name may be defined more than once
+    const DeferredBody** by_name;
+    int body_count;
+
+    char* reached;
+    int* worklist;
+    int worklist_count;
+} Reachability;
+
+static int compare_body_names(const void* a, const void* b)
+{
+    const DeferredBody* left = *(const DeferredBody* const*)a;
+    const DeferredBody* right = *(const DeferredBody* const*)b;
+    return strcmp(left->function->as.function.name, right->function->as.function.name);
+}
+
+static void reach_name(Reachability* reachability, const char* name)
+{
+    int low = 0;
+    int high = reachability->body_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(reachability->by_name[mid]->function->as.function.name, name) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for (; low < reachability->body_count; low++) {
+        const DeferredBody* body = reachability->by_name[low];
+        if (strcmp(body->function->as.function.name, name) != 0)
+            break;
+
+        int index = (int)(body - reachability->bodies);
+        if (!reachability->reached[index]) {
+            reachability->reached[index] = 1;
+            reachability->worklist[reachability->worklist_count++] = index;
+        }
+    }
+}
+
+// a bare identifier may name a function too, keeping it is cheaper than being wrong
+static void collect_references(ASTNode* node, void* data)
+{
+    if (node == NULL)
+        return;
+
+    if (node->type == AST_FUNC_CALL)
+        reach_name(data, node->as.func_call.name);
+    else if (node->type == AST_IDENTIFIER)
+        reach_name(data, node->as.identifier.name);
+
+    visit_ast_children(node, collect_references, data);
+}
+
+// the roots are what is_externally_visible keeps, global initializers count as reachable code
+static int parse_reachable_bodies(Parser* parser, ASTNode* program)
+{
+    Reachability reachability = {
+        .bodies = parser->deferred,
+        .body_count = parser->deferred_count,
+        .by_name = malloc(sizeof(DeferredBody*) * (parser->deferred_count + 1)),
+        .reached = calloc(parser->deferred_count + 1, 1),
+        .worklist = malloc(sizeof(int) * (parser->deferred_count + 1)),
+    };
+
+    int ok = reachability.by_name != NULL && reachability.reached != NULL && reachability.worklist != NULL;
+    if (ok) {
+        for (int i = 0; i < parser->deferred_count; i++)
+            reachability.by_name[i] = &parser->deferred[i];
+        qsort(reachability.by_name, parser->deferred_count, sizeof(DeferredBody*), compare_body_names);
+
+        for (int i = 0; i < parser->deferred_count; i++) {
+            FunctionNode* function = &parser->deferred[i].function->as.function;
+            if ((function->qualifiers & FUNC_QUAL_EXPORT) || strcmp(function->name, "main") == 0)
+                reach_name(&reachability, function->name);
+        }
+        for (int i = 0; i < program->as.program.global_count; i++)
+            collect_references(program->as.program.globals[i], &reachability);
+    }
+
+    AstArena* previous = set_current_ast_arena(program->as.program.arena);
+    while (ok && reachability.worklist_count > 0) {
+        const DeferredBody* body = &parser->deferred[reachability.worklist[--reachability.worklist_count]];
+        ok = parse_deferred_body(parser, body);
+        if (ok)
+            collect_references(body->function->as.function.body, &reachability);
+    }
+    set_current_ast_arena(previous);
+
+    free(reachability.by_name);
+    free(reachability.reached);
+    free(reachability.worklist);
+    return ok;
+}
+
+// functions keep their source order, only the ones whose body was never parsed are dropped
+static int drop_unreached_functions(ProgramNode* program)
+{
+    int kept = 0;
+    for (int i = 0; i < program->function_count; i++) {
+        if (program->functions[i]->as.function.body != NULL)
+            program->functions[kept++] = program->functions[i];
+    }
+
+    int skipped = program->function_count - kept;
+    program->function_count = kept;
+    return skipped;
+}
+
+ASTNode* parse_program_reachable(Parser* parser)
+{
+    long long ast_bytes[AST_NODE_TYPE_COUNT];
+    memcpy(ast_bytes, compile_stats.ast_bytes, sizeof(ast_bytes));
+
+    // messages are held back until it is clear the full parse does not have to run
+    Diagnostics diagnostics = { 0 };
+    Diagnostics* previous_sink = set_diagnostic_sink(&diagnostics);
+    ASTNode* program = parse_program_skeleton(parser);
+    int ok = program != NULL && parser->error_count == 0 && diagnostics.count == 0;
+    if (ok)
+        ok = parse_reachable_bodies(parser, program) && parser->error_count == 0 && diagnostics.count == 0;
+    set_diagnostic_sink(previous_sink);
+    free_diagnostics(&diagnostics);
+    cleanup_parser(parser);
+
+    if (ok) {
+        compile_stats.skipped_functions += drop_unreached_functions(&program->as.program);
+        count_ast_nodes(program);
+        return program;
+    }
+
+    free_ast(program);
+    memcpy(compile_stats.ast_bytes, ast_bytes, sizeof(ast_bytes));
+    parser->current_token = 0;
+    parser->error_count = 0;
+    return parse_program(parser);
+}
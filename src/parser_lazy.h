@@ -0,0 +1,11 @@
+#ifndef PARSER_LAZY_H
+#define PARSER_LAZY_H
+
+#include "parser.h"
+
+// parses signatures only, then just the bodies main and the exported functions can reach
+// through calls, the rest are left out of the program and counted in compile_stats.skipped_functions
+// a program with parse errors in what it reaches is parsed again in full so diagnostics come out as before
+ASTNode* parse_program_reachable(Parser* parser);
+
+#endif
@@ -0,0 +1,177 @@
+#include "parser_parallel.h"
+#include "ast_arena.h"
+#include "diagnostics.h"
+#include "stats.h"
+#include "type_table.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct BodyQueue {
+    Tokens* tokens;
+    const DeferredBody* bodies;
+    int body_count;
+    atomic_int next;
+    atomic_int failed;
+} BodyQueue;
+
+typedef struct BodyWorker {
+    BodyQueue* queue;
+    AstArena* arena;
+    // the caller's type table, bodies intern into the same one as the skeleton
+    TypeTable* types;
+    // what this worker added to compile_stats, the caller folds it into its own
+    long long ast_bytes[AST_NODE_TYPE_COUNT];
+} BodyWorker;
+
+static void* parse_bodies(void* data)
+{
+    BodyWorker* worker = data;
+    BodyQueue* queue = worker->queue;
+
+    long long ast_bytes[AST_NODE_TYPE_COUNT];
+    memcpy(ast_bytes, compile_stats.ast_bytes, sizeof(ast_bytes));
+
+    // a failed body only means the serial parse runs, its messages are not wanted here
+    Diagnostics diagnostics = { 0 };
+    Diagnostics* previous_sink = set_diagnostic_sink(&diagnostics);
+    AstArena* previous_arena = set_current_ast_arena(worker->arena);
+    TypeTable* previous_types = set_current_type_table(worker->types);
+
+    Parser parser;
+    init_parser(&parser, queue->tokens);
+
+    while (!atomic_load(&queue->failed)) {
+        int index = atomic_fetch_add(&queue->next, 1);
+        if (index >= queue->body_count)
+            break;
+
+        if (!parse_deferred_body(&parser, &queue->bodies[index]) || diagnostics.count > 0)
+            atomic_store(&queue->failed, 1);
+    }
+
+    cleanup_parser(&parser);
+    set_current_type_table(previous_types);
+    set_current_ast_arena(previous_arena);
+    set_diagnostic_sink(previous_sink);
+    free_diagnostics(&diagnostics);
+
+    for (int i = 0; i < AST_NODE_TYPE_COUNT; i++) {
+        worker->ast_bytes[i] = compile_stats.ast_bytes[i] - ast_bytes[i];
+        compile_stats.ast_bytes[i] = ast_bytes[i];
+    }
+    return NULL;
+}
+
+static int online_cores(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+static int pick_thread_count(int body_count)
+{
+    int by_size = body_count / PARALLEL_PARSE_MIN_BODIES;
+
+    int count = online_cores();
+    if (count > by_size)
+        count = by_size;
+    if (count > PARALLEL_PARSE_MAX_THREADS)
+        count = PARALLEL_PARSE_MAX_THREADS;
+    return count > 0 ? count : 1;
+}
+
+// the function nodes come from the skeleton in source order, so ProgramNode.functions needs no
+// reordering, the bodies are hung off them and the worker arenas handed to the program
+static int parse_deferred_bodies(Parser* parser, ASTNode* program, int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = pick_thread_count(parser->deferred_count);
+    if (thread_count > parser->deferred_count)
+        thread_count = parser->deferred_count > 0 ? parser->deferred_count : 1;
+
+    BodyQueue queue = { .tokens = parser->tokens, .bodies = parser->deferred, .body_count = parser->deferred_count };
+    atomic_init(&queue.next, 0);
+    atomic_init(&queue.failed, 0);
+
+    BodyWorker* workers = calloc(thread_count, sizeof(BodyWorker));
+    pthread_t* threads = malloc(sizeof(pthread_t) * thread_count);
+    if (workers == NULL || threads == NULL) {
+        free(workers);
+        free(threads);
+        return 0;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].queue = &queue;
+        workers[i].arena = create_ast_arena();
+        workers[i].types = get_current_type_table();
+        ok &= workers[i].arena != NULL;
+    }
+
+    // worker 0 runs on the calling thread, as do any the system would not start
+    int started = 1;
+    if (ok) {
+        for (int i = 1; i < thread_count; i++) {
+            if (pthread_create(&threads[i], NULL, parse_bodies, &workers[i]) != 0)
+                break;
+            started++;
+        }
+        parse_bodies(&workers[0]);
+        for (int i = started; i < thread_count; i++)
+            parse_bodies(&workers[i]);
+        for (int i = 1; i < started; i++)
+            pthread_join(threads[i], NULL);
+    }
+
+    ok &= !atomic_load(&queue.failed);
+    for (int i = 0; i < thread_count; i++) {
+        if (workers[i].arena == NULL)
+            continue;
+
+        merge_ast_arena(program->as.program.arena, workers[i].arena);
+        free_ast_arena(workers[i].arena);
+        for (int type = 0; type < AST_NODE_TYPE_COUNT; type++)
+            compile_stats.ast_bytes[type] += workers[i].ast_bytes[type];
+    }
+
+    free(workers);
+    free(threads);
+    return ok;
+}
+
+ASTNode* parse_program_parallel(Parser* parser, int thread_count)
+{
+    if (thread_count == 1 || (thread_count <= 0 && online_cores() == 1))
+        return parse_program(parser);
+
+    long long ast_bytes[AST_NODE_TYPE_COUNT];
+    memcpy(ast_bytes, compile_stats.ast_bytes, sizeof(ast_bytes));
+
+    Diagnostics diagnostics = { 0 };
+    Diagnostics* previous_sink = set_diagnostic_sink(&diagnostics);
+    ASTNode* program = parse_program_skeleton(parser);
+    int ok = program != NULL && parser->error_count == 0 && diagnostics.count == 0;
+    set_diagnostic_sink(previous_sink);
+    free_diagnostics(&diagnostics);
+
+    if (ok)
+        ok = parse_deferred_bodies(parser, program, thread_count);
+
+    cleanup_parser(parser);
+
+    if (ok) {
+        count_ast_nodes(program);
+        return program;
+    }
+
+    // start over on the same tokens, nothing from the attempt is kept
+    free_ast(program);
+    memcpy(compile_stats.ast_bytes, ast_bytes, sizeof(ast_bytes));
+    parser->current_token = 0;
+    parser->error_count = 0;
+    return parse_program(parser);
+}
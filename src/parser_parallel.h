@@ -0,0 +1,16 @@
+#ifndef PARSER_PARALLEL_H
+#define PARSER_PARALLEL_H
+
+#include "parser.h"
+
+// each worker gets at least this many bodies when the thread count is picked automatically
+#define PARALLEL_PARSE_MIN_BODIES 256
+#define PARALLEL_PARSE_MAX_THREADS 16
+
+// scans the namespace for signatures and body token ranges first, then parses the bodies on
+// worker threads into their own arenas, the tree is the one parse_program would build
+// a program with parse errors is parsed again serially so diagnostics come out as before
+// thread_count 0 picks one from the number of bodies and the cores, 1 parses serially
+ASTNode* parse_program_parallel(Parser* parser, int thread_count);
+
+#endif
@@ -0,0 +1,260 @@
+#include "server.h"
+#include "server_protocol.h"
+#include "codegen_visitor.h"
+#include "euclase.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef struct CompileServer CompileServer;
+
+// each worker owns a session, so the target machine stays warm between requests
+typedef struct Worker {
+    pthread_t thread;
+    CompileServer* server;
+    EuclaseSession* session;
+
+    // the connection being served, -1 when idle, guarded so shutdown never hits a reused descriptor
+    pthread_mutex_t connection_lock;
+    int connection_fd;
+} Worker;
+
+struct CompileServer {
+    int listen_fd;
+    atomic_int stopping;
+    Worker* workers;
+    int worker_count;
+};
+
+static int send_response(int fd, ResponseStatus status, const void* payload, size_t length)
+{
+    CompileResponseHeader header = {
+        .magic = SERVER_PROTOCOL_MAGIC,
+        .status = status,
+        .payload_length = length
+    };
+
+    if (!write_exact(fd, &header, sizeof(header)))
+        return 0;
+    return length == 0 || write_exact(fd, payload, length);
+}
+
+static int send_error(int fd, ResponseStatus status, const char* message)
+{
+    return send_response(fd, status, message, strlen(message));
+}
+
+static EuclaseOutputKind get_output_kind(uint32_t wire_kind)
+{
+    switch (wire_kind) {
+        case REQUEST_EMIT_BITCODE: return EUCLASE_OUTPUT_BITCODE;
+        case REQUEST_EMIT_OBJECT: return EUCLASE_OUTPUT_OBJECT;
+        default: return EUCLASE_OUTPUT_IR;
+    }
+}
+
+// returns 0 once the connection should be closed
+static int serve_request(Worker* worker, int fd)
+{
+    CompileRequestHeader header;
+    if (!read_exact(fd, &header, sizeof(header)))
+        return 0;
+
+    if (header.magic != SERVER_PROTOCOL_MAGIC || header.name_length == 0 || header.name_length > SERVER_MAX_NAME_LENGTH
+        || header.source_length > SERVER_MAX_SOURCE_LENGTH || header.emit_kind > REQUEST_EMIT_OBJECT) {
+        send_error(fd, RESPONSE_BAD_REQUEST, "malformed request");
+        return 0;
+    }
+
+    char* module_name = malloc(header.name_length + 1);
+    char* source = malloc(header.source_length + 1);
+    if (module_name == NULL || source == NULL) {
+        free(module_name);
+        free(source);
+        send_error(fd, RESPONSE_BAD_REQUEST, "request too large");
+        return 0;
+    }
+
+    if (!read_exact(fd, module_name, header.name_length) || !read_exact(fd, source, header.source_length)) {
+        free(module_name);
+        free(source);
+        return 0;
+    }
+    module_name[header.name_length] = '\0';
+
+    // bounds checking is per request, the session only holds the defaults
+    CodegenOptions* options = euclase_session_options(worker->session);
+    options->bounds_check = (header.flags & REQUEST_FLAG_BOUNDS_CHECK) != 0;
+
+    EuclaseResult* result = euclase_compile(worker->session, module_name, source, header.source_length, get_output_kind(header.emit_kind));
+
+    int sent;
+    if (result == NULL)
+        sent = send_error(fd, RESPONSE_COMPILE_ERROR, "out of memory");
+    else if (result->ok)
+        sent = send_response(fd, RESPONSE_OK, LLVMGetBufferStart(result->output), LLVMGetBufferSize(result->output));
+    else
+        sent = send_error(fd, RESPONSE_COMPILE_ERROR, result->diagnostics[0] != '\0' ? result->diagnostics : "compilation failed");
+
+    euclase_result_free(result);
+    free(module_name);
+    free(source);
+    return sent;
+}
+
+static void set_connection_timeouts(int fd)
+{
+    struct timeval timeout = { .tv_sec = SERVER_IDLE_TIMEOUT_SECONDS };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static void set_worker_connection(Worker* worker, int fd)
+{
+    pthread_mutex_lock(&worker->connection_lock);
+    if (fd < 0 && worker->connection_fd >= 0)
+        close(worker->connection_fd);
+    worker->connection_fd = fd;
+    pthread_mutex_unlock(&worker->connection_lock);
+}
+
+// ends the read side so a worker waiting for the next request wakes up, a response being written still goes out
+static void stop_worker_connection(Worker* worker)
+{
+    pthread_mutex_lock(&worker->connection_lock);
+    if (worker->connection_fd >= 0)
+        shutdown(worker->connection_fd, SHUT_RD);
+    pthread_mutex_unlock(&worker->connection_lock);
+}
+
+static void* run_worker(void* data)
+{
+    Worker* worker = data;
+    CompileServer* server = worker->server;
+
+    while (!atomic_load(&server->stopping)) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        set_connection_timeouts(fd);
+        set_worker_connection(worker, fd);
+
+        // stopping is checked after publishing fd, shutdown either sees the connection or the worker sees stopping
+        while (!atomic_load(&server->stopping) && serve_request(worker, fd))
+            ;
+        set_worker_connection(worker, -1);
+    }
+
+    return NULL;
+}
+
+static int open_listen_socket(const char* socket_path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_compile_server(const char* socket_path, int worker_count)
+{
+    if (worker_count <= 0)
+        worker_count = SERVER_DEFAULT_WORKERS;
+
+    // workers inherit the mask, only the main thread waits for shutdown signals
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    CompileServer server = { .worker_count = worker_count };
+    atomic_init(&server.stopping, 0);
+
+    server.listen_fd = open_listen_socket(socket_path);
+    if (server.listen_fd < 0)
+        return 1;
+
+    server.workers = calloc(worker_count, sizeof(Worker));
+    if (server.workers == NULL) {
+        close(server.listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    int started = 0;
+    for (; started < worker_count; started++) {
+        Worker* worker = &server.workers[started];
+        worker->server = &server;
+        worker->connection_fd = -1;
+        worker->session = euclase_session_create(NULL);
+        if (worker->session == NULL)
+            break;
+
+        pthread_mutex_init(&worker->connection_lock, NULL);
+        if (pthread_create(&worker->thread, NULL, run_worker, worker) != 0) {
+            pthread_mutex_destroy(&worker->connection_lock);
+            euclase_session_destroy(worker->session);
+            break;
+        }
+    }
+
+    if (started == 0) {
+        fprintf(stderr, "Error: Could not start server workers.\n");
+        free(server.workers);
+        close(server.listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    printf("Euclase server listening on %s with %d workers\n", socket_path, started);
+    fflush(stdout);
+
+    int signal_number;
+    sigwait(&stop_signals, &signal_number);
+
+    // shutdown wakes every worker blocked in accept or waiting on a client, requests already in flight finish first
+    atomic_store(&server.stopping, 1);
+    shutdown(server.listen_fd, SHUT_RDWR);
+    for (int i = 0; i < started; i++)
+        stop_worker_connection(&server.workers[i]);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(server.workers[i].thread, NULL);
+        pthread_mutex_destroy(&server.workers[i].connection_lock);
+        euclase_session_destroy(server.workers[i].session);
+    }
+
+    free(server.workers);
+    close(server.listen_fd);
+    unlink(socket_path);
+    return 0;
+}
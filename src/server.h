@@ -0,0 +1,11 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#define SERVER_DEFAULT_WORKERS 4
+// a connection that sends nothing for this long is closed so it cannot hold a worker
+#define SERVER_IDLE_TIMEOUT_SECONDS 5
+
+// serves compile requests on a Unix domain socket until SIGINT/SIGTERM, returns 0 on a clean shutdown
+int run_compile_server(const char* socket_path, int worker_count);
+
+#endif
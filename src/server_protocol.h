@@ -0,0 +1,75 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// wire format between `Euclase --server` and the client, both ends run on one host so fields use native byte order
+
+#define SERVER_PROTOCOL_MAGIC 0x45434c53u
+#define SERVER_MAX_NAME_LENGTH 255
+#define SERVER_MAX_SOURCE_LENGTH (64u << 20)
+
+#define REQUEST_EMIT_IR 0
+#define REQUEST_EMIT_BITCODE 1
+#define REQUEST_EMIT_OBJECT 2
+
+#define REQUEST_FLAG_BOUNDS_CHECK (1u << 0)
+
+// followed by name_length bytes of module name and source_length bytes of source
+typedef struct CompileRequestHeader {
+    uint32_t magic;
+    uint32_t emit_kind;
+    uint32_t flags;
+    uint32_t name_length;
+    uint64_t source_length;
+} CompileRequestHeader;
+
+typedef enum {
+    RESPONSE_OK,
+    RESPONSE_COMPILE_ERROR,
+    RESPONSE_BAD_REQUEST
+} ResponseStatus;
+
+// followed by the output, or by an error message when status is not RESPONSE_OK
+typedef struct CompileResponseHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t payload_length;
+} CompileResponseHeader;
+
+// 0 on EOF or error
+static inline int read_exact(int fd, void* data, size_t length)
+{
+    char* cursor = data;
+    while (length > 0) {
+        ssize_t count = read(fd, cursor, length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return 0;
+
+        cursor += count;
+        length -= (size_t)count;
+    }
+    return 1;
+}
+
+static inline int write_exact(int fd, const void* data, size_t length)
+{
+    const char* cursor = data;
+    while (length > 0) {
+        ssize_t count = write(fd, cursor, length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return 0;
+
+        cursor += count;
+        length -= (size_t)count;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "stats.h"
+#include "lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+_Thread_local CompileStats compile_stats;
+
+static const char* phase_names[PHASE_COUNT] = { "lex", "parse", "codegen" };
+
+void reset_compile_stats(void)
+{
+    for (int i = 0; i < compile_stats.function_count; i++)
+        free(compile_stats.functions[i].name);
+    free(compile_stats.functions);
+
+    memset(&compile_stats, 0, sizeof(compile_stats));
+}
+
+double stats_now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+static void count_ast_node(ASTNode* node, void* data)
+{
+    if (node == NULL)
+        return;
+
+    compile_stats.ast_nodes[node->type]++;
+    visit_ast_children(node, count_ast_node, data);
+}
+
+void count_ast_nodes(ASTNode* node)
+{
+    count_ast_node(node, NULL);
+    if (node != NULL && node->type == AST_PROGRAM && node->as.program.arena != NULL)
+        compile_stats.ast_arena_bytes += node->as.program.arena->bytes;
+}
+
+void record_function_stats(const char* name, int instructions, int basic_blocks, int allocas)
+{
+    if (compile_stats.function_count == compile_stats.function_capacity) {
+        int capacity = compile_stats.function_capacity == 0 ? 16 : compile_stats.function_capacity * 2;
+        FunctionStats* functions = realloc(compile_stats.functions, sizeof(FunctionStats) * capacity);
+        if (functions == NULL)
+            return;
+
+        compile_stats.functions = functions;
+        compile_stats.function_capacity = capacity;
+    }
+
+    compile_stats.functions[compile_stats.function_count++] = (FunctionStats) {
+        .name = strdup(name),
+        .instructions = instructions,
+        .basic_blocks = basic_blocks,
+        .allocas = allocas
+    };
+}
+
+static void write_json_string(FILE* file, const char* value)
+{
+    fputc('"', file);
+    for (; *value != '\0'; value++) {
+        if (*value == '"' || *value == '\\')
+            fputc('\\', file);
+        fputc(*value, file);
+    }
+    fputc('"', file);
+}
+
+// only kinds that occurred are listed
+static void write_counts_by_name(FILE* file, const char* key, const long long* counts, int count, const char* (*name_of)(int))
+{
+    long long total = 0;
+    for (int i = 0; i < count; i++)
+        total += counts[i];
+
+    fprintf(file, "  \"%s\": {\n    \"total\": %lld,\n    \"by_type\": {", key, total);
+
+    const char* separator = "\n";
+    for (int i = 0; i < count; i++) {
+        if (counts[i] == 0)
+            continue;
+
+        fprintf(file, "%s      ", separator);
+        write_json_string(file, name_of(i));
+        fprintf(file, ": %lld", counts[i]);
+        separator = ",\n";
+    }
+    fprintf(file, "\n    }\n  },\n");
+}
+
+static const char* token_name_at(int index)
+{
+    return token_type_name((TokenType)index);
+}
+
+static const char* ast_name_at(int index)
+{
+    return ast_type_name((ASTNodeType)index);
+}
+
+int write_compile_stats_json(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        printf("Error: cannot write stats to '%s'\n", filename);
+        return 0;
+    }
+
+    fprintf(file, "{\n");
+    write_counts_by_name(file, "tokens", compile_stats.tokens, TOK_COUNT, token_name_at);
+    write_counts_by_name(file, "ast_nodes", compile_stats.ast_nodes, AST_NODE_TYPE_COUNT, ast_name_at);
+    write_counts_by_name(file, "ast_bytes", compile_stats.ast_bytes, AST_NODE_TYPE_COUNT, ast_name_at);
+    fprintf(file, "  \"ast_arena_bytes\": %lld,\n", compile_stats.ast_arena_bytes);
+    fprintf(file, "  \"skipped_functions\": %d,\n", compile_stats.skipped_functions);
+
+    fprintf(file, "  \"symbols\": {\n");
+    fprintf(file, "    \"max_scope_depth\": %d,\n", compile_stats.max_scope_depth);
+    fprintf(file, "    \"inserts\": %lld,\n", compile_stats.symbol_inserts);
+    fprintf(file, "    \"lookups\": %lld,\n", compile_stats.symbol_lookups);
+    fprintf(file, "    \"probes\": %lld,\n", compile_stats.symbol_probes);
+    fprintf(file, "    \"max_chain_length\": %d\n", compile_stats.max_chain_length);
+    fprintf(file, "  },\n");
+
+    fprintf(file, "  \"functions\": [");
+    for (int i = 0; i < compile_stats.function_count; i++) {
+        FunctionStats* function = &compile_stats.functions[i];
+        fprintf(file, "%s\n    { \"name\": ", i == 0 ? "" : ",");
+        write_json_string(file, function->name);
+        fprintf(file, ", \"instructions\": %d, \"basic_blocks\": %d, \"allocas\": %d }",
+            function->instructions, function->basic_blocks, function->allocas);
+    }
+    fprintf(file, "%s],\n", compile_stats.function_count > 0 ? "\n  " : "");
+
+    fprintf(file, "  \"module\": { \"globals\": %d, \"constants\": %d },\n", compile_stats.global_count, compile_stats.constant_count);
+
+    fprintf(file, "  \"phase_ms\": {");
+    for (int i = 0; i < PHASE_COUNT; i++)
+        fprintf(file, "%s \"%s\": %.3f", i == 0 ? "" : ",", phase_names[i], compile_stats.phase_ms[i]);
+    fprintf(file, " }\n}\n");
+
+    fclose(file);
+    return 1;
+}
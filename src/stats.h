@@ -0,0 +1,56 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "token.h"
+#include "parser.h"
+
+// counters are plain increments on a per-thread registry, --stats=<file> dumps them as JSON
+
+typedef enum {
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_CODEGEN,
+    PHASE_COUNT
+} CompilePhase;
+
+typedef struct FunctionStats {
+    char* name;
+    int instructions;
+    int basic_blocks;
+    int allocas;
+} FunctionStats;
+
+typedef struct CompileStats {
+    long long tokens[TOK_COUNT];
+    long long ast_nodes[AST_NODE_TYPE_COUNT];
+    // node bytes plus the child arrays a node owns, names are counted in ast_arena_bytes only
+    long long ast_bytes[AST_NODE_TYPE_COUNT];
+    long long ast_arena_bytes;
+    // functions parse_program_reachable dropped without parsing their bodies
+    int skipped_functions;
+
+    int max_scope_depth;
+    long long symbol_inserts;
+    long long symbol_lookups;
+    long long symbol_probes;
+    int max_chain_length;
+
+    FunctionStats* functions;
+    int function_count;
+    int function_capacity;
+
+    int global_count;
+    int constant_count;
+
+    double phase_ms[PHASE_COUNT];
+} CompileStats;
+
+extern _Thread_local CompileStats compile_stats;
+
+void reset_compile_stats(void);
+double stats_now_ms(void);
+void count_ast_nodes(ASTNode* node);
+void record_function_stats(const char* name, int instructions, int basic_blocks, int allocas);
+int write_compile_stats_json(const char* filename);
+
+#endif
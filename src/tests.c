@@ -1,9 +1,14 @@
 #include "tests.h"
-#include "lexer.h"
-#include "parser.h"
+#include "lexer_parallel.h"
+#include "parser_lazy.h"
+#include "parser_parallel.h"
+#include "stats.h"
+#include "type_table.h"
 #include "codegen_visitor.h"
+#include "euclase.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define KRED  "\x1B[31m"
 #define KGRN  "\x1B[32m"
@@ -304,6 +309,742 @@ const char* test_print =
     "   }"
     "}";
 
+const char* test_print_multiple =
+    "namespace main {"
+    "   int main() {"
+    "       int a = -42;"
+    "       double d = 2.5d;"
+    "       float f = 0.125f;"
+    "       print(\"record:\", a, d, f, 'x');"
+    "       return 7;"
+    "   }"
+    "}";
+
+const char* test_unsigned =
+    "namespace main {"
+    "   int main() {"
+    "       uint a = 4294967295u;"
+    "       uint b = a / 16u;"
+    "       uint c = a % 16u;"
+    "       int r = 0;"
+    "       if (a > 1u) {"
+    "           r = r + 1;"
+    "       }"
+    "       if (b / 16777216u == 15u) {"
+    "           r = r + 10;"
+    "       }"
+    "       double d = (double) a;"
+    "       if (d > 4294967294.0d) {"
+    "           r = r + 20;"
+    "       }"
+    "       return r + c;"
+    "   }"
+    "}";
+
+const char* test_sized_integers =
+    "namespace main {"
+    "   int48 big = 140737488355327;"
+    "   int main() {"
+    "       long counter = 5000000000;"
+    "       int64 step = 3;"
+    "       counter = counter + step;"
+    "       uint4 nibble = 15u;"
+    "       nibble = nibble + 1u;"
+    "       int16 packed[4];"
+    "       packed[1] = 70000;"
+    "       int8 small = -3;"
+    "       int widened = small + 10;"
+    "       int r = 0;"
+    "       if (counter == 5000000003) {"
+    "           r = r + 1;"
+    "       }"
+    "       if (nibble == 0u) {"
+    "           r = r + 2;"
+    "       }"
+    "       if (packed[1] == 4464) {"
+    "           r = r + 4;"
+    "       }"
+    "       if (big > 140737488355326) {"
+    "           r = r + 8;"
+    "       }"
+    "       return r + widened;"
+    "   }"
+    "}";
+
+const char* test_vectors =
+    "namespace main {"
+    "   int main() {"
+    "       float data[8];"
+    "       for (int i = 0; i < 8; i++) {"
+    "           data[i] = (float) i;"
+    "       }"
+    "       float4 a = vload(float4, data, 0);"
+    "       float4 b = vload(float4, data, 4);"
+    "       float4 c = a * b + 1.0f;"
+    "       c[2] = 100.0f;"
+    "       vstore(data, 0, c);"
+    "       float4 r = shuffle(c, 3, 2, 1, 0);"
+    "       int8x16 bytes = 3;"
+    "       int8x16 more = bytes * bytes - 1;"
+    "       int32x4 m = a < b;"
+    "       return (int) (data[1] + r[0]) + more[15] + m[3];"
+    "   }"
+    "}";
+
+const char* test_loop_hints =
+    "namespace main {"
+    "   int main() {"
+    "       int values[64];"
+    "       for unroll(4) vectorize(8) interleave(2) (int i = 0; i < 64; i++) {"
+    "           values[i] = i;"
+    "       }"
+    "       int sum = 0;"
+    "       int k = 0;"
+    "       while unroll(2) (k < 8) {"
+    "           sum = sum + values[k];"
+    "           k++;"
+    "       }"
+    "       return sum;"
+    "   }"
+    "}";
+
+const char* const loop_hints_ir[] = {
+    "br label %for_cond, !llvm.loop",
+    "br label %while_cond, !llvm.loop",
+    "{!\"llvm.loop.unroll.count\", i32 4}",
+    "{!\"llvm.loop.vectorize.enable\", i1 true}",
+    "{!\"llvm.loop.vectorize.width\", i32 8}",
+    "{!\"llvm.loop.interleave.count\", i32 2}",
+    "{!\"llvm.loop.unroll.count\", i32 2}",
+    NULL
+};
+
+const char* test_function_qualifiers =
+    "namespace main {"
+    "   int scale = 3;"
+    "   int hot = 1;"
+    "   inline int twice(int x) {"
+    "       return x * 2;"
+    "   }"
+    "   const int square(int x) {"
+    "       return x * x;"
+    "   }"
+    "   pure hot int scaled(int x) {"
+    "       return x * scale;"
+    "   }"
+    "   cold noinline void report(int code) {"
+    "       print(code);"
+    "   }"
+    "   int main() {"
+    "       int r = twice(4) + square(3) + scaled(2);"
+    "       if (r > 100) {"
+    "           report(r);"
+    "       }"
+    "       int cold = 2;"
+    "       int pure = cold + hot;"
+    "       int inline = pure - 3;"
+    "       return r + inline;"
+    "   }"
+    "}";
+
+const char* const function_qualifiers_ir[] = {
+    "define internal fastcc i32 @twice(i32 %0) unnamed_addr #0",
+    "attributes #0 = { alwaysinline }",
+    "{ nounwind readnone willreturn }",
+    "{ hot nounwind readonly willreturn }",
+    "{ cold noinline }",
+    "section \".text.hot\"",
+    "section \".text.unlikely\"",
+    "@hot = internal unnamed_addr global i32 1",
+    NULL
+};
+
+const char* test_restrict =
+    "namespace main {"
+    "   void scale(float* restrict out, float* restrict in, int n) {"
+    "       for (int i = 0; i < n; i++) {"
+    "           out[i] = in[i] * 2.0f;"
+    "       }"
+    "   }"
+    "   void bump(int* counter) {"
+    "       *counter = *counter + 1;"
+    "   }"
+    "   int main() {"
+    "       float src[16];"
+    "       float dst[16];"
+    "       for (int i = 0; i < 16; i++) {"
+    "           src[i] = (float) i;"
+    "       }"
+    "       scale(&dst, &src, 16);"
+    "       float* restrict a = &src;"
+    "       float* restrict b = &dst;"
+    "       b[3] = a[5] + b[3];"
+    "       int count = 0;"
+    "       bump(&count);"
+    "       return (int) b[3] + count;"
+    "   }"
+    "}";
+
+const char* const restrict_ir[] = {
+    "@scale(float* noalias %0, float* noalias %1, i32 %2)",
+    "@bump(i32* %0)",
+    ", !alias.scope",
+    ", !noalias",
+    NULL
+};
+
+const char* test_visibility =
+    "namespace main {"
+    "   const int limit = 10;"
+    "   export int shared = 5;"
+    "   int counter = 0;"
+    "   char* name = \"euclase\";"
+    "   int helper(int x) {"
+    "       return x + limit;"
+    "   }"
+    "   export int api(int x) {"
+    "       return helper(x) * 2;"
+    "   }"
+    "   int main() {"
+    "       const int local = 3;"
+    "       counter = api(local);"
+    "       return counter + shared + (name[1] == 'u' ? 0 : 100);"
+    "   }"
+    "}";
+
+const char* const visibility_ir[] = {
+    "@limit = internal unnamed_addr constant i32 10",
+    "@shared = global i32 5",
+    "@counter = internal unnamed_addr global i32 0",
+    "define internal fastcc i32 @helper(",
+    "define i32 @api(",
+    "define i32 @main(",
+    NULL
+};
+
+const char* test_conditional_logic =
+    "namespace main {"
+    "   int calls = 0;"
+    "   int touch() {"
+    "       calls = calls + 1;"
+    "       return 1;"
+    "   }"
+    "   int clamp(int x, int lo, int hi) {"
+    "       return x < lo ? lo : x > hi ? hi : x;"
+    "   }"
+    "   int main() {"
+    "       int a = clamp(15, 0, 10);"
+    "       int b = clamp(-3, 0, 10);"
+    "       int c = 0;"
+    "       if (a > 5 && b == 0) {"
+    "           c = c + 1;"
+    "       }"
+    "       if (a < 5 || !(b != 0)) {"
+    "           c = c + 2;"
+    "       }"
+    "       int skipped = a > 100 && touch() == 1;"
+    "       int taken = a > 0 || touch() == 1;"
+    "       int branch = c > 0 ? touch() : 7;"
+    "       return a + b + c + skipped + taken + branch + calls;"
+    "   }"
+    "}";
+
+const char* test_break_continue =
+    "namespace main {"
+    "   int find(int target) {"
+    "       for (int i = 0; i < 100; i++) {"
+    "           if (i % 2 == 1) {"
+    "               continue;"
+    "           }"
+    "           if (i * i >= target) {"
+    "               return i;"
+    "           }"
+    "       }"
+    "       return -1;"
+    "   }"
+    "   int main() {"
+    "       int n = 0;"
+    "       int odd = 0;"
+    "       while (n < 50) {"
+    "           n++;"
+    "           if (n % 2 == 0) {"
+    "               continue;"
+    "           }"
+    "           odd = odd + 1;"
+    "           if (n > 20) {"
+    "               break;"
+    "               odd = 100;"
+    "           }"
+    "       }"
+    "       int sum = 0;"
+    "       for (int j = 0; j < 5; j++) {"
+    "           for (int k = 0; k < 5; k++) {"
+    "               if (k > j) {"
+    "                   break;"
+    "               }"
+    "               sum = sum + 1;"
+    "           }"
+    "       }"
+    "       return find(50) + odd + sum;"
+    "   }"
+    "}";
+
+const char* test_arena =
+    "namespace main {"
+    "   int fill(arena a, int n) {"
+    "       int* values = arena_alloc(a, int, n);"
+    "       for (int i = 0; i < n; i++) {"
+    "           values[i] = i;"
+    "       }"
+    "       int total = 0;"
+    "       for (int i = 0; i < n; i++) {"
+    "           total = total + values[i];"
+    "       }"
+    "       return total;"
+    "   }"
+    "   int main() {"
+    "       arena a = arena_new(16);"
+    "       int total = 0;"
+    "       for (int round = 0; round < 4; round++) {"
+    "           total = total + fill(a, 10);"
+    "           char* tag = arena_alloc(a, char, 1);"
+    "       }"
+    "       arena_reset(a);"
+    "       total = total + fill(a, 3);"
+    "       arena_free(a);"
+    "       return total;"
+    "   }"
+    "}";
+
+const char* test_arena_invalid_count =
+    "namespace main {"
+    "   int main() {"
+    "       arena a = arena_new(64);"
+    "       int* values = arena_alloc(a, int, 4);"
+    "       for (int i = 0; i < 4; i++) {"
+    "           values[i] = i + 1;"
+    "       }"
+    "       int* rejected = arena_alloc(a, int, -4);"
+    "       int* fresh = arena_alloc(a, int, 4);"
+    "       for (int i = 0; i < 4; i++) {"
+    "           fresh[i] = 100;"
+    "       }"
+    "       int total = 0;"
+    "       for (int i = 0; i < 4; i++) {"
+    "           total = total + values[i];"
+    "       }"
+    "       arena_free(a);"
+    "       return total;"
+    "   }"
+    "}";
+
+const char* test_struct_pointers =
+    "namespace main {"
+    "   struct vec {"
+    "       int x;"
+    "       int y;"
+    "   };"
+    "   struct body {"
+    "       vec pos;"
+    "       int mass;"
+    "   };"
+    "   void nudge(vec* v, int dx) {"
+    "       v->x = v->x + dx;"
+    "       (*v).y = (*v).y + 1;"
+    "   }"
+    "   int weigh(body* b) {"
+    "       b->pos.x *= 2;"
+    "       return b->mass + b->pos.x;"
+    "   }"
+    "   int main() {"
+    "       vec v;"
+    "       v.x = 1;"
+    "       v.y = 2;"
+    "       nudge(&v, 10);"
+    "       vec* p = &v;"
+    "       p->y += 4;"
+    "       body b;"
+    "       b.mass = 5;"
+    "       b.pos.x = 3;"
+    "       int w = weigh(&b);"
+    "       return v.x + v.y + w + b.pos.x;"
+    "   }"
+    "}";
+
+const char* test_array_params =
+    "namespace main {"
+    "   int total(int values[8], int n) {"
+    "       int sum = 0;"
+    "       for (int i = 0; i < n; i++) {"
+    "           sum = sum + values[i];"
+    "       }"
+    "       return sum;"
+    "   }"
+    "   void scale(int values[], int n, int k) {"
+    "       for (int i = 0; i < n; i++) {"
+    "           values[i] = values[i] * k;"
+    "       }"
+    "   }"
+    "   int forward(int values[8]) {"
+    "       return total(values, 8);"
+    "   }"
+    "   int main() {"
+    "       int data[8];"
+    "       for (int i = 0; i < 8; i++) {"
+    "           data[i] = i;"
+    "       }"
+    "       scale(data, 8, 2);"
+    "       int* p = data;"
+    "       return forward(data) + p[3];"
+    "   }"
+    "}";
+
+const char* test_multi_dim_arrays =
+    "namespace main {"
+    "   struct grid {"
+    "       int cells[3][3];"
+    "       int id;"
+    "   };"
+    "   int trace(int m[3][3]) {"
+    "       return m[0][0] + m[1][1] + m[2][2];"
+    "   }"
+    "   int main() {"
+    "       int m[3][3];"
+    "       for (int i = 0; i < 3; i++) {"
+    "           for (int j = 0; j < 3; j++) {"
+    "               m[i][j] = i * 3 + j;"
+    "           }"
+    "       }"
+    "       int cube[2][2][2];"
+    "       cube[1][0][1] = 7;"
+    "       grid g;"
+    "       g.cells[2][1] = 4;"
+    "       grid* gp = &g;"
+    "       gp->cells[0][2] = 5;"
+    "       return trace(m) + cube[1][0][1] + g.cells[2][1] + gp->cells[0][2];"
+    "   }"
+    "}";
+
+const char* test_bounds_check =
+    "namespace main {"
+    "   const int N = 6;"
+    "   int sum_prefix(int values[6], int n) {"
+    "       int total = 0;"
+    "       for (int i = 0; i < n; i++) {"
+    "           total += values[i];"
+    "       }"
+    "       return total;"
+    "   }"
+    "   int main() {"
+    "       int a[6];"
+    "       for (int i = 0; i < N; i++) {"
+    "           a[i] = i + 1;"
+    "       }"
+    "       int grid[2][3];"
+    "       for (int r = 0; r < 2; r++) {"
+    "           for (int c = 0; c <= 2; c++) {"
+    "               grid[r][c] = a[r * 3 + c];"
+    "           }"
+    "       }"
+    "       int k = 4;"
+    "       return sum_prefix(a, 5) + grid[1][2] + a[k];"
+    "   }"
+    "}";
+
+const char* test_session =
+    "namespace main {"
+    "   struct pair {"
+    "       int a;"
+    "       int b;"
+    "   };"
+    "   int main() {"
+    "       pair p;"
+    "       p.a = 20;"
+    "       p.b = 22;"
+    "       return p.a + p.b;"
+    "   }"
+    "}";
+
+const char* test_type_ids =
+    "namespace main {"
+    "   struct item {"
+    "       char tag;"
+    "       double weight;"
+    "       int count;"
+    "   };"
+    "   int weigh(item* it, int scale) {"
+    "       return it->count * scale + it->tag;"
+    "   }"
+    "   int main() {"
+    "       arena a = arena_new(8);"
+    "       char* tags = arena_alloc(a, char, 3);"
+    "       double* weights = arena_alloc(a, double, 4);"
+    "       int* counts = arena_alloc(a, int, 4);"
+    "       int sum = 0;"
+    "       for (int i = 0; i < 4; i++) {"
+    "           weights[i] = 0.5;"
+    "           counts[i] = i * 3;"
+    "           sum = sum + counts[i];"
+    "       }"
+    "       tags[0] = 2;"
+    "       item it;"
+    "       it.tag = tags[0];"
+    "       it.weight = weights[3];"
+    "       it.count = counts[3];"
+    "       int result = sum + weigh(&it, 2);"
+    "       arena_free(a);"
+    "       return result;"
+    "   }"
+    "}";
+
+// every chunk boundary has to land on a newline outside the comments and literals
+const char* test_parallel_lex =
+    "namespace main {\n"
+    "   /* a block comment with \"quotes\", // slashes\n"
+    "      and a ' spanning lines */\n"
+    "   int scale(int x) {\n"
+    "       return x * 3; // \"not a string\n"
+    "   }\n"
+    "   int main() {\n"
+    "       char* text = \"first line\n"
+    "second /* line\";\n"
+    "       char quote = '\"';\n"
+    "       char slash = '/';\n"
+    "       int total = 0;\n"
+    "       /* int total = 100;\n"
+    "          ' \" */\n"
+    "       for (int i = 0; i < 5; i++) {\n"
+    "           total += scale(i);\n"
+    "       }\n"
+    "       return total + slash - quote;\n"
+    "   }\n"
+    "}\n";
+
+// nested braces in every body, the skeleton scan has to find each closing one
+const char* test_parallel_parse =
+    "namespace main {"
+    "   struct pair {"
+    "       int a;"
+    "       int b;"
+    "   };"
+    "   int limit = 4;"
+    "   int sum_to(int n) {"
+    "       int total = 0;"
+    "       for (int i = 0; i < n; i++) {"
+    "           if (i % 2 == 0) { total += i; } else { total += 1; }"
+    "       }"
+    "       return total;"
+    "   }"
+    "   int swap_sum(pair* p) {"
+    "       int t = p->a;"
+    "       p->a = p->b;"
+    "       p->b = t;"
+    "       return p->a * 10 + p->b;"
+    "   }"
+    "   int countdown(int n) {"
+    "       while (n > limit) { n--; }"
+    "       return n;"
+    "   }"
+    "   int pick(int x) {"
+    "       return x > 3 ? x * 2 : x + 100;"
+    "   }"
+    "   void empty() {"
+    "   }"
+    "   int main() {"
+    "       pair p;"
+    "       p.a = 1;"
+    "       p.b = 2;"
+    "       { int inner = pick(5); p.a = p.a + inner - 10; }"
+    "       return sum_to(6) + swap_sum(&p) + countdown(9) + pick(1) - 100;"
+    "   }"
+    "}";
+
+// the unused functions would not compile, calling an undefined function
+const char* test_lazy_parse =
+    "namespace main {"
+    "   int twice(int x) {"
+    "       return x * 2;"
+    "   }"
+    "   int helper(int x) {"
+    "       return twice(x) + 1;"
+    "   }"
+    "   export int api(int x) {"
+    "       return helper(x);"
+    "   }"
+    "   int fact(int n) {"
+    "       if (n <= 1) { return 1; }"
+    "       return n * fact(n - 1);"
+    "   }"
+    "   int unused_leaf(int x) {"
+    "       return missing_function(x);"
+    "   }"
+    "   int unused_caller(int x) {"
+    "       return unused_leaf(x) + unused_caller(x - 1);"
+    "   }"
+    "   int unused_alone(int x) {"
+    "       return x;"
+    "   }"
+    "   int main() {"
+    "       return fact(4) - twice(3);"
+    "   }"
+    "}";
+
+// the target of a compound assignment is evaluated once, side effects included
+const char* test_compound_assign =
+    "namespace main {"
+    "   int calls = 0;"
+    "   int idx() {"
+    "       calls += 1;"
+    "       return 2;"
+    "   }"
+    "   int main() {"
+    "       int a[4];"
+    "       a[0] = 1;"
+    "       a[1] = 2;"
+    "       a[2] = 3;"
+    "       a[3] = 4;"
+    "       int i = 0;"
+    "       a[i++] += 10;"
+    "       a[idx()] += 100;"
+    "       a[i] *= 5;"
+    "       int ok = 0;"
+    "       ok += a[0] == 11 ? 1 : 0;"
+    "       ok += a[1] == 10 ? 2 : 0;"
+    "       ok += a[2] == 103 ? 4 : 0;"
+    "       ok += a[3] == 4 ? 8 : 0;"
+    "       ok += i == 1 ? 16 : 0;"
+    "       ok += calls == 1 ? 32 : 0;"
+    "       return ok;"
+    "   }"
+    "}";
+
+const char* test_static_extent =
+    "namespace main {"
+    "   int ends(int a[static 4]) {"
+    "       return a[0] + a[3];"
+    "   }"
+    "   int first(int a[4]) {"
+    "       return a[0];"
+    "   }"
+    "   int main() {"
+    "       int data[6];"
+    "       for (int i = 0; i < 6; i++) {"
+    "           data[i] = i + 1;"
+    "       }"
+    "       int small[2];"
+    "       small[0] = 7;"
+    "       return ends(data) + first(small);"
+    "   }"
+    "}";
+
+const char* test_static_extent_too_small =
+    "namespace main {"
+    "   int ends(int a[static 4]) {"
+    "       return a[0] + a[3];"
+    "   }"
+    "   int main() {"
+    "       int small[2];"
+    "       return ends(small);"
+    "   }"
+    "}";
+
+const char* const static_extent_ir[] = {
+    "@ends(i32* nonnull dereferenceable(16) %0)",
+    "@first(i32* %0)",
+    NULL
+};
+
+const char* test_vector_alignment =
+    "namespace main {"
+    "   float head(float values[8], int i) {"
+    "       float4 v = vload(float4, values, i);"
+    "       return v[0];"
+    "   }"
+    "   int main() {"
+    "       float data[8];"
+    "       for (int i = 0; i < 8; i++) {"
+    "           data[i] = (float) i;"
+    "       }"
+    "       float4 aligned = vload(float4, data, 4);"
+    "       float4 shifted = vload(float4, data, 2);"
+    "       vstore(data, 1, aligned);"
+    "       return (int) (aligned[0] + shifted[0] + data[1] + head(data, 3));"
+    "   }"
+    "}";
+
+const char* const vector_alignment_ir[] = {
+    "load <4 x float>, <4 x float>* %vector_ptr, align 4",
+    "load <4 x float>, <4 x float>* %vector_ptr, align 16",
+    "load <4 x float>, <4 x float>* %vector_ptr5, align 4",
+    "store <4 x float> %local_load7, <4 x float>* %vector_ptr9, align 4",
+    NULL
+};
+
+const char* test_print_doubles =
+    "namespace main {"
+    "   int main() {"
+    "       double a = 49.3712795d;"
+    "       double b = 12.7069665d;"
+    "       double c = 0.10489949999999999d;"
+    "       print(a, b, c);"
+    "       print(-0.0000005d, 2.5d, 0.9999995d);"
+    "       return 3;"
+    "   }"
+    "}";
+
+const char* test_invalid_int_width =
+    "namespace main {"
+    "   int main() {"
+    "       int65 wide = 1;"
+    "       return 0;"
+    "   }"
+    "}";
+
+const char* test_global_call_initializer =
+    "namespace main {"
+    "   int seed() {"
+    "       return 3;"
+    "   }"
+    "   int g = seed();"
+    "   int main() {"
+    "       return g;"
+    "   }"
+    "}";
+
+const char* test_const_address_escape =
+    "namespace main {"
+    "   int main() {"
+    "       const int k = 5;"
+    "       int* q = &k;"
+    "       *q = 11;"
+    "       return k;"
+    "   }"
+    "}";
+
+const char* test_const_pointer =
+    "namespace main {"
+    "   const int limit = 9;"
+    "   int read(const int* p) {"
+    "       return *p;"
+    "   }"
+    "   int main() {"
+    "       const int k = 5;"
+    "       const int* q = &k;"
+    "       return *q + read(&limit);"
+    "   }"
+    "}";
+
+const char* test_break_outside_loop =
+    "namespace main {"
+    "   int main() {"
+    "       int x = 1;"
+    "       if (x > 0) {"
+    "           break;"
+    "       }"
+    "       return x;"
+    "   }"
+    "}";
+
 const char* test_array =
     "namespace main {"
     "   int main() {"
@@ -314,35 +1055,87 @@ const char* test_array =
     "   }"
     "}";
     
+// one byte past what a token can hold, built at startup rather than spelled out
+static const char* build_oversized_string_source(void)
+{
+    const char* head = "namespace main { int main() { char* s = \"";
+    const char* tail = "\"; return 0; } }";
+    size_t literal_length = (size_t)MAX_TOKEN_LENGTH + 1;
+
+    char* source = malloc(strlen(head) + literal_length + strlen(tail) + 1);
+    if (source == NULL)
+        return "";
+
+    char* cursor = source;
+    cursor += sprintf(cursor, "%s", head);
+    memset(cursor, 'a', literal_length);
+    cursor += literal_length;
+    sprintf(cursor, "%s", tail);
+    return source;
+}
+
 TestCase tests[TESTS_BUFFER];
 
 void init_tests() {
-    tests[0] = (TestCase){"variables", test_variables, 10};
-    tests[1] = (TestCase){"pointers", test_pointers, 15};
-    tests[2] = (TestCase){"pointer_function_param", test_pointer_function_param, 10};
-    tests[3] = (TestCase){"casting", test_casting, 3};
-    tests[4] = (TestCase){"casting_pointer", test_casting_pointer, 5};
-    tests[5] = (TestCase){"nested_functions", test_nested_functions, 4};
-    tests[6] = (TestCase){"arithmetic", test_arithmetic, 18};
-    tests[7] = (TestCase){"equality", test_equality, 5};
-    tests[8] = (TestCase){"conditions", test_conditions, 1};
-    tests[9] = (TestCase){"less_greater", test_less_greater, 2};
-    tests[10] =(TestCase){"negative", test_negative_numbers, 150};
-    tests[11] =(TestCase){"for_loop", test_for_loops, 6};
-    tests[12] =(TestCase){"while_loop", test_while_loops, 4};
-    tests[13] =(TestCase){"less_greater_equals", test_less_greater_equals, 3};
-    tests[14] =(TestCase){"scopes", test_scopes, 8};
-    tests[15] =(TestCase){"comments", test_comments, 2};
-    tests[16] =(TestCase){"compound_operators", test_compound_operators, 16};
-    tests[17] =(TestCase){"struct", test_struct, 40};
-    tests[18] =(TestCase){"string_literal", test_string_literal, 5};
-    tests[19] =(TestCase){"inc_dec", test_inc_dec, 5};
-    tests[20] =(TestCase){"access_member", test_access_member, 10};
-    // tests[21] =(TestCase){"print", test_print, 1};
-    tests[22] =(TestCase){"array", test_array, 2};
+    tests[0] = (TestCase){ .name = "variables", .source = test_variables, .expected = 10 };
+    tests[1] = (TestCase){ .name = "pointers", .source = test_pointers, .expected = 15 };
+    tests[2] = (TestCase){ .name = "pointer_function_param", .source = test_pointer_function_param, .expected = 10 };
+    tests[3] = (TestCase){ .name = "casting", .source = test_casting, .expected = 3 };
+    tests[4] = (TestCase){ .name = "casting_pointer", .source = test_casting_pointer, .expected = 5 };
+    tests[5] = (TestCase){ .name = "nested_functions", .source = test_nested_functions, .expected = 4 };
+    tests[6] = (TestCase){ .name = "arithmetic", .source = test_arithmetic, .expected = 18 };
+    tests[7] = (TestCase){ .name = "equality", .source = test_equality, .expected = 5 };
+    tests[8] = (TestCase){ .name = "conditions", .source = test_conditions, .expected = 1 };
+    tests[9] = (TestCase){ .name = "less_greater", .source = test_less_greater, .expected = 2 };
+    tests[10] = (TestCase){ .name = "negative", .source = test_negative_numbers, .expected = 150 };
+    tests[11] = (TestCase){ .name = "for_loop", .source = test_for_loops, .expected = 6 };
+    tests[12] = (TestCase){ .name = "while_loop", .source = test_while_loops, .expected = 4 };
+    tests[13] = (TestCase){ .name = "less_greater_equals", .source = test_less_greater_equals, .expected = 3 };
+    tests[14] = (TestCase){ .name = "scopes", .source = test_scopes, .expected = 8 };
+    tests[15] = (TestCase){ .name = "comments", .source = test_comments, .expected = 2 };
+    tests[16] = (TestCase){ .name = "compound_operators", .source = test_compound_operators, .expected = 16 };
+    tests[17] = (TestCase){ .name = "struct", .source = test_struct, .expected = 40 };
+    tests[18] = (TestCase){ .name = "string_literal", .source = test_string_literal, .expected = 5 };
+    tests[19] = (TestCase){ .name = "inc_dec", .source = test_inc_dec, .expected = 5 };
+    tests[20] = (TestCase){ .name = "access_member", .source = test_access_member, .expected = 10 };
+    tests[21] = (TestCase){ .name = "print", .source = test_print, .expected = 1 };
+    tests[22] = (TestCase){ .name = "array", .source = test_array, .expected = 2 };
+    tests[23] = (TestCase){ .name = "print_multiple", .source = test_print_multiple, .expected = 7 };
+    tests[24] = (TestCase){ .name = "unsigned", .source = test_unsigned, .expected = 46 };
+    tests[25] = (TestCase){ .name = "sized_integers", .source = test_sized_integers, .expected = 22 };
+    tests[26] = (TestCase){ .name = "vectors", .source = test_vectors, .expected = 37 };
+    tests[27] = (TestCase){ .name = "loop_hints", .source = test_loop_hints, .expected = 28, .ir_checks = loop_hints_ir };
+    tests[28] = (TestCase){ .name = "function_qualifiers", .source = test_function_qualifiers, .expected = 23, .ir_checks = function_qualifiers_ir };
+    tests[29] = (TestCase){ .name = "restrict", .source = test_restrict, .expected = 12, .ir_checks = restrict_ir };
+    tests[30] = (TestCase){ .name = "visibility", .source = test_visibility, .expected = 31, .ir_checks = visibility_ir };
+    tests[31] = (TestCase){ .name = "conditional_logic", .source = test_conditional_logic, .expected = 16 };
+    tests[32] = (TestCase){ .name = "break_continue", .source = test_break_continue, .expected = 34 };
+    tests[33] = (TestCase){ .name = "arena", .source = test_arena, .expected = 183 };
+    tests[34] = (TestCase){ .name = "struct_pointers", .source = test_struct_pointers, .expected = 35 };
+    tests[35] = (TestCase){ .name = "array_params", .source = test_array_params, .expected = 62 };
+    tests[36] = (TestCase){ .name = "multi_dim_arrays", .source = test_multi_dim_arrays, .expected = 28 };
+    tests[37] = (TestCase){ .name = "bounds_check", .source = test_bounds_check, .expected = 26, .options = { .bounds_check = 1 } };
+    tests[38] = (TestCase){ .name = "session", .source = test_session, .expected = 42, .from_memory = 1 };
+    tests[39] = (TestCase){ .name = "type_ids", .source = test_type_ids, .expected = 38 };
+    tests[40] = (TestCase){ .name = "parallel_lex", .source = test_parallel_lex, .expected = 43, .lex_threads = 12 };
+    tests[41] = (TestCase){ .name = "parallel_parse", .source = test_parallel_parse, .expected = 35, .parse_threads = 4 };
+    tests[42] = (TestCase){ .name = "lazy_parse", .source = test_lazy_parse, .expected = 318, .lazy_parse = 1 };
+    tests[43] = (TestCase){ .name = "compound_assign", .source = test_compound_assign, .expected = 63 };
+    tests[44] = (TestCase){ .name = "static_extent", .source = test_static_extent, .expected = 12, .ir_checks = static_extent_ir };
+    tests[45] = (TestCase){ .name = "vector_alignment", .source = test_vector_alignment, .expected = 16, .ir_checks = vector_alignment_ir };
+    tests[46] = (TestCase){ .name = "print_doubles", .source = test_print_doubles, .expected = 3,
+        .expected_output = "49.371279 12.706967 0.104899\n-0.000000 2.500000 1.000000\n" };
+    tests[47] = (TestCase){ .name = "invalid_int_width", .source = test_invalid_int_width, .expected = 1, .rejected = 1 };
+    tests[48] = (TestCase){ .name = "static_extent_too_small", .source = test_static_extent_too_small, .expected = 1, .rejected = 1 };
+    tests[49] = (TestCase){ .name = "global_call_initializer", .source = test_global_call_initializer, .expected = 1, .rejected = 1 };
+    tests[50] = (TestCase){ .name = "const_address_escape", .source = test_const_address_escape, .expected = 1, .rejected = 1 };
+    tests[51] = (TestCase){ .name = "const_pointer", .source = test_const_pointer, .expected = 14 };
+    tests[52] = (TestCase){ .name = "break_outside_loop", .source = test_break_outside_loop, .expected = 1, .rejected = 1 };
+    tests[53] = (TestCase){ .name = "arena_invalid_count", .source = test_arena_invalid_count, .expected = 10 };
+    tests[54] = (TestCase){ .name = "oversized_token", .source = build_oversized_string_source(), .expected = 1, .rejected = 1 };
 }
 
-int run_test(const char* test) 
+int run_test(const char* test, const CodegenOptions* options) 
 {
     Lexer lexer;
     Tokens* tokens = tokenize(&lexer, test, 1);
@@ -358,15 +1151,326 @@ int run_test(const char* test)
 
     print_ast(root, 0);
 
-    generate_llvm_ir_visitor(root, "main", "output.ll");
+    generate_llvm_ir_visitor(root, "main", "output.ll", options);
     free_ast(root);
 
     return run_llvm_and_get_exit_code("output.ll");
 }
 
+// compiles twice through one session to catch state leaking between compiles, a broken program must only add diagnostics
+// a session compile interns into its own type table, the process one must not grow
+int run_session_test(const char* test, const CodegenOptions* options)
+{
+    EuclaseSession* session = euclase_session_create(options);
+    if (session == NULL)
+        return -1;
+
+    int process_types = get_type_count();
+
+    const char* broken = "namespace main { int main() { return 1 +; } }";
+    EuclaseResult* failed = euclase_compile(session, "main", broken, strlen(broken), EUCLASE_OUTPUT_BITCODE);
+    int rejected = failed != NULL && !failed->ok && failed->diagnostic_count > 0;
+    euclase_result_free(failed);
+
+    EuclaseResult* first = euclase_compile(session, "main", test, strlen(test), EUCLASE_OUTPUT_MODULE);
+    EuclaseResult* second = euclase_compile(session, "main", test, strlen(test), EUCLASE_OUTPUT_BITCODE);
+
+    int exit_code = -1;
+    if (rejected && first != NULL && first->ok && second != NULL && second->ok) {
+        FILE* out = fopen("output.bc", "wb");
+        if (out != NULL) {
+            fwrite(LLVMGetBufferStart(second->output), 1, LLVMGetBufferSize(second->output), out);
+            fclose(out);
+            exit_code = run_llvm_and_get_exit_code("output.bc");
+        }
+    }
+
+    euclase_result_free(first);
+    euclase_result_free(second);
+    euclase_session_destroy(session);
+    if (get_type_count() != process_types)
+        return -2;
+    return exit_code;
+}
+
+int run_rejected_test(const char* test, const CodegenOptions* options)
+{
+    EuclaseSession* session = euclase_session_create(options);
+    if (session == NULL)
+        return -1;
+
+    EuclaseResult* result = euclase_compile(session, "main", test, strlen(test), EUCLASE_OUTPUT_MODULE);
+    int rejected = result != NULL && !result->ok && result->diagnostic_count > 0;
+    if (result != NULL && result->diagnostics != NULL)
+        printf("%s", result->diagnostics);
+
+    euclase_result_free(result);
+    euclase_session_destroy(session);
+    return rejected;
+}
+
+// the parallel token stream and line table must match the serial ones exactly before the program is run
+int run_parallel_lex_test(const char* test, int thread_count, const CodegenOptions* options)
+{
+    Lexer lexer;
+    Tokens* serial = tokenize(&lexer, test, 0);
+    cleanup_lexer(&lexer);
+    Tokens* tokens = tokenize_parallel(test, thread_count, 1);
+    if (serial == NULL || tokens == NULL) {
+        free_tokens(serial);
+        free_tokens(tokens);
+        return -1;
+    }
+
+    int same = serial->token_count == tokens->token_count && serial->lines.count == tokens->lines.count
+        && memcmp(serial->tokens, tokens->tokens, sizeof(Token) * serial->token_count) == 0
+        && memcmp(serial->lines.starts, tokens->lines.starts, sizeof(uint32_t) * serial->lines.count) == 0;
+    free_tokens(serial);
+    if (!same) {
+        free_tokens(tokens);
+        return -2;
+    }
+
+    Parser parser;
+    init_parser(&parser, tokens);
+
+    ASTNode* root = parse_program(&parser);
+    if (root == NULL)
+        return -1;
+
+    generate_llvm_ir_visitor(root, "main", "output.ll", options);
+    free_ast(root);
+
+    return run_llvm_and_get_exit_code("output.ll");
+}
+
+typedef struct AstChildList {
+    ASTNode** nodes;
+    int count;
+    int capacity;
+} AstChildList;
+
+static void collect_ast_child(ASTNode* child, void* data)
+{
+    AstChildList* list = data;
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 8 : list->capacity * 2;
+        list->nodes = realloc(list->nodes, sizeof(ASTNode*) * list->capacity);
+    }
+    list->nodes[list->count++] = child;
+}
+
+static int same_name(const char* a, const char* b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static int same_hints(LoopHints a, LoopHints b)
+{
+    return a.unroll_count == b.unroll_count && a.vectorize_width == b.vectorize_width
+        && a.interleave_count == b.interleave_count;
+}
+
+// the payload of a node without its children, types are compared by TypeId since both parses intern into one table
+static int same_node_fields(ASTNode* a, ASTNode* b)
+{
+    switch (a->type) {
+        case AST_PROGRAM:
+            return same_name(a->as.program.name, b->as.program.name);
+        case AST_FUNCTION:
+            return same_name(a->as.function.name, b->as.function.name)
+                && a->as.function.return_type == b->as.function.return_type
+                && a->as.function.qualifiers == b->as.function.qualifiers;
+        case AST_PARAM_LIST:
+            return same_name(a->as.param.name, b->as.param.name) && a->as.param.type == b->as.param.type;
+        case AST_STRUCT_DECL:
+            return same_name(a->as.struct_decl.type, b->as.struct_decl.type);
+        case AST_VAR_DECL:
+            return same_name(a->as.var_decl.name, b->as.var_decl.name)
+                && a->as.var_decl.type == b->as.var_decl.type
+                && a->as.var_decl.is_exported == b->as.var_decl.is_exported;
+        case AST_ASSIGN:
+            return a->as.assign.is_compound == b->as.assign.is_compound
+                && (!a->as.assign.is_compound || a->as.assign.op == b->as.assign.op);
+        case AST_FOR:
+            return same_hints(a->as.for_stmt.hints, b->as.for_stmt.hints);
+        case AST_WHILE:
+            return same_hints(a->as.while_stmt.hints, b->as.while_stmt.hints);
+        case AST_IDENTIFIER:
+            return same_name(a->as.identifier.name, b->as.identifier.name);
+        case AST_FUNC_CALL:
+            return same_name(a->as.func_call.name, b->as.func_call.name);
+        case AST_MEMBER_ACCESS:
+            return same_name(a->as.member_access.member, b->as.member_access.member);
+        case AST_UNARY_OP:
+            return a->as.unary_op.op == b->as.unary_op.op;
+        case AST_BINARY_OP:
+            return a->as.binary_op.op == b->as.binary_op.op;
+        case AST_CAST:
+            return a->as.cast.target_type == b->as.cast.target_type;
+        case AST_TYPE:
+            return a->as.type_arg.type == b->as.type_arg.type;
+        case AST_INT_LITERAL:
+            return a->as.int_literal.value == b->as.int_literal.value
+                && a->as.int_literal.is_unsigned == b->as.int_literal.is_unsigned;
+        case AST_FLOAT_LITERAL:
+            return memcmp(&a->as.float_literal.value, &b->as.float_literal.value, sizeof(float)) == 0;
+        case AST_DOUBLE_LITERAL:
+            return memcmp(&a->as.double_literal.value, &b->as.double_literal.value, sizeof(double)) == 0;
+        case AST_CHAR_LITERAL:
+            return a->as.char_literal.value == b->as.char_literal.value;
+        case AST_STRING_LITERAL:
+            return a->as.string_literal.length == b->as.string_literal.length
+                && memcmp(a->as.string_literal.value, b->as.string_literal.value, a->as.string_literal.length) == 0;
+        default:
+            return 1;
+    }
+}
+
+static int same_ast(ASTNode* a, ASTNode* b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    if (a->type != b->type || a->offset != b->offset || !same_node_fields(a, b))
+        return 0;
+
+    AstChildList left = { 0 };
+    AstChildList right = { 0 };
+    visit_ast_children(a, collect_ast_child, &left);
+    visit_ast_children(b, collect_ast_child, &right);
+
+    int same = left.count == right.count;
+    for (int i = 0; same && i < left.count; i++)
+        same = same_ast(left.nodes[i], right.nodes[i]);
+
+    free(left.nodes);
+    free(right.nodes);
+    return same;
+}
+
+// a broken body has to send the parallel parse back to the serial one with the same error count
+int run_parallel_parse_test(const char* test, int thread_count, const CodegenOptions* options)
+{
+    const char* broken = "namespace main { int f() { return 1 +; } int main() { return 0; } }";
+    Lexer lexer;
+    Tokens* broken_tokens = tokenize(&lexer, broken, 0);
+    Parser serial_parser;
+    init_parser(&serial_parser, broken_tokens);
+    free_ast(parse_program(&serial_parser));
+    Parser parallel_parser;
+    init_parser(&parallel_parser, broken_tokens);
+    free_ast(parse_program_parallel(&parallel_parser, thread_count));
+    free_tokens(broken_tokens);
+    if (serial_parser.error_count == 0 || parallel_parser.error_count != serial_parser.error_count)
+        return -3;
+
+    Tokens* tokens = tokenize(&lexer, test, 1);
+    cleanup_lexer(&lexer);
+
+    Parser parser;
+    init_parser(&parser, tokens);
+    ASTNode* serial = parse_program(&parser);
+
+    init_parser(&parser, tokens);
+    ASTNode* root = parse_program_parallel(&parser, thread_count);
+    if (serial == NULL || root == NULL) {
+        free_ast(serial);
+        free_ast(root);
+        return -1;
+    }
+
+    int same = same_ast(serial, root);
+    free_ast(serial);
+    if (!same) {
+        free_ast(root);
+        return -2;
+    }
+
+    print_ast(root, 0);
+
+    generate_llvm_ir_visitor(root, "main", "output.ll", options);
+    free_ast(root);
+
+    return run_llvm_and_get_exit_code("output.ll");
+}
+
+int run_lazy_parse_test(const char* test, const CodegenOptions* options)
+{
+    Lexer lexer;
+    Tokens* tokens = tokenize(&lexer, test, 1);
+    cleanup_lexer(&lexer);
+
+    int skipped = compile_stats.skipped_functions;
+    Parser parser;
+    init_parser(&parser, tokens);
+    ASTNode* root = parse_program_reachable(&parser);
+    if (root == NULL || parser.error_count > 0)
+        return -1;
+    skipped = compile_stats.skipped_functions - skipped;
+
+    print_ast(root, 0);
+
+    generate_llvm_ir_visitor(root, "main", "output.ll", options);
+    free_ast(root);
+
+    return run_llvm_and_get_exit_code("output.ll") + 100 * skipped;
+}
+
+// returns the first check output.ll fails, NULL when all of them hold
+static const char* check_ir(const char* filename, const char* const* checks)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return checks[0];
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* ir = malloc(size + 1);
+    size_t read = ir != NULL ? fread(ir, 1, size, file) : 0;
+    fclose(file);
+    if (ir == NULL)
+        return checks[0];
+    ir[read] = '\0';
+
+    const char* failed = NULL;
+    for (int i = 0; checks[i] != NULL && failed == NULL; i++) {
+        int negated = checks[i][0] == '!';
+        int found = strstr(ir, checks[i] + negated) != NULL;
+        if (found == negated)
+            failed = checks[i];
+    }
+
+    free(ir);
+    return failed;
+}
+
+// runs the program again with stdout captured, the first run already checked the exit code
+static int check_output(const char* filename, const char* expected)
+{
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "lli -load=%s %s", EUCLASE_RUNTIME_PATH, filename);
+    FILE* program = popen(cmd, "r");
+    if (program == NULL)
+        return 0;
+
+    char output[4096];
+    size_t length = fread(output, 1, sizeof(output) - 1, program);
+    output[length] = '\0';
+    pclose(program);
+
+    if (strcmp(output, expected) == 0)
+        return 1;
+
+    printf("Output mismatch, got:\n%s\nexpected:\n%s\n", output, expected);
+    return 0;
+}
+
 int run_llvm_and_get_exit_code(const char* filename) {
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd), "lli %s", filename);
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "lli -load=%s %s", EUCLASE_RUNTIME_PATH, filename);
     int ret = system(cmd);
     return WEXITSTATUS(ret);
 }
@@ -379,7 +1483,27 @@ void run_tests() {
         if(tests[i].name == NULL)
             continue;
 
-        results[i] = run_test(tests[i].source);
+        if (tests[i].rejected)
+            results[i] = run_rejected_test(tests[i].source, &tests[i].options);
+        else if (tests[i].from_memory)
+            results[i] = run_session_test(tests[i].source, &tests[i].options);
+        else if (tests[i].lex_threads > 0)
+            results[i] = run_parallel_lex_test(tests[i].source, tests[i].lex_threads, &tests[i].options);
+        else if (tests[i].parse_threads > 0)
+            results[i] = run_parallel_parse_test(tests[i].source, tests[i].parse_threads, &tests[i].options);
+        else if (tests[i].lazy_parse)
+            results[i] = run_lazy_parse_test(tests[i].source, &tests[i].options);
+        else
+            results[i] = run_test(tests[i].source, &tests[i].options);
+
+        const char* failed_check = tests[i].ir_checks != NULL ? check_ir("output.ll", tests[i].ir_checks) : NULL;
+        if (failed_check != NULL) {
+            printf("IR check failed for %s: %s\n", tests[i].name, failed_check);
+            results[i] = -4;
+        }
+
+        if (tests[i].expected_output != NULL && !check_output("output.ll", tests[i].expected_output))
+            results[i] = -5;
     }
 
     for(int i = 0; i < TESTS_BUFFER; i++) {
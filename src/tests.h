@@ -1,19 +1,41 @@
 #ifndef TESTS_H
 #define TESTS_H
 
-#define TESTS_BUFFER 25
+#include "codegen_visitor.h"
+
+#define TESTS_BUFFER 64
 
 typedef struct {
     const char* name;
     const char* source;
     int expected;
+    CodegenOptions options;
+    // compiled through an EuclaseSession instead of the file based path
+    int from_memory;
+    // lexed on this many threads and checked against the serial token stream
+    int lex_threads;
+    // bodies parsed on this many threads, the tree must match the serial parse node for node
+    int parse_threads;
+    // parsed with parse_program_reachable, the result is the exit code plus 100 per skipped function
+    int lazy_parse;
+    // NULL terminated strings output.ll must contain, a leading '!' marks one it must not
+    const char* const* ir_checks;
+    // exact stdout the program must print, checked on top of the exit code
+    const char* expected_output;
+    // the program must fail to compile with a diagnostic, the result is 1 when it did
+    int rejected;
 } TestCase;
 
 extern TestCase tests[TESTS_BUFFER];
 
 void init_tests();
 void run_tests();
-int run_test(const char* test);
+int run_test(const char* test, const CodegenOptions* options);
+int run_session_test(const char* test, const CodegenOptions* options);
+int run_rejected_test(const char* test, const CodegenOptions* options);
+int run_parallel_lex_test(const char* test, int thread_count, const CodegenOptions* options);
+int run_parallel_parse_test(const char* test, int thread_count, const CodegenOptions* options);
+int run_lazy_parse_test(const char* test, const CodegenOptions* options);
 int run_llvm_and_get_exit_code(const char* filename);
 
 
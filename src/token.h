@@ -2,6 +2,7 @@
 #define TOKEN_H
 
 #include "string_view.h"
+#include <stdint.h>
 
 typedef enum {
     TOK_LBRACE, 
@@ -12,6 +13,7 @@ typedef enum {
     TOK_RBRACKET,
     TOK_COMMA,
     TOK_DOT,
+    TOK_ARROW,
     TOK_SEMICOLON,
     TOK_ASSIGNMENT,
     TOK_AMPERSAND,
@@ -31,11 +33,14 @@ typedef enum {
     TOK_UDOUBLE,
     TOK_CHAR,
     TOK_UCHAR,
+    TOK_ARENA,
     TOK_IF,
     TOK_ELSE,
     TOK_FOR,
     TOK_WHILE,
     TOK_STRUCT,
+    TOK_BREAK,
+    TOK_CONTINUE,
 
     TOK_STRING_LITERAL,
     TOK_CHAR_LITERAL,
@@ -55,6 +60,12 @@ typedef enum {
     TOK_EQUAL,
     TOK_NOT_EQUAL,
 
+    TOK_AND,
+    TOK_OR,
+    TOK_NOT,
+    TOK_QUESTION,
+    TOK_COLON,
+
     TOK_IDENTIFIER,
     TOK_NUMBER_INT,
     TOK_NUMBER_FLOAT,
@@ -67,22 +78,43 @@ typedef enum {
     TOK_NONE,
     TOK_ERROR,
 
-    TOK_PRINT
+    TOK_PRINT,
+
+    TOK_CONST,
+    TOK_RESTRICT,
+    TOK_EXPORT,
 
+    TOK_COUNT
 } TokenType;
 
+#define MAX_TOKEN_LENGTH ((1u << 24) - 1)
+
+// 8 bytes, the lexeme is recovered from the source and the position from the line table
 typedef struct Token {
-    TokenType type;
-    StringView lexeme;
+    uint32_t offset;
+    uint32_t type : 8;
+    uint32_t length : 24;
+} Token;
 
+// byte offset where every line starts, starts[0] is always 0
+typedef struct LineTable {
+    uint32_t* starts;
+    int count;
+    int capacity;
+} LineTable;
+
+typedef struct SourceLocation {
     int line;
     int column;
-} Token;
+} SourceLocation;
 
 typedef struct Tokens {
     Token* tokens;
     int token_count;
     int capacity;
+
+    const char* source;
+    LineTable lines;
 } Tokens;
 
 #endif
\ No newline at end of file
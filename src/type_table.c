@@ -0,0 +1,214 @@
+#include "type_table.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// entries live in fixed chunks that never move, so lookups by id need no lock
+// id 0 (TYPE_ID_NONE) is a zeroed entry in the first chunk
+struct TypeTable {
+    TypeInfo* chunks[TYPE_TABLE_MAX_CHUNKS];
+    uint32_t count;
+
+    // open addressing over ids, 0 marks an empty slot
+    TypeId* slots;
+    size_t slot_capacity;
+
+    pthread_mutex_t lock;
+};
+
+// the CLI and the tests compile one program at a time and never free their types
+static TypeInfo process_first_chunk[TYPE_TABLE_CHUNK_SIZE];
+static TypeTable process_type_table = {
+    .chunks = { process_first_chunk },
+    .count = 1,
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static _Thread_local TypeTable* current_type_table = NULL;
+
+static TypeTable* active_type_table(void)
+{
+    return current_type_table != NULL ? current_type_table : &process_type_table;
+}
+
+TypeTable* create_type_table(void)
+{
+    TypeTable* table = calloc(1, sizeof(TypeTable));
+    if (table == NULL)
+        return NULL;
+
+    table->chunks[0] = calloc(TYPE_TABLE_CHUNK_SIZE, sizeof(TypeInfo));
+    if (table->chunks[0] == NULL) {
+        free(table);
+        return NULL;
+    }
+
+    table->count = 1;
+    pthread_mutex_init(&table->lock, NULL);
+    return table;
+}
+
+void free_type_table(TypeTable* table)
+{
+    if (table == NULL || table == &process_type_table)
+        return;
+
+    for (uint32_t id = 1; id < table->count; id++)
+        free(table->chunks[id / TYPE_TABLE_CHUNK_SIZE][id % TYPE_TABLE_CHUNK_SIZE].type);
+    for (int i = 0; i < TYPE_TABLE_MAX_CHUNKS && table->chunks[i] != NULL; i++)
+        free(table->chunks[i]);
+
+    free(table->slots);
+    pthread_mutex_destroy(&table->lock);
+    free(table);
+}
+
+TypeTable* set_current_type_table(TypeTable* table)
+{
+    TypeTable* previous = current_type_table;
+    current_type_table = table;
+    return previous;
+}
+
+TypeTable* get_current_type_table(void)
+{
+    return current_type_table;
+}
+
+static size_t hash_type(const TypeInfo* info)
+{
+    size_t hash = 1469598103934665603ull;
+    const int fields[] = {
+        info->base_type, info->pointer_level, info->is_unsigned, info->bit_width, info->vector_width,
+        info->is_restrict, info->is_const, info->is_array, info->array_dim_count, info->is_decayed,
+        info->has_static_extent
+    };
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        hash = (hash ^ (size_t)fields[i]) * 1099511628211ull;
+
+    for (int i = 0; i < info->array_dim_count; i++)
+        hash = (hash ^ (size_t)info->array_sizes[i]) * 1099511628211ull;
+
+    for (const char* c = info->type; c != NULL && *c != '\0'; c++)
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+
+    return hash;
+}
+
+static int types_equal(const TypeInfo* a, const TypeInfo* b)
+{
+    if (a->base_type != b->base_type || a->pointer_level != b->pointer_level || a->is_unsigned != b->is_unsigned
+        || a->bit_width != b->bit_width || a->vector_width != b->vector_width || a->is_restrict != b->is_restrict
+        || a->is_const != b->is_const || a->is_array != b->is_array || a->array_dim_count != b->array_dim_count
+        || a->is_decayed != b->is_decayed || a->has_static_extent != b->has_static_extent)
+        return 0;
+
+    for (int i = 0; i < a->array_dim_count; i++) {
+        if (a->array_sizes[i] != b->array_sizes[i])
+            return 0;
+    }
+
+    if (a->type == NULL || b->type == NULL)
+        return a->type == b->type;
+    return strcmp(a->type, b->type) == 0;
+}
+
+static const TypeInfo* table_entry(const TypeTable* table, TypeId id)
+{
+    return &table->chunks[id / TYPE_TABLE_CHUNK_SIZE][id % TYPE_TABLE_CHUNK_SIZE];
+}
+
+const TypeInfo* get_type_info(TypeId id)
+{
+    return table_entry(active_type_table(), id);
+}
+
+int get_type_count(void)
+{
+    TypeTable* table = active_type_table();
+    pthread_mutex_lock(&table->lock);
+    int count = (int)table->count - 1;
+    pthread_mutex_unlock(&table->lock);
+    return count;
+}
+
+static int grow_type_slots(TypeTable* table)
+{
+    size_t capacity = table->slot_capacity == 0 ? 256 : table->slot_capacity * 2;
+    TypeId* slots = calloc(capacity, sizeof(TypeId));
+    if (slots == NULL)
+        return 0;
+
+    for (size_t i = 0; i < table->slot_capacity; i++) {
+        TypeId id = table->slots[i];
+        if (id == TYPE_ID_NONE)
+            continue;
+
+        size_t slot = hash_type(table_entry(table, id)) & (capacity - 1);
+        while (slots[slot] != TYPE_ID_NONE)
+            slot = (slot + 1) & (capacity - 1);
+        slots[slot] = id;
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->slot_capacity = capacity;
+    return 1;
+}
+
+static TypeId append_type(TypeTable* table, const TypeInfo* info)
+{
+    uint32_t chunk = table->count / TYPE_TABLE_CHUNK_SIZE;
+    if (chunk >= TYPE_TABLE_MAX_CHUNKS)
+        return TYPE_ID_NONE;
+
+    if (table->chunks[chunk] == NULL) {
+        table->chunks[chunk] = calloc(TYPE_TABLE_CHUNK_SIZE, sizeof(TypeInfo));
+        if (table->chunks[chunk] == NULL)
+            return TYPE_ID_NONE;
+    }
+
+    char* name = NULL;
+    if (info->type != NULL) {
+        name = strdup(info->type);
+        if (name == NULL)
+            return TYPE_ID_NONE;
+    }
+
+    TypeInfo* entry = &table->chunks[chunk][table->count % TYPE_TABLE_CHUNK_SIZE];
+    *entry = *info;
+    memset(entry->array_sizes + info->array_dim_count, 0, sizeof(int) * (MAX_ARRAY_DIMS - info->array_dim_count));
+    entry->type = name;
+
+    return table->count++;
+}
+
+TypeId intern_type(const TypeInfo* info)
+{
+    TypeTable* table = active_type_table();
+    pthread_mutex_lock(&table->lock);
+
+    // keep the load factor at or below one half
+    if ((table->count + 1) * 2 > table->slot_capacity && !grow_type_slots(table)) {
+        pthread_mutex_unlock(&table->lock);
+        return TYPE_ID_NONE;
+    }
+
+    size_t slot = hash_type(info) & (table->slot_capacity - 1);
+    while (table->slots[slot] != TYPE_ID_NONE) {
+        if (types_equal(table_entry(table, table->slots[slot]), info)) {
+            TypeId id = table->slots[slot];
+            pthread_mutex_unlock(&table->lock);
+            return id;
+        }
+        slot = (slot + 1) & (table->slot_capacity - 1);
+    }
+
+    TypeId id = append_type(table, info);
+    if (id != TYPE_ID_NONE)
+        table->slots[slot] = id;
+
+    pthread_mutex_unlock(&table->lock);
+    return id;
+}
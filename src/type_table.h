@@ -0,0 +1,27 @@
+#ifndef TYPE_TABLE_H
+#define TYPE_TABLE_H
+
+#include "ast_layout.h"
+
+// every distinct TypeInfo is stored once per table and named by its TypeId
+#define TYPE_ID_NONE 0
+#define TYPE_TABLE_CHUNK_SIZE 1024
+#define TYPE_TABLE_MAX_CHUNKS 4096
+
+typedef struct TypeTable TypeTable;
+
+// a compile that installs its own table frees every type it interned with it, see euclase_compile
+TypeTable* create_type_table(void);
+void free_type_table(TypeTable* table);
+
+// intern_type and get_type_info use the table installed on the calling thread, NULL selects the process wide one
+TypeTable* set_current_type_table(TypeTable* table);
+TypeTable* get_current_type_table(void);
+
+// copies info, including the type name, the table keeps it until it is freed
+// returns TYPE_ID_NONE when the table is full or out of memory
+TypeId intern_type(const TypeInfo* info);
+const TypeInfo* get_type_info(TypeId id);
+int get_type_count(void);
+
+#endif